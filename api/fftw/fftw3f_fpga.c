@@ -0,0 +1,277 @@
+// Author: Arjun Ramaswami
+
+/**
+ * FFTW3 compatible shim: exports the single precision complex planner and
+ * execution functions of FFTW, routes the supported shapes to fftfpgaf_c2c
+ * and forwards everything else to the FFTW library found next in the symbol
+ * lookup order. Plans of the planners that are not intercepted, such as the
+ * real-data and guru ones, are recognized by the missing tag of the plans of
+ * this library and passed to FFTW unchanged. Link it before libfftw3f or
+ * load it with LD_PRELOAD.
+ *
+ * Environment variables:
+ *   FFTFPGA_BITSTREAM : path to the bitstream, required to offload
+ *   FFTFPGA_PLATFORM  : name of the OpenCL platform
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <fftw3.h>
+
+#include "fftfpga/fftfpga.h"
+
+#define DEFAULT_PLATFORM "Intel(R) FPGA SDK for OpenCL(TM)"
+
+// Tag of the plans of the library, not a valid address so that it cannot be
+// the first member of a plan of FFTW, which is a pointer
+#define SHIM_PLAN_MAGIC 0xFFF7F7A0FF7F7A0FULL
+
+/**
+ * Plan returned to the application, either an offloaded transform or a plan of FFTW
+ */
+typedef struct {
+  unsigned long long magic;
+  bool on_fpga;
+  fftwf_plan real;
+  unsigned dim;
+  unsigned N;
+  unsigned how_many;
+  bool inv;
+  fftwf_complex *in;
+  fftwf_complex *out;
+} shim_plan_t;
+
+typedef fftwf_plan (*plan_many_fn)(int, const int*, int, fftwf_complex*, const int*, int, int, fftwf_complex*, const int*, int, int, int, unsigned);
+typedef void (*execute_fn)(const fftwf_plan);
+typedef void (*execute_dft_fn)(const fftwf_plan, fftwf_complex*, fftwf_complex*);
+typedef void (*destroy_fn)(fftwf_plan);
+
+static plan_many_fn real_plan_many = NULL;
+static execute_fn real_execute = NULL;
+static execute_dft_fn real_execute_dft = NULL;
+static destroy_fn real_destroy = NULL;
+
+// resolved and initialized once, by the first thread planning a transform
+static pthread_once_t fftw_once = PTHREAD_ONCE_INIT;
+static pthread_once_t fpga_once = PTHREAD_ONCE_INIT;
+
+// set if the FPGA is initialized, unset if initialization failed or is not requested
+static bool fpga_usable = false;
+
+// set while the library itself calls FFTW, such calls are never offloaded
+static _Thread_local bool in_library = false;
+
+/**
+ * \brief  resolve the functions of FFTW in the next library of the lookup order
+ */
+static void resolve_once(){
+  real_plan_many = (plan_many_fn)dlsym(RTLD_NEXT, "fftwf_plan_many_dft");
+  real_execute = (execute_fn)dlsym(RTLD_NEXT, "fftwf_execute");
+  real_execute_dft = (execute_dft_fn)dlsym(RTLD_NEXT, "fftwf_execute_dft");
+  real_destroy = (destroy_fn)dlsym(RTLD_NEXT, "fftwf_destroy_plan");
+
+  if(real_plan_many == NULL || real_execute == NULL || real_execute_dft == NULL || real_destroy == NULL){
+    fprintf(stderr, "fftw3f_fpga: FFTW library not found, link libfftw3f after this library\n");
+    exit(EXIT_FAILURE);
+  }
+}
+
+/**
+ * \brief  resolve the functions of FFTW on first use
+ */
+static void resolve_fftw(){
+  pthread_once(&fftw_once, resolve_once);
+}
+
+/**
+ * \brief  initialize the FPGA with the bitstream given in the environment
+ */
+static void fpga_init_once(){
+  const char *path = getenv("FFTFPGA_BITSTREAM");
+  const char *platform = getenv("FFTFPGA_PLATFORM");
+  if(platform == NULL)
+    platform = DEFAULT_PLATFORM;
+
+  if(path == NULL)
+    return;
+
+  in_library = true;
+  int status = fpga_initialize(platform, path, false);
+  in_library = false;
+
+  if(status != 0){
+    fprintf(stderr, "fftw3f_fpga: FPGA initialization failed (%d), using FFTW\n", status);
+    return;
+  }
+
+  atexit(fpga_final);
+  fpga_usable = true;
+}
+
+/**
+ * \brief  initialize the FPGA on first use, other threads planning meanwhile wait for it
+ * \return true if the FPGA can be used
+ */
+static bool fpga_ready(){
+  pthread_once(&fpga_once, fpga_init_once);
+  return fpga_usable;
+}
+
+/**
+ * \brief  plans of the library are tagged, the others come from planners of FFTW that are not intercepted, such as the real-data and guru planners
+ * \return the plan of the library or NULL for a plan of FFTW
+ */
+static shim_plan_t *shim_plan(const fftwf_plan plan){
+  shim_plan_t *p = (shim_plan_t *)plan;
+  if(p == NULL || p->magic != SHIM_PLAN_MAGIC)
+    return NULL;
+  return p;
+}
+
+/**
+ * \brief  compute an offloaded transform with FFTW, planned without overwriting the arrays
+ */
+static void fallback_execute(const shim_plan_t *p, fftwf_complex *in, fftwf_complex *out){
+  int n[3] = {(int)p->N, (int)p->N, (int)p->N};
+  int dist = 1;
+  for(unsigned i = 0; i < p->dim; i++)
+    dist *= (int)p->N;
+
+  fftwf_plan plan = real_plan_many((int)p->dim, n, (int)p->how_many, in, NULL, 1, dist, out, NULL, 1, dist, p->inv ? FFTW_BACKWARD : FFTW_FORWARD, FFTW_ESTIMATE | FFTW_UNALIGNED);
+  if(plan == NULL){
+    fprintf(stderr, "fftw3f_fpga: failed to plan the transform with FFTW\n");
+    return;
+  }
+  real_execute(plan);
+  real_destroy(plan);
+}
+
+/**
+ * \brief  check if the layout is a contiguous batch of cubic transforms of a power of 2 size
+ */
+static bool supported(int rank, const int *n, int howmany, const int *inembed, int istride, int idist, const int *onembed, int ostride, int odist){
+  if(rank < 1 || rank > 3 || howmany < 1 || istride != 1 || ostride != 1)
+    return false;
+
+  int sz = 1;
+  for(int i = 0; i < rank; i++){
+    if(n[i] != n[0] || n[i] < 8 || (n[i] & (n[i] - 1)) != 0)
+      return false;
+    if((inembed != NULL && inembed[i] != n[i]) || (onembed != NULL && onembed[i] != n[i]))
+      return false;
+    sz *= n[i];
+  }
+  return (howmany == 1) || (idist == sz && odist == sz);
+}
+
+fftwf_plan fftwf_plan_many_dft(int rank, const int *n, int howmany, fftwf_complex *in, const int *inembed, int istride, int idist, fftwf_complex *out, const int *onembed, int ostride, int odist, int sign, unsigned flags){
+  resolve_fftw();
+
+  shim_plan_t *p = (shim_plan_t *)calloc(1, sizeof(shim_plan_t));
+  if(p == NULL)
+    return NULL;
+  p->magic = SHIM_PLAN_MAGIC;
+
+  if(!in_library && supported(rank, n, howmany, inembed, istride, idist, onembed, ostride, odist) && fpga_ready()){
+    p->on_fpga = true;
+    p->dim = rank;
+    p->N = n[0];
+    p->how_many = howmany;
+    p->inv = (sign == FFTW_BACKWARD);
+    p->in = in;
+    p->out = out;
+    return (fftwf_plan)p;
+  }
+
+  p->real = real_plan_many(rank, n, howmany, in, inembed, istride, idist, out, onembed, ostride, odist, sign, flags);
+  if(p->real == NULL){
+    free(p);
+    return NULL;
+  }
+  return (fftwf_plan)p;
+}
+
+fftwf_plan fftwf_plan_dft(int rank, const int *n, fftwf_complex *in, fftwf_complex *out, int sign, unsigned flags){
+  return fftwf_plan_many_dft(rank, n, 1, in, NULL, 1, 0, out, NULL, 1, 0, sign, flags);
+}
+
+fftwf_plan fftwf_plan_dft_1d(int n0, fftwf_complex *in, fftwf_complex *out, int sign, unsigned flags){
+  int n[1] = {n0};
+  return fftwf_plan_dft(1, n, in, out, sign, flags);
+}
+
+fftwf_plan fftwf_plan_dft_2d(int n0, int n1, fftwf_complex *in, fftwf_complex *out, int sign, unsigned flags){
+  int n[2] = {n0, n1};
+  return fftwf_plan_dft(2, n, in, out, sign, flags);
+}
+
+fftwf_plan fftwf_plan_dft_3d(int n0, int n1, int n2, fftwf_complex *in, fftwf_complex *out, int sign, unsigned flags){
+  int n[3] = {n0, n1, n2};
+  return fftwf_plan_dft(3, n, in, out, sign, flags);
+}
+
+void fftwf_execute_dft(const fftwf_plan plan, fftwf_complex *in, fftwf_complex *out){
+  if(plan == NULL)
+    return;
+
+  resolve_fftw();
+  const shim_plan_t *p = shim_plan(plan);
+  if(p == NULL){
+    real_execute_dft(plan, in, out);
+    return;
+  }
+
+  if(!p->on_fpga){
+    real_execute_dft(p->real, in, out);
+    return;
+  }
+
+  in_library = true;
+  fpga_t runtime = fftfpgaf_c2c(p->dim, p->N, (const float2 *)in, (float2 *)out, p->inv, p->how_many);
+  in_library = false;
+
+  // FFTW computes the transform instead of ending the application
+  if(!runtime.valid){
+    fprintf(stderr, "fftw3f_fpga: offloaded transform failed, using FFTW\n");
+    fallback_execute(p, in, out);
+  }
+}
+
+void fftwf_execute(const fftwf_plan plan){
+  if(plan == NULL)
+    return;
+
+  resolve_fftw();
+  const shim_plan_t *p = shim_plan(plan);
+  if(p == NULL){
+    real_execute(plan);
+    return;
+  }
+
+  if(p->on_fpga)
+    fftwf_execute_dft(plan, p->in, p->out);
+  else
+    real_execute(p->real);
+}
+
+void fftwf_destroy_plan(fftwf_plan plan){
+  if(plan == NULL)
+    return;
+
+  resolve_fftw();
+  shim_plan_t *p = shim_plan(plan);
+  if(p == NULL){
+    real_destroy(plan);
+    return;
+  }
+
+  if(!p->on_fpga)
+    real_destroy(p->real);
+  p->magic = 0;
+  free(p);
+}
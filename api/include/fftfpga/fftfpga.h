@@ -9,6 +9,7 @@
 #define FFTFPGA_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
 /**
  * Single Precision Complex Floating Point Data Structure
@@ -35,9 +36,15 @@ typedef struct fpga_timing {
   double exec_t;          /**< Kernel execution time */
   double svm_copyin_t;    /**< Time to copy in data to SVM */
   double svm_copyout_t;   /**< Time to copy data out of SVM */ 
+  double cpu_t;           /**< Time spent computing on the CPU in hybrid executions */
   bool valid;             /**< Represents true signifying valid execution */
 } fpga_t;
 
+/**
+ * Opaque handle to single precision complex points in the global memory of the FPGA
+ */
+typedef struct fftfpga_buffer_t* fftfpga_buffer;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -60,6 +67,60 @@ extern int fpga_initialize(const char *platform_name, const char *path, const bo
  */
 extern void fpga_final();
 
+/**
+ * @brief  allocate a buffer of single precision complex points in the global memory of the FPGA, to chain transforms without transfers to the host. Buffers are released by fpga_final, after which only fftfpgaf_buffer_free can be called on them
+ * @param  num_pts : number of complex points
+ * @param  bank    : global memory bank, 0 for burst interleaved placement or 1 to 4
+ * @return handle to the buffer, NULL if no bitstream is loaded or the allocation fails
+ */
+extern fftfpga_buffer fftfpgaf_buffer_alloc(const size_t num_pts, const unsigned bank);
+
+/**
+ * @brief  release a buffer allocated on the FPGA
+ * @param  buf : handle to the buffer, can be NULL
+ */
+extern void fftfpgaf_buffer_free(fftfpga_buffer buf);
+
+/**
+ * @brief  copy points from the host to a buffer on the FPGA
+ * @param  buf     : handle to the buffer
+ * @param  inp     : float2 pointer to the points to copy
+ * @param  num_pts : number of points, at most the size of the buffer
+ * @return fpga_t : time taken in milliseconds for the PCIe write
+ */
+extern fpga_t fftfpgaf_buffer_upload(fftfpga_buffer buf, const float2 *inp, const size_t num_pts);
+
+/**
+ * @brief  copy points from a buffer on the FPGA to the host
+ * @param  buf     : handle to the buffer
+ * @param  out     : float2 pointer to the destination
+ * @param  num_pts : number of points, at most the size of the buffer
+ * @return fpga_t : time taken in milliseconds for the PCIe read
+ */
+extern fpga_t fftfpgaf_buffer_download(const fftfpga_buffer buf, float2 *out, const size_t num_pts);
+
+/**
+ * @brief  copy a sub-box of a cube of points from a buffer on the FPGA to a strided location in a larger host array, transferring only the points of the sub-box
+ * @param  buf    : handle to the buffer holding the cube in the layout [z][y][x]
+ * @param  N      : unsigned integer size of the cube
+ * @param  box    : size of the sub-box along x, y and z
+ * @param  origin : first point of the sub-box along x, y and z, the sub-box wraps around periodically
+ * @param  out    : float2 pointer to the first point of the sub-box in the host array
+ * @param  ld     : number of points per row and rows per slice of the host array
+ * @return fpga_t : time taken in milliseconds for the PCIe read
+ */
+extern fpga_t fftfpgaf_buffer_download_region(const fftfpga_buffer buf, const unsigned N, const unsigned box[3], const unsigned origin[3], float2 *out, const unsigned ld[2]);
+
+/**
+ * @brief  reorder lines of points from bit-reversed to natural order on the host, using cache-sized tiles and the threads of OpenMP
+ * @param  N        : number of points per line, a power of 2
+ * @param  how_many : number of lines
+ * @param  inp      : float2 pointer to the lines in bit-reversed order
+ * @param  out      : float2 pointer to the lines in natural order, distinct from inp
+ * @return 0 if successful, -1 if the arguments are invalid
+ */
+extern int fftfpgaf_bit_reverse(const unsigned N, const unsigned how_many, const float2 *inp, float2 *out);
+
 /** 
  * @brief Allocate memory of double precision complex floating points
  * @param sz  : size_t - size to allocate
@@ -107,6 +168,17 @@ extern fpga_t fftfpgaf_c2c_1d(const unsigned N, const float2 *inp, float2 *out,
  */
 extern fpga_t fftfpgaf_c2c_1d_svm(const unsigned N, const float2 *inp, float2 *out, const bool inv, const unsigned batch);
 
+/**
+ * @brief  compute out-of-place single precision complex 1D-FFTs along an axis of a 3D array on the FPGA, reading the lines with a stride instead of transposing the array
+ * @param  dims : size of the array along x, y and z, in the layout [z][y][x]. The size along the axis is a power of 2 of at least 8.
+ * @param  axis : 0, 1 or 2 for the lines along x, y or z
+ * @param  inp  : float2 pointer to input data of size [dims[0] * dims[1] * dims[2]]
+ * @param  out  : float2 pointer to output data of the same size and layout
+ * @param  inv  : toggle to activate backward FFT
+ * @return fpga_t : time taken in milliseconds for data transfers and execution
+ */
+extern fpga_t fftfpgaf_c2c_1d_axis(const unsigned dims[3], const unsigned axis, const float2 *inp, float2 *out, const bool inv);
+
 /**
  * @brief  compute an out-of-place single precision complex 2D-FFT using the BRAM of the FPGA
  * @param  N    : integer pointer to size of FFT2d  
@@ -119,6 +191,22 @@ extern fpga_t fftfpgaf_c2c_1d_svm(const unsigned N, const float2 *inp, float2 *o
  */
 extern fpga_t fftfpgaf_c2c_2d_bram(const unsigned N, const float2 *inp, float2 *out, const bool inv, const bool interleaving, const unsigned how_many);
 
+/**
+ * @brief  compute batched out-of-place single precision complex 2D-FFTs using the BRAM of the FPGA, with the layout of fftwf_plan_many_dft. The transforms are transferred from and to their place in the host arrays without gathering them.
+ * @param  N       : unsigned integer size of FFT2d
+ * @param  inp     : float2 pointer to input data
+ * @param  istride : distance between consecutive points of an input transform, 1 as the points of a transform are contiguous
+ * @param  idist   : distance between the first points of consecutive input transforms
+ * @param  out     : float2 pointer to output data
+ * @param  ostride : distance between consecutive points of an output transform, 1 as the points of a transform are contiguous
+ * @param  odist   : distance between the first points of consecutive output transforms
+ * @param  inv     : toggle to activate backward FFT
+ * @param  interleaving : enable interleaved global memory buffers
+ * @param  how_many : number of 2D FFTs to compute
+ * @return fpga_t : time taken in milliseconds for data transfers and execution
+ */
+extern fpga_t fftfpgaf_c2c_2d_bram_many(const unsigned N, const float2 *inp, const size_t istride, const size_t idist, float2 *out, const size_t ostride, const size_t odist, const bool inv, const bool interleaving, const unsigned how_many);
+
 /**
  * @brief  compute an out-of-place single precision complex 2DFFT using the BRAM of the FPGA and Shared Virtual Memory for Host to Device Communication
  * @param  N    : integer pointer to size of FFT2d  
@@ -161,8 +249,83 @@ extern fpga_t fftfpgaf_c2c_3d_bram(const unsigned N, const float2 *inp, float2 *
  */
 extern fpga_t fftfpgaf_c2c_3d_ddr(const unsigned N, const float2 *inp, float2 *out, const bool inv);
 
+/**
+ * @brief  compute a batch of out-of-place single precision complex 3D-FFTs using the DDR of the FPGA. With the fft3d_ddr_multi bitstream, the transforms are distributed to its replicated pipelines and computed concurrently.
+ * @param  N    : integer pointer addressing the size of FFT3d  
+ * @param  inp  : float2 pointer to input data of size [how_many * N * N * N]
+ * @param  out  : float2 pointer to output data of size [how_many * N * N * N]
+ * @param  inv  : int toggle to activate backward FFT
+ * @param  interleaving : toggle to use burst interleaved global memory buffers, ignored by the replicated pipelines
+ * @param  how_many : number of transforms of the batch, at least 2
+ * @return fpga_t : time taken in milliseconds for data transfers and execution
+ */
 extern fpga_t fftfpgaf_c2c_3d_ddr_batch(const unsigned N, const float2 *inp, float2 *out, const bool inv, const bool interleaving, const unsigned how_many);
 
+/**
+ * @brief  compute a batched out-of-place single precision complex 3D-FFT using the DDR of the FPGA, with the layout of fftwf_plan_many_dft. The transforms are transferred from and to their place in the host arrays without gathering them.
+ * @param  N       : unsigned integer size of FFT3d
+ * @param  inp     : float2 pointer to input data
+ * @param  istride : distance between consecutive points of an input transform, 1 as the points of a transform are contiguous
+ * @param  idist   : distance between the first points of consecutive input transforms
+ * @param  out     : float2 pointer to output data
+ * @param  ostride : distance between consecutive points of an output transform, 1 as the points of a transform are contiguous
+ * @param  odist   : distance between the first points of consecutive output transforms
+ * @param  inv     : toggle to activate backward FFT
+ * @param  interleaving : enable burst interleaved global memory buffers
+ * @param  how_many : number of 3D FFTs to compute, at least 2
+ * @return fpga_t : time taken in milliseconds for data transfers and execution
+ */
+extern fpga_t fftfpgaf_c2c_3d_ddr_batch_many(const unsigned N, const float2 *inp, const size_t istride, const size_t idist, float2 *out, const size_t ostride, const size_t odist, const bool inv, const bool interleaving, const unsigned how_many);
+
+/**
+ * @brief  compute a single precision complex 3D-FFT of a buffer on the FPGA into another using the DDR of the FPGA, without transfers to or from the host
+ * @param  N    : unsigned integer size of FFT3d
+ * @param  inp  : handle to the device buffer of the input of at least [N * N * N] points
+ * @param  out  : handle to the device buffer of the output of at least [N * N * N] points, can be the same as inp
+ * @param  inv  : toggle to activate backward FFT
+ * @param  unordered : toggle for the forward FFT to write and the backward FFT to read the frequencies bit-reversed along each dimension
+ * @param  transposed : toggle to write the output in the layout [y][z][x] and to read the input of a backward FFT in this layout
+ * @return fpga_t : time taken in milliseconds for execution
+ */
+extern fpga_t fftfpgaf_c2c_3d_ddr_dev(const unsigned N, const fftfpga_buffer inp, fftfpga_buffer out, const bool inv, const bool unordered, const bool transposed);
+
+/**
+ * @brief  compute single precision complex 1D-FFTs along an axis of a 3D array in a device buffer into another using the fft1d bitstream
+ * @param  dims : size of the array along x, y and z, in the layout [z][y][x]. The size along the axis is a power of 2 of at least 8.
+ * @param  axis : 0, 1 or 2 for the lines along x, y or z
+ * @param  inp  : handle to the device buffer of the input
+ * @param  out  : handle to the device buffer of the output, different from inp
+ * @param  inv  : toggle to activate backward FFT
+ * @param  unordered : store the output along the axis in bit-reversed order, skipping the reorder
+ * @return fpga_t : time taken in milliseconds for the execution
+ */
+extern fpga_t fftfpgaf_c2c_1d_axis_dev(const unsigned dims[3], const unsigned axis, const fftfpga_buffer inp, fftfpga_buffer out, const bool inv, const bool unordered);
+
+/**
+ * @brief  compute an out-of-place single precision complex 3D-FFT of an input that is zero outside of a sub-box using the DDR of the FPGA. Only the sub-box is transferred to the FPGA.
+ * @param  N      : unsigned integer size of FFT3d
+ * @param  box    : size of the sub-box along x, y and z, the size along x being a multiple of 8
+ * @param  origin : first point of the sub-box along x, y and z, the sub-box wraps around periodically. The origin along x is a multiple of 8
+ * @param  inp    : float2 pointer to the points of the sub-box of size [box[2] * box[1] * box[0]] in the layout [z][y][x]
+ * @param  out    : float2 pointer to output data of size [N * N * N]
+ * @param  inv    : toggle to activate backward FFT
+ * @return fpga_t : time taken in milliseconds for data transfers and execution
+ */
+extern fpga_t fftfpgaf_c2c_3d_ddr_pruned(const unsigned N, const unsigned box[3], const unsigned origin[3], const float2 *inp, float2 *out, const bool inv);
+
+/**
+ * @brief  compute a single precision complex 3D-FFT using the DDR of the FPGA, reading back only a sub-box of the output to a strided location in a larger host array
+ * @param  N      : unsigned integer size of FFT3d
+ * @param  inp    : float2 pointer to input data of size [N * N * N]
+ * @param  inv    : toggle to activate backward FFT
+ * @param  box    : size of the sub-box of the output along x, y and z
+ * @param  origin : first point of the sub-box along x, y and z, the sub-box wraps around periodically
+ * @param  out    : float2 pointer to the first point of the sub-box in the host array
+ * @param  ld     : number of points per row and rows per slice of the host array
+ * @return fpga_t : time taken in milliseconds for data transfers and execution
+ */
+extern fpga_t fftfpgaf_c2c_3d_ddr_region(const unsigned N, const float2 *inp, const bool inv, const unsigned box[3], const unsigned origin[3], float2 *out, const unsigned ld[2]);
+
 /**
  * @brief  compute an out-of-place single precision complex 3D-FFT using the DDR of the FPGA and Shared Virtual Memory for Host to Device Communication
  * @param  N    : unsigned integer size of FFT3d  
@@ -185,6 +348,107 @@ extern fpga_t fftfpgaf_c2c_3d_ddr_svm(const unsigned N, const float2 *inp, float
  */
 extern fpga_t fftfpgaf_c2c_3d_ddr_svm_batch(const unsigned N, const float2 *inp, float2 *out, const bool inv, const unsigned how_many);
 
+/**
+ * @brief  compute an out-of-place single precision complex 3D-FFT by computing the 2D-FFTs of the xy-planes on the FPGA and the 1D-FFTs along z on the CPU. The planes are computed in groups of every eighth plane, and the CPU transforms a group along z while the FPGA computes the following ones. N must be at least 8.
+ * @param  N    : unsigned integer size of FFT3d  
+ * @param  inp  : float2 pointer to input data of size [N * N * N]
+ * @param  out  : float2 pointer to output data of size [N * N * N]
+ * @param  inv  : toggle to activate backward FFT
+ * @param  interleaving  : toggle interleaved device memory
+ * @return fpga_t : time taken in milliseconds for data transfers, execution and the CPU computation
+ */
+extern fpga_t fftfpgaf_c2c_3d_hybrid(const unsigned N, const float2 *inp, float2 *out, const bool inv, const bool interleaving);
+
+/**
+ * @brief  upload the kernel array of a 3D convolution to the FPGA. The array is kept in the DDR of the FPGA for the following calls to fftfpgaf_c2c_3d_conv until another array is set or fpga_final is called
+ * @param  N     : unsigned integer size of FFT3d
+ * @param  coeff : float2 pointer to the kernel array in frequency space of size [N * N * N], in the layout of the output of fftfpgaf_c2c_3d_ddr
+ * @return 0 if successful
+          -1 if the arguments are invalid or no bitstream is loaded
+          -2 if the bitstream loaded has no pointwise multiplication kernel
+ */
+extern int fftfpgaf_conv3d_set_kernel(const unsigned N, const float2 *coeff);
+
+/**
+ * @brief  compute an out-of-place single precision complex 3D convolution using the DDR of the FPGA: forward 3D-FFT, pointwise multiplication with the kernel array and backward 3D-FFT, without transferring the intermediate spectrum to the host. The backward transform is not normalized
+ * @param  N    : unsigned integer size of FFT3d
+ * @param  inp  : float2 pointer to input data of size [N * N * N]
+ * @param  out  : float2 pointer to output data of size [N * N * N]
+ * @return fpga_t : time taken in milliseconds for data transfers and execution, invalid if no kernel array of size N is set
+ */
+extern fpga_t fftfpgaf_c2c_3d_conv(const unsigned N, const float2 *inp, float2 *out);
+
+/**
+ * @brief  compute a single precision complex 3D convolution of a buffer on the FPGA into another, using the kernel array set by fftfpgaf_conv3d_set_kernel, without transfers to or from the host
+ * @param  N    : unsigned integer size of FFT3d
+ * @param  inp  : handle to the device buffer of the input of at least [N * N * N] points
+ * @param  out  : handle to the device buffer of the output of at least [N * N * N] points, can be the same as inp
+ * @return fpga_t : time taken in milliseconds for execution, invalid if no kernel array of size N is set
+ */
+extern fpga_t fftfpgaf_c2c_3d_conv_dev(const unsigned N, const fftfpga_buffer inp, fftfpga_buffer out);
+
+/**
+ * @brief  compute the gradient of a periodic 3D field using the DDR of the FPGA: one forward 3D-FFT, then for each axis the multiplication of the spectrum by i * k, with the k-vectors generated on the device, and a backward 3D-FFT. The field is transferred to the FPGA once. Requires the fft3d_ddr_conv bitstream
+ * @param  N      : unsigned integer size of FFT3d
+ * @param  inp    : float2 pointer to the field of size [N * N * N] in the layout [z][y][x]
+ * @param  grad_x : float2 pointer to the derivative along x of size [N * N * N]
+ * @param  grad_y : float2 pointer to the derivative along y of size [N * N * N]
+ * @param  grad_z : float2 pointer to the derivative along z of size [N * N * N]
+ * @param  L      : length of the periodic box along each dimension
+ * @return fpga_t : time taken in milliseconds for data transfers and execution
+ */
+extern fpga_t fftfpgaf_gradient_3d(const unsigned N, const float2 *inp, float2 *grad_x, float2 *grad_y, float2 *grad_z, const float L);
+
+/**
+ * @brief  measure the DDR accesses of the 3D Transpose of the 3D DDR FFT: the sequential write of a transform and its read along z in the layout given by log_tile, as selected by LOG_TRANSPOSE3D_TILE for the kernels. Requires the transpose3d_bench bitstream
+ * @param  N        : unsigned integer size of FFT3d
+ * @param  log_tile : log2 of the number of planes along z per block of the layout, 0 for the layout [z][y][x]
+ * @param  write_t  : time taken in milliseconds for the write of N * N * N points
+ * @param  read_t   : time taken in milliseconds for the read of N * N * N points
+ * @return 0 if successful
+          -1 if the arguments are invalid or no bitstream is loaded
+          -2 if the bitstream loaded has no benchmark kernels
+ */
+extern int fftfpgaf_transpose3d_bench(const unsigned N, const unsigned log_tile, double *write_t, double *read_t);
+
+/**
+ * @brief  compute a single precision complex FFT on either the FPGA or the CPU, whichever is faster for the given configuration. The transform is in place if inp and out are the same array. The first call of a (dim, N, how_many, inv) configuration computes the transform on both from copies of the input, verifies the FPGA result and measures the crossover. The FPGA variant is the fastest one predicted by the performance model. FFTFPGA_BACKEND=cpu|fpga in the environment forces a backend and FFTFPGA_CPU_THREADS sets the number of FFTW threads
+ * @param  dim  : number of dimensions, 1 to 3
+ * @param  N    : unsigned integer size of a dimension
+ * @param  inp  : float2 pointer to input data of size [how_many * N^dim]
+ * @param  out  : float2 pointer to output data of size [how_many * N^dim], in natural order, can be the same as inp
+ * @param  inv  : toggle to activate backward FFT
+ * @param  how_many : number of FFTs to compute
+ * @return fpga_t : time taken in milliseconds, only cpu_t is set if the CPU computed the transform
+ */
+extern fpga_t fftfpgaf_c2c(const unsigned dim, const unsigned N, const float2 *inp, float2 *out, const bool inv, const unsigned how_many);
+
+/**
+ * @brief  predict the end-to-end time of a transform on the FPGA using the performance model, calibrated by the first prediction or transform dispatched. The model selects the fastest variant and memory placement available in the loaded bitstream, as used by fftfpgaf_c2c
+ * @param  dim  : number of dimensions, 1 to 3
+ * @param  N    : unsigned integer size of a dimension
+ * @param  how_many : number of FFTs to compute
+ * @return predicted time in milliseconds, negative if the loaded bitstream cannot compute the transform
+ */
+extern double fftfpgaf_predict(const unsigned dim, const unsigned N, const unsigned how_many);
+
+/**
+ * @brief  export the tuning data of the loaded bitstream as wisdom: the PCIe bandwidth and fixed costs measured, the kernel throughput of the variants and, for each configuration measured, the faster backend with the FPGA variant and memory placement used. The wisdom is keyed by the device name, the board support package and driver versions and a hash of the bitstream, computed by the first export or import
+ * @param  filename : path to the wisdom file, overwritten if it exists
+ * @return 0 if successful
+          -1 if no bitstream is loaded or calibrated, or the file cannot be written
+ */
+extern int fftfpga_export_wisdom(const char *filename);
+
+/**
+ * @brief  import wisdom exported for the same device, board support package and bitstream. fpga_initialize imports the file set in the environment variable FFTFPGA_WISDOM, so that the model is not calibrated again, and fpga_final exports to it
+ * @param  filename : path to the wisdom file
+ * @return 0 if successful
+          -1 if no bitstream is loaded, or the file is missing or malformed, including a key with a line missing or repeated
+          -2 if the wisdom was exported for another device, board support package or bitstream
+ */
+extern int fftfpga_import_wisdom(const char *filename);
+
 #ifdef __cplusplus
 }
 #endif
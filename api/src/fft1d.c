@@ -12,9 +12,55 @@
 #include "fpga_state.h"
 #include "fftfpga/fftfpga.h"
 #include "svm.h"
+#include "fft_buffer.h"
 #include "opencl_utils.h"
 #include "misc.h"
 
+/**
+ * \brief  set the addressing of the lines transformed by the fetch and fft1d kernels
+ * \param  fetch_kernel : fetch kernel reading the lines
+ * \param  fft_kernel   : fft1d kernel writing the lines
+ * \param  layout       : distance between the points of a line, number of lines in a group, distance between the lines of a group and distance between the groups
+ * \param  natural      : store the output in natural order instead of the bit-reversed order of the FFT engine
+ */
+static void set_line_layout(cl_kernel fetch_kernel, cl_kernel fft_kernel, const cl_uint layout[4], const bool natural){
+  cl_int status = 0;
+
+  for(cl_uint i = 0; i < 4; i++){
+    status = clSetKernelArg(fetch_kernel, 1 + i, sizeof(cl_uint), (void *)&layout[i]);
+    checkError(status, "Failed to set fetch kernel layout arg");
+    status = clSetKernelArg(fft_kernel, 3 + i, sizeof(cl_uint), (void *)&layout[i]);
+    checkError(status, "Failed to set fft1d kernel layout arg");
+  }
+
+  // Can't pass bool to device, so convert it to int
+  int natural_int = (int)natural;
+  status = clSetKernelArg(fft_kernel, 7, sizeof(cl_int), (void *)&natural_int);
+  checkError(status, "Failed to set fft1d kernel arg 7");
+}
+
+/**
+ * \brief  compute the launch size of the fetch kernel, whose work-items read POINTS points each in work-groups of the size required by the bitstream. The bitstream bounds the work-groups to 4096 / POINTS points, so POINTS is derived from this size.
+ * \param  fetch_kernel : fetch kernel reading the lines
+ * \param  N            : number of points of a line
+ * \param  lines        : number of lines transformed
+ * \param  ls           : set to the local work size
+ * \param  gs           : set to the global work size
+ */
+static void fetch_launch_size(cl_kernel fetch_kernel, const unsigned N, const unsigned lines, size_t *ls, size_t *gs){
+  size_t wg_size[3] = {0, 0, 0};
+  cl_int status = clGetKernelWorkGroupInfo(fetch_kernel, device, CL_KERNEL_COMPILE_WORK_GROUP_SIZE, sizeof(wg_size), wg_size, NULL);
+  checkError(status, "Failed to query fetch kernel work-group size");
+
+  // work-groups of min(N, 4096) / POINTS work-items
+  unsigned log_points = 0;
+  while(((size_t)wg_size[0] << log_points) < N && ((size_t)wg_size[0] << log_points) < 4096)
+    log_points++;
+
+  *ls = wg_size[0];
+  *gs = ((size_t)lines * N) >> log_points;
+}
+
 /**
  * \brief  compute an out-of-place double precision complex 1D-FFT on the FPGA
  * \param  N    : unsigned integer to the number of points in 1D FFT
@@ -78,11 +124,15 @@ fpga_t fftfpga_c2c_1d(const unsigned N, const double2 *inp, double2 *out, const
   status = clSetKernelArg(fft_kernel, 2, sizeof(cl_int), (void*)&inverse_int);
   checkError(status, "Failed to set fft_kernel arg 2");
 
+  // batch of contiguous lines in natural order
+  const cl_uint layout[4] = {1, 1, 0, N};
+  set_line_layout(fetch_kernel, fft_kernel, layout, true);
+
   printf(inverse_int ? "\tInverse FFT" : "\tFFT");
   printf(" kernel initialization is complete.\n");
 
-  size_t ls = N/8;
-  size_t gs = batch * ls;
+  size_t ls, gs;
+  fetch_launch_size(fetch_kernel, N, batch, &ls, &gs);
 
   printf("-- Executing kernels\n");
   // Measure execution time
@@ -197,8 +247,12 @@ fpga_t fftfpgaf_c2c_1d(const unsigned N, const float2 *inp, float2 *out, const b
   status = clSetKernelArg(kernel2, 2, sizeof(cl_int), (void*)&inverse_int);
   checkError(status, "Failed to set kernel arg 2");
 
-  size_t ls = N/8;
-  size_t gs = batch * ls;
+  // batch of contiguous lines in natural order
+  const cl_uint layout[4] = {1, 1, 0, N};
+  set_line_layout(kernel1, kernel2, layout, true);
+
+  size_t ls, gs;
+  fetch_launch_size(kernel1, N, batch, &ls, &gs);
 
   printf("-- Executing kernels\n");
   cl_event startExec_event, endExec_event;
@@ -247,7 +301,7 @@ fpga_t fftfpgaf_c2c_1d(const unsigned N, const float2 *inp, float2 *out, const b
 }
 
 /**
- * \brief  compute an out-of-place single precision complex 1D-FFT on the FPGA using Shared Virtual Memory for data transfers between host's main memory and FPGA
+ * \brief  compute an out-of-place single precision complex 1D-FFT on the FPGA using Shared Virtual Memory for data transfers between host's main memory and FPGA. The output is reordered to natural order during the copy out of the shared buffer.
  * \param  N    : unsigned integer to the number of points in 1D FFT  
  * \param  inp  : float2 pointer to input data of size N
  * \param  out  : float2 pointer to output data of size N
@@ -320,8 +374,12 @@ fpga_t fftfpgaf_c2c_1d_svm(const unsigned N, const float2 *inp, float2 *out, con
   status=clSetKernelArg(fft_kernel, 2, sizeof(cl_int), (void*)&inverse_int);
   checkError(status, "Failed to set fft kernel arg");
 
-  size_t ls = N/8;
-  size_t gs = batch * ls;
+  // batch of contiguous lines, left in bit-reversed order as they are reordered while copied out of the SVM buffer
+  const cl_uint layout[4] = {1, 1, 0, N};
+  set_line_layout(fetch_kernel, fft_kernel, layout, false);
+
+  size_t ls, gs;
+  fetch_launch_size(fetch_kernel, N, batch, &ls, &gs);
 
   printf("-- Executing\n");
   cl_event startExec_event, endExec_event;
@@ -348,10 +406,7 @@ fpga_t fftfpgaf_c2c_1d_svm(const unsigned N, const float2 *inp, float2 *out, con
     (void *)h_outData, sizeof(float2) * num_pts, 0, NULL, NULL);
   checkError(status, "Failed to map out data");
 
-  for(size_t i = 0; i < num_pts; i++){
-    out[i].x = h_outData[i].x;
-    out[i].y = h_outData[i].y;
-  }
+  fftfpgaf_bit_reverse(N, batch, h_outData, out);
 
   status = clEnqueueSVMUnmap(queue1, (void *)h_outData, 0, NULL, NULL);
   checkError(status, "Failed to unmap out data");
@@ -371,3 +426,198 @@ fpga_t fftfpgaf_c2c_1d_svm(const unsigned N, const float2 *inp, float2 *out, con
   fft_time.valid = 1;
   return fft_time;
 }
+
+/**
+ * \brief  compute the addressing of the lines along an axis of a 3D array
+ * \param  dims   : size of the array along x, y and z, in the layout [z][y][x]
+ * \param  axis   : 0, 1 or 2 for the lines along x, y or z
+ * \param  layout : set to the distance between the points of a line, number of lines in a group, distance between the lines of a group and distance between the groups
+ * \return true if the size along the axis is a power of 2 of at least 8 points
+ */
+static bool axis_layout(const unsigned dims[3], const unsigned axis, cl_uint layout[4]){
+  if(axis > 2 || dims[0] == 0 || dims[1] == 0 || dims[2] == 0)
+    return false;
+
+  const unsigned N = dims[axis];
+  if(N < 8 || ( (N & (N-1)) !=0))
+    return false;
+
+  const cl_uint plane = dims[0] * dims[1];
+  switch(axis){
+    case 0:  // rows, one after another
+      layout[0] = 1; layout[1] = 1; layout[2] = 0; layout[3] = dims[0];
+      break;
+    case 1:  // columns of a plane side by side, the planes one after another
+      layout[0] = dims[0]; layout[1] = dims[0]; layout[2] = 1; layout[3] = plane;
+      break;
+    default: // lines of every point of a plane side by side
+      layout[0] = plane; layout[1] = plane; layout[2] = 1; layout[3] = 0;
+      break;
+  }
+  return true;
+}
+
+/**
+ * \brief  compute the 1D FFTs along an axis of a 3D array from one device buffer to another. The queues must have been setup.
+ * \param  dims   : size of the array along x, y and z
+ * \param  axis   : 0, 1 or 2 for the lines along x, y or z
+ * \param  layout : addressing of the lines computed by axis_layout
+ * \param  src    : device buffer of the input
+ * \param  dest   : device buffer of the output, different from src
+ * \param  inv    : toggle to activate backward FFT
+ * \param  natural : store the output along the axis in natural order
+ * \return time taken in milliseconds for the execution
+ */
+static double axis_run(const unsigned dims[3], const unsigned axis, const cl_uint layout[4], cl_mem src, cl_mem dest, const bool inv, const bool natural){
+  cl_int status = 0;
+  const unsigned N = dims[axis];
+  const cl_int lines = (dims[0] * dims[1] * dims[2]) / N;
+
+  // Can't pass bool to device, so convert it to int
+  int inverse_int = (int)inv;
+
+  cl_kernel fetch_kernel = clCreateKernel(program, "fetch", &status);
+  checkError(status, "Failed to create fetch kernel");
+  cl_kernel fft_kernel = clCreateKernel(program, "fft1d", &status);
+  checkError(status, "Failed to create fft1d kernel");
+
+  status = clSetKernelArg(fetch_kernel, 0, sizeof(cl_mem), (void *)&src);
+  checkError(status, "Failed to set fetch kernel arg 0");
+  status = clSetKernelArg(fft_kernel, 0, sizeof(cl_mem), (void *)&dest);
+  checkError(status, "Failed to set fft1d kernel arg 0");
+  status = clSetKernelArg(fft_kernel, 1, sizeof(cl_int), (void*)&lines);
+  checkError(status, "Failed to set fft1d kernel arg 1");
+  status = clSetKernelArg(fft_kernel, 2, sizeof(cl_int), (void*)&inverse_int);
+  checkError(status, "Failed to set fft1d kernel arg 2");
+  set_line_layout(fetch_kernel, fft_kernel, layout, natural);
+
+  size_t ls, gs;
+  fetch_launch_size(fetch_kernel, N, lines, &ls, &gs);
+
+  cl_event startExec_event, endExec_event;
+  status = clEnqueueTask(queue1, fft_kernel, 0, NULL, &endExec_event);
+  checkError(status, "Failed to launch fft1d kernel");
+
+  status = clEnqueueNDRangeKernel(queue2, fetch_kernel, 1, NULL, &gs, &ls, 0, NULL, &startExec_event);
+  checkError(status, "Failed to launch fetch kernel");
+
+  status = clFinish(queue1);
+  checkError(status, "Failed to finish queue1");
+  status = clFinish(queue2);
+  checkError(status, "Failed to finish queue2");
+
+  cl_ulong kernel_start = 0, kernel_end = 0;
+  clGetEventProfilingInfo(startExec_event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &kernel_start, NULL);
+  clGetEventProfilingInfo(endExec_event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &kernel_end, NULL);
+  clReleaseEvent(startExec_event);
+  clReleaseEvent(endExec_event);
+
+  if(fetch_kernel)
+    clReleaseKernel(fetch_kernel);
+  if(fft_kernel)
+    clReleaseKernel(fft_kernel);
+
+  return (cl_double)(kernel_end - kernel_start) * (cl_double)(1e-06);
+}
+
+/**
+ * \brief  compute out-of-place single precision complex 1D-FFTs along an axis of a 3D array on the FPGA. The fetch kernel reads the lines with a stride, so that the array is not transposed.
+ * \param  dims : size of the array along x, y and z, in the layout [z][y][x]. The size along the axis is a power of 2.
+ * \param  axis : 0, 1 or 2 for the lines along x, y or z
+ * \param  inp  : float2 pointer to input data of size [dims[0] * dims[1] * dims[2]]
+ * \param  out  : float2 pointer to output data of the same size and layout
+ * \param  inv  : toggle to activate backward FFT
+ * \return fpga_t : time taken in milliseconds for data transfers and execution
+ */
+fpga_t fftfpgaf_c2c_1d_axis(const unsigned dims[3], const unsigned axis, const float2 *inp, float2 *out, const bool inv){
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0};
+  cl_int status = 0;
+  cl_uint layout[4];
+
+  if(dims == NULL || inp == NULL || out == NULL || !axis_layout(dims, axis, layout)){
+    return fft_time;
+  }
+  const size_t num_pts = (size_t)dims[0] * dims[1] * dims[2];
+
+  queue_setup();
+
+  cl_mem d_inData, d_outData;
+  d_inData = clCreateBuffer(context, CL_MEM_READ_ONLY, sizeof(float2) * num_pts, NULL, &status);
+  checkError(status, "Failed to allocate input device buffer\n");
+
+  d_outData = clCreateBuffer(context, CL_MEM_WRITE_ONLY | CL_CHANNEL_2_INTELFPGA, sizeof(float2) * num_pts, NULL, &status);
+  checkError(status, "Failed to allocate output device buffer\n");
+
+  // Copy data from host to device
+  cl_event writeBuf_event;
+  status = clEnqueueWriteBuffer(queue1, d_inData, CL_TRUE, 0, sizeof(float2) * num_pts, inp, 0, NULL, &writeBuf_event);
+  checkError(status, "Failed to copy data to device");
+
+  status = clFinish(queue1);
+  checkError(status, "failed to finish writing buffer using PCIe");
+
+  cl_ulong writeBuf_start = 0, writeBuf_end = 0;
+  clGetEventProfilingInfo(writeBuf_event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &writeBuf_start, NULL);
+  clGetEventProfilingInfo(writeBuf_event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &writeBuf_end, NULL);
+  clReleaseEvent(writeBuf_event);
+
+  fft_time.pcie_write_t = (cl_double)(writeBuf_end - writeBuf_start) * (cl_double)(1e-06);
+
+  fft_time.exec_t = axis_run(dims, axis, layout, d_inData, d_outData, inv, true);
+
+  // Copy results from device to host
+  cl_event readBuf_event;
+  status = clEnqueueReadBuffer(queue1, d_outData, CL_TRUE, 0, sizeof(float2) * num_pts, out, 0, NULL, &readBuf_event);
+  checkError(status, "Failed to copy data from device");
+
+  status = clFinish(queue1);
+  checkError(status, "failed to finish reading buffer using PCIe");
+
+  cl_ulong readBuf_start = 0, readBuf_end = 0;
+  clGetEventProfilingInfo(readBuf_event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &readBuf_start, NULL);
+  clGetEventProfilingInfo(readBuf_event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &readBuf_end, NULL);
+  clReleaseEvent(readBuf_event);
+
+  fft_time.pcie_read_t = (cl_double)(readBuf_end - readBuf_start) * (cl_double)(1e-06);
+
+  if (d_inData)
+    clReleaseMemObject(d_inData);
+  if (d_outData)
+    clReleaseMemObject(d_outData);
+  queue_cleanup();
+
+  fft_time.valid = 1;
+  return fft_time;
+}
+
+/**
+ * \brief  compute single precision complex 1D-FFTs along an axis of a 3D array in a device buffer into another, without transfers to or from the host
+ * \param  dims : size of the array along x, y and z, in the layout [z][y][x]. The size along the axis is a power of 2.
+ * \param  axis : 0, 1 or 2 for the lines along x, y or z
+ * \param  inp  : handle to the device buffer of the input of at least [dims[0] * dims[1] * dims[2]] points
+ * \param  out  : handle to the device buffer of the output of the same size, different from inp
+ * \param  inv  : toggle to activate backward FFT
+ * \param  unordered : store the output along the axis in the bit-reversed order of the FFT engine, skipping the reorder
+ * \return fpga_t : time taken in milliseconds for the execution
+ */
+fpga_t fftfpgaf_c2c_1d_axis_dev(const unsigned dims[3], const unsigned axis, const fftfpga_buffer inp, fftfpga_buffer out, const bool inv, const bool unordered){
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0};
+  cl_uint layout[4];
+
+  if(dims == NULL || !axis_layout(dims, axis, layout)){
+    return fft_time;
+  }
+  const size_t num_pts = (size_t)dims[0] * dims[1] * dims[2];
+
+  // the lines are read while earlier ones are written, so the transform cannot be in place
+  if(!buffer_valid(inp, num_pts) || !buffer_valid(out, num_pts) || inp == out){
+    return fft_time;
+  }
+
+  queue_setup();
+  fft_time.exec_t = axis_run(dims, axis, layout, inp->mem, out->mem, inv, !unordered);
+  queue_cleanup();
+
+  fft_time.valid = 1;
+  return fft_time;
+}
@@ -12,6 +12,7 @@
 #include "fpga_state.h"
 #include "fftfpga/fftfpga.h"
 #include "svm.h"
+#include "fft_buffer.h"
 #include "opencl_utils.h"
 #include "misc.h"
 
@@ -168,6 +169,25 @@ fpga_t fftfpgaf_c2c_2d_ddr(const unsigned N, const float2 *inp, float2 *out, con
  * \return fpga_t : time taken in milliseconds for data transfers and execution
  */
 fpga_t fftfpgaf_c2c_2d_bram(const unsigned N, const float2 *inp, float2 *out, const bool inv, const bool interleaving, const unsigned how_many){
+  const size_t num_pts = (size_t)N * N;
+  return fftfpgaf_c2c_2d_bram_many(N, inp, 1, num_pts, out, 1, num_pts, inv, interleaving, how_many);
+}
+
+/**
+ * \brief  compute batched out-of-place single precision complex 2D-FFTs using the BRAM of the FPGA, with the layout of the advanced interface of FFTW. The transforms are transferred from and to their place in the host arrays without gathering them.
+ * \param  N       : unsigned integer denoting the size of FFT2d
+ * \param  inp     : float2 pointer to input data
+ * \param  istride : distance between consecutive points of an input transform, 1 as the points of a transform are contiguous
+ * \param  idist   : distance between the first points of consecutive input transforms
+ * \param  out     : float2 pointer to output data
+ * \param  ostride : distance between consecutive points of an output transform, 1 as the points of a transform are contiguous
+ * \param  odist   : distance between the first points of consecutive output transforms
+ * \param  inv     : toggle to activate backward FFT
+ * \param  interleaving : enable interleaved global memory buffers
+ * \param  how_many : number of 2D FFTs to compute
+ * \return fpga_t : time taken in milliseconds for data transfers and execution
+ */
+fpga_t fftfpgaf_c2c_2d_bram_many(const unsigned N, const float2 *inp, const size_t istride, const size_t idist, float2 *out, const size_t ostride, const size_t odist, const bool inv, const bool interleaving, const unsigned how_many){
   fpga_t fft_time = {0.0, 0.0, 0.0, 0};
   cl_kernel ffta_kernel = NULL, fftb_kernel = NULL;
   cl_kernel fetch_kernel = NULL, store_kernel = NULL;
@@ -181,6 +201,10 @@ fpga_t fftfpgaf_c2c_2d_bram(const unsigned N, const float2 *inp, float2 *out, co
     return fft_time;
   }
 
+  if(!layout_valid(N * N, how_many, istride, idist) || !layout_valid(N * N, how_many, ostride, odist)){
+    return fft_time;
+  }
+
   queue_setup();
 
   cl_mem_flags flagbuf1, flagbuf2;
@@ -201,20 +225,8 @@ fpga_t fftfpgaf_c2c_2d_bram(const unsigned N, const float2 *inp, float2 *out, co
   d_outData = clCreateBuffer(context, flagbuf2, sizeof(float2) * num_pts, NULL, &status);
   checkError(status, "Failed to allocate output device buffer\n");
 
- // Copy data from host to device
-  cl_event writeBuf_event;
-  status = clEnqueueWriteBuffer(queue1, d_inData, CL_TRUE, 0, sizeof(float2) * num_pts, inp, 0, NULL, &writeBuf_event);
-  checkError(status, "Failed to copy data to device");
-
-  status = clFinish(queue1);
-  checkError(status, "failed to finish");
-
-  cl_ulong writeBuf_start = 0.0, writeBuf_end = 0.0;
-
-  clGetEventProfilingInfo(writeBuf_event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &writeBuf_start, NULL);
-  clGetEventProfilingInfo(writeBuf_event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &writeBuf_end, NULL);
-
-  fft_time.pcie_write_t = (cl_double)(writeBuf_end - writeBuf_start) * (cl_double)(1e-06);
+  // Copy data from host to device
+  fft_time.pcie_write_t = buffer_transfer_strided(d_inData, true, N * N, how_many, (void*)inp, idist);
 
   // Can't pass bool to device, so convert it to int
   int inverse_int = (int)inv;
@@ -298,19 +310,7 @@ fpga_t fftfpgaf_c2c_2d_bram(const unsigned N, const float2 *inp, float2 *out, co
   fft_time.exec_t = (cl_double)(kernel_end - kernel_start) * (cl_double)(1e-06); 
 
   // Copy results from device to host
-  cl_event readBuf_event;
-
-  status = clEnqueueReadBuffer(queue1, d_outData, CL_TRUE, 0, sizeof(float2) * num_pts, out, 0, NULL, &readBuf_event);
-  checkError(status, "Failed to copy data from device");
-
-  status = clFinish(queue1);
-  checkError(status, "failed to finish reading buffer using PCIe");
-
-  cl_ulong readBuf_start = 0, readBuf_end = 0;
-  clGetEventProfilingInfo(readBuf_event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &readBuf_start, NULL);
-  clGetEventProfilingInfo(readBuf_event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &readBuf_end, NULL);
-
-  fft_time.pcie_read_t = (cl_double)(readBuf_end - readBuf_start) * (cl_double)(1e-06);
+  fft_time.pcie_read_t = buffer_transfer_strided(d_outData, false, N * N, how_many, out, odist);
 
   queue_cleanup();
 
@@ -12,10 +12,10 @@
 #include "fpga_state.h"
 #include "fftfpga/fftfpga.h"
 #include "opencl_utils.h"
+#include "fft3d_pipeline.h"
+#include "fft_buffer.h"
 #include "misc.h"
 
-#define WR_GLOBALMEM 0
-#define RD_GLOBALMEM 1
 #define BATCH 2
 
 /**
@@ -208,43 +208,24 @@ fpga_t fftfpgaf_c2c_3d_ddr(const unsigned N, const float2 *inp, float2 *out, con
   fpga_t fft_time = {0.0, 0.0, 0.0, 0};
   cl_int status = 0;
   unsigned num_pts = N * N * N;
-  // 0 - WR_GLOBALMEM, 1 - RD_GLOBALMEM, 2 - BATCH
-  int mode = WR_GLOBALMEM;
   
   // if N is not a power of 2
   if(inp == NULL || out == NULL || ( (N & (N-1)) !=0)){
     return fft_time;
   }
 
-  // Can't pass bool to device, so convert it to int
-  int inverse_int = (int)inv;
-
-  // Setup kernels
-  cl_kernel fetch_kernel = clCreateKernel(program, "fetch", &status);
-  checkError(status, "Failed to create fetch kernel");
-  cl_kernel ffta_kernel = clCreateKernel(program, "fft3da", &status);
-  checkError(status, "Failed to create fft3da kernel");
-  cl_kernel transpose_kernel = clCreateKernel(program, "transpose", &status);
-  checkError(status, "Failed to create transpose kernel");
-  cl_kernel fftb_kernel = clCreateKernel(program, "fft3db", &status);
-  checkError(status, "Failed to create fft3db kernel");
-  cl_kernel transpose3D_kernel = clCreateKernel(program, "transpose3D", &status);
-  checkError(status, "Failed to create transpose3D kernel");
-  cl_kernel fftc_kernel = clCreateKernel(program, "fft3dc", &status);
-  checkError(status, "Failed to create fft3dc kernel");
-  cl_kernel store_kernel = clCreateKernel(program, "store", &status);
-  checkError(status, "Failed to create store kernel");
+  // Setup kernels, the stages of the fft3d_ddr_autorun bitstream are not launched
+  ddr_pipeline_t pipe = ddr_pipeline_create(N);
 
   // Setup Queues to the kernels
   queue_setup();
 
   // Device memory buffers
-  cl_mem d_inData, d_transpose, d_outData;
+  cl_mem d_inData, d_outData;
   d_inData = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA, sizeof(float2) * num_pts, NULL, &status);
   checkError(status, "Failed to allocate input device buffer\n");
 
-  d_transpose = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_CHANNEL_2_INTELFPGA, sizeof(float2) * num_pts, NULL, &status);
-  checkError(status, "Failed to allocate output device buffer\n");
+  ddr_transpose_t d_transpose = ddr_transpose_create(&pipe, N, CL_CHANNEL_2_INTELFPGA);
 
   d_outData = clCreateBuffer(context, CL_MEM_WRITE_ONLY | CL_CHANNEL_1_INTELFPGA, sizeof(float2) * num_pts, NULL, &status);
   checkError(status, "Failed to allocate output device buffer\n");
@@ -264,147 +245,222 @@ fpga_t fftfpgaf_c2c_3d_ddr(const unsigned N, const float2 *inp, float2 *out, con
 
   fft_time.pcie_write_t = (cl_double)(writeBuf_end - writeBuf_start) * (cl_double)(1e-06); 
 
-  status=clSetKernelArg(fetch_kernel, 0, sizeof(cl_mem), (void *)&d_inData);
-  checkError(status, "Failed to set fetch kernel arg");
-
-  status=clSetKernelArg(ffta_kernel, 0, sizeof(cl_int), (void*)&inverse_int);
-  checkError(status, "Failed to set ffta kernel arg");
-  status=clSetKernelArg(fftb_kernel, 0, sizeof(cl_int), (void*)&inverse_int);
-  checkError(status, "Failed to set fftb kernel arg");
+  // Kernel Execution, points in natural order
+  fft_time.exec_t = ddr_pipeline_run(&pipe, d_inData, &d_transpose, d_outData, inv, false, false);
 
-  status=clSetKernelArg(transpose3D_kernel, 0, sizeof(cl_mem), (void *)&d_transpose);
-  checkError(status, "Failed to set transpose3D kernel arg 0");
+  // Copy results from device to host
+  cl_event readBuf_event;
+  status = clEnqueueReadBuffer(queue1, d_outData, CL_TRUE, 0, sizeof(float2) * num_pts, out, 0, NULL, &readBuf_event);
+  checkError(status, "Failed to copy data from device to host");
+  status = clFinish(queue1);
+  checkError(status, "failed to finish reading DDR using PCIe");
 
-  status=clSetKernelArg(transpose3D_kernel, 1, sizeof(cl_mem), (void *)&d_transpose);
-  checkError(status, "Failed to set transpose3D kernel arg 1");
+  cl_ulong readBuf_start = 0, readBuf_end = 0;
+  clGetEventProfilingInfo(readBuf_event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &readBuf_start, NULL);
+  clGetEventProfilingInfo(readBuf_event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &readBuf_end, NULL);
 
-  mode = WR_GLOBALMEM;
-  status=clSetKernelArg(transpose3D_kernel, 2, sizeof(cl_int), (void*)&mode);
-  checkError(status, "Failed to set transpose3D kernel arg 2");
+  fft_time.pcie_read_t = (cl_double)(readBuf_end - readBuf_start) * (cl_double)(1e-06); 
 
-  status=clSetKernelArg(fftc_kernel, 0, sizeof(cl_int), (void*)&inverse_int);
-  checkError(status, "Failed to set fftc kernel arg");
-  status=clSetKernelArg(store_kernel, 0, sizeof(cl_mem), (void *)&d_outData);
-  checkError(status, "Failed to set store2 kernel arg");
+  queue_cleanup();
 
-  // Kernel Execution
-  cl_event startExec_event, endExec_event;
-  status = clEnqueueTask(queue7, store_kernel, 0, NULL, &endExec_event);
-  checkError(status, "Failed to launch transpose kernel");
+  if (d_inData)
+    clReleaseMemObject(d_inData);
+  if (d_outData) 
+    clReleaseMemObject(d_outData);
+  ddr_transpose_release(&d_transpose);
 
-  status = clEnqueueTask(queue6, fftc_kernel, 0, NULL, NULL);
-  checkError(status, "Failed to launch fft kernel");
+  ddr_pipeline_release(&pipe);
 
-  status = clEnqueueTask(queue5, transpose3D_kernel, 0, NULL, NULL);
-  checkError(status, "Failed to launch write of transpose3d kernel");
+  fft_time.valid = 1;
+  return fft_time;
+}
 
-  // enqueue fetch to same queue as the store kernel due to data dependency
-  // therefore, not swapped
-  mode = RD_GLOBALMEM;
-  status=clSetKernelArg(transpose3D_kernel, 2, sizeof(cl_int), (void*)&mode);
-  checkError(status, "Failed to set transpose3D kernel arg 2");
+/**
+ * \brief  compute a batch of 3D FFTs with the replicated pipelines of the fft3d_ddr_multi bitstream. The transforms are distributed to the pipelines in turn. Every pipeline has its own queues and buffers, the input and output in one DDR bank and two 3D Transpose buffers in another, so that the transfers and computations of a pipeline are ordered by its queues and proceed concurrently with those of the other pipelines. The transforms of a pipeline alternate between its transpose buffers, overlapping the write of the 3D Transpose of a transform with the read of the previous one. The execution time spans the kernels of all pipelines, from the first fetch to the last store, and the transfer times are the sums of the transfers of all transforms.
+ * \param  N        : unsigned integer denoting the size of FFT3d
+ * \param  inp      : float2 pointer to input data of size [how_many * N * N * N]
+ * \param  out      : float2 pointer to output data of size [how_many * N * N * N]
+ * \param  inv      : toggle to activate backward FFT
+ * \param  how_many : number of batched computations
+ * \return fpga_t : time taken in milliseconds for data transfers and execution, the transfers overlapping the execution
+ */
+static fpga_t ddr_batch_replicated(const unsigned N, const float2 *inp, float2 *out, const bool inv, const unsigned how_many){
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0};
+  cl_int status = 0;
+  const size_t num_pts = (size_t)N * N * N;
+  const unsigned replicas = ddr_pipeline_replicas();
+  const cl_mem_flags banks[4] = {CL_CHANNEL_1_INTELFPGA, CL_CHANNEL_2_INTELFPGA, CL_CHANNEL_3_INTELFPGA, CL_CHANNEL_4_INTELFPGA};
 
-  status = clEnqueueTask(queue5, transpose3D_kernel, 0, NULL, NULL);
-  checkError(status, "Failed to launch read of transpose3d kernel");
+  // if N is not a power of 2
+  if(inp == NULL || out == NULL || ( (N & (N-1)) !=0) || (how_many <= 1)){
+    return fft_time;
+  }
 
-  status = clEnqueueTask(queue4, fftb_kernel, 0, NULL, NULL);
-  checkError(status, "Failed to launch second fft kernel");
+  // events of each transform: its write, the fetch and store kernels and its read
+  cl_event *events = (cl_event *)malloc(4 * (size_t)how_many * sizeof(cl_event));
+  if(events == NULL){
+    return fft_time;
+  }
 
-  status = clEnqueueTask(queue3, transpose_kernel, 0, NULL, NULL);
-  checkError(status, "Failed to launch transpose kernel");
+  ddr_pipeline_t pipe[DDR_PIPELINES_MAX];
+  cl_command_queue queues[DDR_PIPELINES_MAX][8];
+  cl_mem d_inData[DDR_PIPELINES_MAX], d_outData[DDR_PIPELINES_MAX];
+  ddr_transpose_t d_transpose[DDR_PIPELINES_MAX][2];
 
-  status = clEnqueueTask(queue2, ffta_kernel, 0, NULL, NULL);
-  checkError(status, "Failed to launch fft kernel");
+  for(unsigned p = 0; p < replicas; p++){
+    pipe[p] = ddr_pipeline_create_replica(N, p);
 
-  status = clEnqueueTask(queue1, fetch_kernel, 0, NULL, &startExec_event);
-  checkError(status, "Failed to launch fetch kernel");
+    // one queue for each kernel of the pipeline, the transfers are ordered with the fetch and store kernels
+    for(unsigned q = 0; q < 8; q++){
+      queues[p][q] = clCreateCommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE, &status);
+      checkError(status, "Failed to create command queue of pipeline");
+    }
 
-  status = clFinish(queue1);
-  checkError(status, "failed to finish queue1");
-  status = clFinish(queue2);
-  checkError(status, "failed to finish queue2");
-  status = clFinish(queue3);
-  checkError(status, "failed to finish queue3");
-  status = clFinish(queue4);
-  checkError(status, "failed to finish queue4");
-  status = clFinish(queue5);
-  checkError(status, "failed to finish queue5");
-  status = clFinish(queue6);
-  checkError(status, "failed to finish queue6");
-  status = clFinish(queue7);
-  checkError(status, "failed to finish queue7");
+    // pipelines in different pairs of banks
+    const cl_mem_flags data_bank = banks[(2 * p) % 4];
+    const cl_mem_flags transpose_bank = banks[(2 * p + 1) % 4];
 
-  cl_ulong kernel_start = 0, kernel_end = 0;
-  clGetEventProfilingInfo(startExec_event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &kernel_start, NULL);
-  clGetEventProfilingInfo(endExec_event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &kernel_end, NULL);
+    d_inData[p] = clCreateBuffer(context, CL_MEM_READ_ONLY | data_bank, sizeof(float2) * num_pts, NULL, &status);
+    checkError(status, "Failed to allocate input device buffer\n");
+    d_outData[p] = clCreateBuffer(context, CL_MEM_WRITE_ONLY | data_bank, sizeof(float2) * num_pts, NULL, &status);
+    checkError(status, "Failed to allocate output device buffer\n");
+    for(unsigned b = 0; b < 2; b++){
+      d_transpose[p][b] = ddr_transpose_create(&pipe[p], N, transpose_bank);
+    }
+  }
 
-  fft_time.exec_t = (cl_double)(kernel_end - kernel_start) * (cl_double)(1e-06); 
+  for(unsigned i = 0; i < how_many; i++){
+    const unsigned p = i % replicas;
+    cl_event *event = &events[4 * (size_t)i];
 
-  // Copy results from device to host
-  cl_event readBuf_event;
-  status = clEnqueueReadBuffer(queue1, d_outData, CL_TRUE, 0, sizeof(float2) * num_pts, out, 0, NULL, &readBuf_event);
-  checkError(status, "Failed to copy data from device to host");
-  status = clFinish(queue1);
-  checkError(status, "failed to finish reading DDR using PCIe");
+    // the write follows the fetch of the previous transform of the pipeline and the read its store
+    status = clEnqueueWriteBuffer(queues[p][0], d_inData[p], CL_FALSE, 0, sizeof(float2) * num_pts, &inp[i * num_pts], 0, NULL, &event[0]);
+    checkError(status, "Failed to write to DDR buffer");
 
-  cl_ulong readBuf_start = 0, readBuf_end = 0;
-  clGetEventProfilingInfo(readBuf_event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &readBuf_start, NULL);
-  clGetEventProfilingInfo(readBuf_event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &readBuf_end, NULL);
+    // successive transforms of the pipeline alternate between its transpose buffers
+    ddr_transpose_t *d_transpose_item = &d_transpose[p][(i / replicas) % 2];
+    ddr_pipeline_enqueue(&pipe[p], queues[p], d_inData[p], d_transpose_item, d_outData[p], inv, false, false, &event[1], &event[2]);
 
-  fft_time.pcie_read_t = (cl_double)(readBuf_end - readBuf_start) * (cl_double)(1e-06); 
+    status = clEnqueueReadBuffer(queues[p][7], d_outData[p], CL_FALSE, 0, sizeof(float2) * num_pts, &out[i * num_pts], 0, NULL, &event[3]);
+    checkError(status, "Failed to read from DDR buffer");
+  }
 
-  queue_cleanup();
+  for(unsigned p = 0; p < replicas; p++){
+    for(unsigned q = 0; q < 8; q++){
+      status = clFinish(queues[p][q]);
+      checkError(status, "failed to finish queue of pipeline");
+    }
+  }
 
-  if (d_inData)
-    clReleaseMemObject(d_inData);
-  if (d_outData) 
-    clReleaseMemObject(d_outData);
-  if (d_transpose) 
-    clReleaseMemObject(d_transpose);
+  // the kernels of all pipelines run from the first fetch to the last store
+  cl_ulong kernel_start = 0, kernel_end = 0;
+  for(unsigned i = 0; i < how_many; i++){
+    cl_event *event = &events[4 * (size_t)i];
+    cl_ulong start = 0, end = 0;
+
+    clGetEventProfilingInfo(event[0], CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start, NULL);
+    clGetEventProfilingInfo(event[0], CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, NULL);
+    fft_time.pcie_write_t += (cl_double)(end - start) * (cl_double)(1e-06);
+
+    clGetEventProfilingInfo(event[1], CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start, NULL);
+    clGetEventProfilingInfo(event[2], CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, NULL);
+    if(i == 0 || start < kernel_start)
+      kernel_start = start;
+    if(end > kernel_end)
+      kernel_end = end;
+
+    clGetEventProfilingInfo(event[3], CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start, NULL);
+    clGetEventProfilingInfo(event[3], CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, NULL);
+    fft_time.pcie_read_t += (cl_double)(end - start) * (cl_double)(1e-06);
+
+    for(unsigned e = 0; e < 4; e++){
+      clReleaseEvent(event[e]);
+    }
+  }
+  free(events);
 
-  if(fetch_kernel) 
-    clReleaseKernel(fetch_kernel);  
-  if(transpose3D_kernel) 
-    clReleaseKernel(transpose3D_kernel);  
+  fft_time.exec_t = (cl_double)(kernel_end - kernel_start) * (cl_double)(1e-06);
 
-  if(ffta_kernel) 
-    clReleaseKernel(ffta_kernel);  
-  if(fftb_kernel) 
-    clReleaseKernel(fftb_kernel);  
-  if(fftc_kernel) 
-    clReleaseKernel(fftc_kernel);  
+  for(unsigned p = 0; p < replicas; p++){
+    for(unsigned q = 0; q < 8; q++){
+      clReleaseCommandQueue(queues[p][q]);
+    }
 
-  if(transpose_kernel) 
-    clReleaseKernel(transpose_kernel);  
+    if (d_inData[p])
+      clReleaseMemObject(d_inData[p]);
+    if (d_outData[p])
+      clReleaseMemObject(d_outData[p]);
+    for(unsigned b = 0; b < 2; b++){
+      ddr_transpose_release(&d_transpose[p][b]);
+    }
 
-  if(store_kernel) 
-    clReleaseKernel(store_kernel);  
+    ddr_pipeline_release(&pipe[p]);
+  }
 
   fft_time.valid = 1;
   return fft_time;
 }
 
 /**
- * \brief compute an batched out-of-place single precision complex 3D-FFT using the DDR of the FPGA for 3D Transpose
+ * \brief compute an batched out-of-place single precision complex 3D-FFT using the DDR of the FPGA for 3D Transpose. With the fft3d_ddr_multi bitstream, the transforms are distributed to its replicated pipelines.
  * \param N    : unsigned integer denoting the size of FFT3d  
- * \param inp  : float2 pointer to input data of size [N * N * N]
- * \param out  : float2 pointer to output data of size [N * N * N]
+ * \param inp  : float2 pointer to input data of size [how_many * N * N * N]
+ * \param out  : float2 pointer to output data of size [how_many * N * N * N]
  * \param inv  : toggle to activate backward FFT
- * \param interleaving : enable burst interleaved global memory buffers
+ * \param interleaving : enable burst interleaved global memory buffers, ignored by the replicated pipelines that bind their buffers to banks
  * \param how_many : number of batched computations
  * \return fpga_t : time taken in milliseconds for data transfers and execution
  */
 fpga_t fftfpgaf_c2c_3d_ddr_batch(const unsigned N, const float2 *inp, float2 *out, const bool inv, const bool interleaving, const unsigned how_many) {
+  const size_t num_pts = (size_t)N * N * N;
+
+  if(ddr_pipeline_replicas() > 0){
+    return ddr_batch_replicated(N, inp, out, inv, how_many);
+  }
+  return fftfpgaf_c2c_3d_ddr_batch_many(N, inp, 1, num_pts, out, 1, num_pts, inv, interleaving, how_many);
+}
+
+/**
+ * \brief compute a batched out-of-place single precision complex 3D-FFT using the DDR of the FPGA for 3D Transpose, with the layout of the advanced interface of FFTW. The transforms are transferred from and to their place in the host arrays without gathering them. The kernels loop over the batch, computed by a single launch of each kernel if it fits into the DDR banks. Otherwise it is split into pieces, each computed by a launch of the kernels, and the input and output of consecutive pieces alternate between two buffers, so that the transfers of the next and previous pieces overlap the computation of a piece.
+ * \param N       : unsigned integer denoting the size of FFT3d
+ * \param inp     : float2 pointer to input data
+ * \param istride : distance between consecutive points of an input transform, 1 as the points of a transform are contiguous
+ * \param idist   : distance between the first points of consecutive input transforms
+ * \param out     : float2 pointer to output data
+ * \param ostride : distance between consecutive points of an output transform, 1 as the points of a transform are contiguous
+ * \param odist   : distance between the first points of consecutive output transforms
+ * \param inv     : toggle to activate backward FFT
+ * \param interleaving : enable burst interleaved global memory buffers
+ * \param how_many : number of batched computations
+ * \return fpga_t : time taken in milliseconds for data transfers and execution of the kernels, the transfers overlapping the execution
+ */
+fpga_t fftfpgaf_c2c_3d_ddr_batch_many(const unsigned N, const float2 *inp, const size_t istride, const size_t idist, float2 *out, const size_t ostride, const size_t odist, const bool inv, const bool interleaving, const unsigned how_many) {
   fpga_t fft_time = {0.0, 0.0, 0.0, 0};
   cl_int status = 0;
-  unsigned num_pts = N * N * N;
-  int mode = WR_GLOBALMEM;
+  const size_t num_pts = (size_t)N * N * N;
   
   // if N is not a power of 2
   if(inp == NULL || out == NULL || ( (N & (N-1)) !=0) || (how_many <= 1)){
     return fft_time;
   }
 
+  if(!layout_valid(num_pts, how_many, istride, idist) || !layout_valid(num_pts, how_many, ostride, odist)){
+    return fft_time;
+  }
+
+  // transforms per launch of the kernels
+  const unsigned piece = ddr_batch_piece(N, how_many);
+  if(piece == 0){
+    return fft_time;
+  }
+  const unsigned num_pieces = (how_many + piece - 1) / piece;
+
+  // events of each piece: its write, the fetch and store kernels and its read
+  cl_event *events = (cl_event *)malloc(4 * (size_t)num_pieces * sizeof(cl_event));
+  if(events == NULL){
+    return fft_time;
+  }
+
   // Can't pass bool to device, so convert it to int
   const int inverse_int = (int)inv;
 
@@ -424,491 +480,366 @@ fpga_t fftfpgaf_c2c_3d_ddr_batch(const unsigned N, const float2 *inp, float2 *ou
   cl_kernel store_kernel = clCreateKernel(program, "store", &status);
   checkError(status, "Failed to create store kernel");
 
-  // Setup Queues to the kernels
+  // Setup Queues to the kernels, the writes and the reads are transferred on queues of their own to overlap with the kernels
   queue_setup();
+  cl_command_queue write_queue = clCreateCommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE, &status);
+  checkError(status, "Failed to create command queue of writes");
+  cl_command_queue read_queue = clCreateCommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE, &status);
+  checkError(status, "Failed to create command queue of reads");
+
+  // Device memory buffers of a piece, of two if the pieces alternate between them:
+  // input in the 1st bank, output in the 2nd
+  // The 3D Transpose alternates between two buffers, using 3rd and 4th banks
+  const unsigned num_buffers = (num_pieces > 1) ? 2 : 1;
+  cl_mem d_inData[2] = {NULL, NULL}, d_outData[2] = {NULL, NULL};
+  for(unsigned b = 0; b < num_buffers; b++){
+    d_inData[b] = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA, sizeof(float2) * num_pts * piece, NULL, &status);
+    checkError(status, "Failed to allocate input device buffer\n");
+
+    d_outData[b] = clCreateBuffer(context, CL_MEM_WRITE_ONLY | CL_CHANNEL_2_INTELFPGA, sizeof(float2) * num_pts * piece, NULL, &status);
+    checkError(status, "Failed to allocate output device buffer\n");
+  }
 
-  // Device memory buffers: using 1st and 2nd banks
-  // Double Buffers, using 3rd and 4th banks
-  cl_mem d_inData1 = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA, sizeof(float2) * num_pts, NULL, &status);
-  checkError(status, "Failed to allocate input device buffer\n");
-
-  cl_mem d_inData2 = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_CHANNEL_2_INTELFPGA, sizeof(float2) * num_pts, NULL, &status);
-  checkError(status, "Failed to allocate input device buffer\n");
-
-  cl_mem d_inData3 = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_CHANNEL_3_INTELFPGA, sizeof(float2) * num_pts, NULL, &status);
-  checkError(status, "Failed to allocate input device buffer\n");
-
-  cl_mem d_inData4 = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_CHANNEL_4_INTELFPGA, sizeof(float2) * num_pts, NULL, &status);
-  checkError(status, "Failed to allocate input device buffer\n");
-
-  cl_mem d_outData1 = clCreateBuffer(context, CL_MEM_WRITE_ONLY | CL_CHANNEL_1_INTELFPGA, sizeof(float2) * num_pts, NULL, &status);
-  checkError(status, "Failed to allocate output device buffer\n");
-
-  cl_mem d_outData2 = clCreateBuffer(context, CL_MEM_WRITE_ONLY | CL_CHANNEL_2_INTELFPGA, sizeof(float2) * num_pts, NULL, &status);
-  checkError(status, "Failed to allocate output device buffer\n");
-
-  cl_mem d_outData3 = clCreateBuffer(context, CL_MEM_WRITE_ONLY | CL_CHANNEL_3_INTELFPGA, sizeof(float2) * num_pts, NULL, &status);
-  checkError(status, "Failed to allocate output device buffer\n");
-
-  cl_mem d_outData4 = clCreateBuffer(context, CL_MEM_WRITE_ONLY | CL_CHANNEL_4_INTELFPGA, sizeof(float2) * num_pts, NULL, &status);
-  checkError(status, "Failed to allocate output device buffer\n");
-
-  cl_mem d_transpose1 = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_CHANNEL_1_INTELFPGA, sizeof(float2) * num_pts, NULL, &status);
-  checkError(status, "Failed to allocate output device buffer\n");
-
-  cl_mem d_transpose2 = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_CHANNEL_2_INTELFPGA, sizeof(float2) * num_pts, NULL, &status);
-  checkError(status, "Failed to allocate output device buffer\n");
-
-  cl_mem d_transpose3 = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_CHANNEL_3_INTELFPGA, sizeof(float2) * num_pts, NULL, &status);
-  checkError(status, "Failed to allocate output device buffer\n");
+  cl_mem d_transposeA = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_CHANNEL_3_INTELFPGA, sizeof(float2) * num_pts, NULL, &status);
+  checkError(status, "Failed to allocate transpose device buffer\n");
 
-  cl_mem d_transpose4 = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_CHANNEL_4_INTELFPGA, sizeof(float2) * num_pts, NULL, &status);
-  checkError(status, "Failed to allocate output device buffer\n");
+  cl_mem d_transposeB = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_CHANNEL_4_INTELFPGA, sizeof(float2) * num_pts, NULL, &status);
+  checkError(status, "Failed to allocate transpose device buffer\n");
 
-  // Default Kernel Arguments
-  status=clSetKernelArg(fetch_kernel, 0, sizeof(cl_mem), (void *)&d_inData1);
-  checkError(status, "Failed to set fetch kernel arg");
+  // Kernel Arguments common to the pieces
   status=clSetKernelArg(ffta_kernel, 0, sizeof(cl_int), (void*)&inverse_int);
-  checkError(status, "Failed to set ffta kernel arg");
+  checkError(status, "Failed to set ffta kernel arg 0");
   status=clSetKernelArg(fftb_kernel, 0, sizeof(cl_int), (void*)&inverse_int);
-  checkError(status, "Failed to set fftb kernel arg");
-
-  /* Write into the mem and read from the same. Mode is at first write */
-  status=clSetKernelArg(transpose3D_kernel, 0, sizeof(cl_mem), (void *)&d_transpose3);
-  checkError(status, "Failed to set transpose3D_kernel kernel arg 0");
-  status=clSetKernelArg(transpose3D_kernel, 1, sizeof(cl_mem), (void *)&d_transpose3);
-  checkError(status, "Failed to set transpose3D_kernel kernel arg 1");
-  mode = WR_GLOBALMEM;
-  status=clSetKernelArg(transpose3D_kernel, 2, sizeof(cl_int), (void*)&mode);
-  checkError(status, "Failed to set transpose3D kernel arg 2");
-
+  checkError(status, "Failed to set fftb kernel arg 0");
   status=clSetKernelArg(fftc_kernel, 0, sizeof(cl_int), (void*)&inverse_int);
-  checkError(status, "Failed to set fftc kernel arg");
-  status=clSetKernelArg(store_kernel, 0, sizeof(cl_mem), (void *)&d_outData1);
-  checkError(status, "Failed to set store kernel arg");
-
-  fft_time.exec_t = getTimeinMilliSec();
+  checkError(status, "Failed to set fftc kernel arg 0");
 
-  // First Phase 
-  // Write to DDR first buffer
-  status = clEnqueueWriteBuffer(queue1, d_inData1, CL_TRUE, 0, sizeof(float2) * num_pts, inp, 0, NULL, NULL);
-
-  status = clFinish(queue1);
-  checkError(status, "failed to finish queue1");
-
-  // Second Phase
-  // Unblocking write to DDR second buffer from index num_pts
-  cl_event write_event[2];
-  status = clEnqueueWriteBuffer(queue6, d_inData2, CL_FALSE, 0, sizeof(float2) * num_pts, (void*)&inp[num_pts], 0, NULL, &write_event[0]);
-  checkError(status, "Failed to write to DDR buffer");
-
-  // Compute First FFT already transferred
-  status = clEnqueueTask(queue1, fetch_kernel, 0, NULL, NULL);
-  checkError(status, "Failed to launch fetch kernel");
-
-  status = clEnqueueTask(queue2, ffta_kernel, 0, NULL, NULL);
-  checkError(status, "Failed to launch fft kernel");
+  status=clSetKernelArg(transpose3D_kernel, 0, sizeof(cl_mem), (void *)&d_transposeA);
+  checkError(status, "Failed to set transpose3D kernel arg 0");
+  status=clSetKernelArg(transpose3D_kernel, 1, sizeof(cl_mem), (void *)&d_transposeB);
+  checkError(status, "Failed to set transpose3D kernel arg 1");
 
-  status = clEnqueueTask(queue3, transpose_kernel, 0, NULL, NULL);
-  checkError(status, "Failed to launch transpose kernel");
+  for(unsigned i = 0; i < num_pieces; i++){
+    const unsigned first = i * piece;
+    const cl_uint count = (how_many - first < piece) ? (how_many - first) : piece;
+    const unsigned b = i % num_buffers;
+    cl_event *event = &events[4 * (size_t)i];
+
+    // the buffers of a piece are reused by the piece after the next, once it has been fetched and read back
+    const cl_uint num_wait = (i >= 2) ? 1 : 0;
+    const cl_event *fetched = (i >= 2) ? &events[4 * (size_t)(i - 2) + 1] : NULL;
+    const cl_event *read_back = (i >= 2) ? &events[4 * (size_t)(i - 2) + 3] : NULL;
+
+    buffer_enqueue_strided(write_queue, d_inData[b], true, num_pts, count, (void*)&inp[first * idist], idist, num_wait, fetched, &event[0]);
+
+    // Kernel Arguments of the piece, every kernel loops over it
+    status=clSetKernelArg(fetch_kernel, 0, sizeof(cl_mem), (void *)&d_inData[b]);
+    checkError(status, "Failed to set fetch kernel arg 0");
+    status=clSetKernelArg(fetch_kernel, 1, sizeof(cl_uint), (void *)&count);
+    checkError(status, "Failed to set fetch kernel arg 1");
+    status=clSetKernelArg(ffta_kernel, 1, sizeof(cl_uint), (void *)&count);
+    checkError(status, "Failed to set ffta kernel arg 1");
+    status=clSetKernelArg(transpose_kernel, 0, sizeof(cl_uint), (void *)&count);
+    checkError(status, "Failed to set transpose kernel arg 0");
+    status=clSetKernelArg(fftb_kernel, 1, sizeof(cl_uint), (void *)&count);
+    checkError(status, "Failed to set fftb kernel arg 1");
+    status=clSetKernelArg(transpose3D_kernel, 2, sizeof(cl_uint), (void *)&count);
+    checkError(status, "Failed to set transpose3D kernel arg 2");
+    status=clSetKernelArg(fftc_kernel, 1, sizeof(cl_uint), (void *)&count);
+    checkError(status, "Failed to set fftc kernel arg 1");
+    status=clSetKernelArg(store_kernel, 0, sizeof(cl_mem), (void *)&d_outData[b]);
+    checkError(status, "Failed to set store kernel arg 0");
+    status=clSetKernelArg(store_kernel, 1, sizeof(cl_uint), (void *)&count);
+    checkError(status, "Failed to set store kernel arg 1");
+
+    // A single launch of the kernels computes the piece, the fetch waits for its write
+    status = clEnqueueTask(queue1, fetch_kernel, 1, &event[0], &event[1]);
+    checkError(status, "Failed to launch fetch kernel");
 
-  status = clEnqueueTask(queue4, fftb_kernel, 0, NULL, NULL);
-  checkError(status, "Failed to launch second fft kernel");
+    status = clEnqueueTask(queue2, ffta_kernel, 0, NULL, NULL);
+    checkError(status, "Failed to launch fft kernel");
 
-  status = clEnqueueTask(queue5, transpose3D_kernel, 0, NULL, NULL);
-  checkError(status, "Failed to launch transpose3D_kernel kernel");
+    status = clEnqueueTask(queue3, transpose_kernel, 0, NULL, NULL);
+    checkError(status, "Failed to launch transpose kernel");
 
-  mode = RD_GLOBALMEM;
-  status=clSetKernelArg(transpose3D_kernel, 2, sizeof(cl_int), (void*)&mode);
-  checkError(status, "Failed to set transpose3D kernel arg 2");
+    status = clEnqueueTask(queue4, fftb_kernel, 0, NULL, NULL);
+    checkError(status, "Failed to launch second fft kernel");
 
-  status = clEnqueueTask(queue5, transpose3D_kernel, 0, NULL, NULL);
-  checkError(status, "Failed to launch transpose3D_kernel kernel");
+    status = clEnqueueTask(queue5, transpose3D_kernel, 0, NULL, NULL);
+    checkError(status, "Failed to launch transpose3D kernel");
 
-  status = clEnqueueTask(queue4, fftc_kernel, 0, NULL, NULL);
-  checkError(status, "Failed to launch fft kernel");
+    status = clEnqueueTask(queue6, fftc_kernel, 0, NULL, NULL);
+    checkError(status, "Failed to launch third fft kernel");
 
-  status = clEnqueueTask(queue3, store_kernel, 0, NULL, NULL);
-  checkError(status, "Failed to launch store kernel");
+    status = clEnqueueTask(queue7, store_kernel, num_wait, read_back, &event[2]);
+    checkError(status, "Failed to launch store kernel");
 
-  // Check finish of transfer and computations
-  clWaitForEvents(1, &write_event[0]);
-  clReleaseEvent(write_event[0]);
+    buffer_enqueue_strided(read_queue, d_outData[b], false, num_pts, count, (void*)&out[first * odist], odist, 1, &event[2], &event[3]);
+  }
 
-  status = clFinish(queue6);
-  checkError(status, "failed to finish queue 6");
-  status = clFinish(queue5);
-  checkError(status, "failed to finish queue 5");
-  status = clFinish(queue4);
-  checkError(status, "failed to finish queue 4");
-  status = clFinish(queue3);
-  checkError(status, "failed to finish queue 3");
-  status = clFinish(queue2);
-  checkError(status, "failed to finish queue 2");
+  status = clFinish(write_queue);
+  checkError(status, "failed to finish queue of writes");
   status = clFinish(queue1);
-  checkError(status, "failed to finish queue 1");
-
-  // Loop over the 3 stages
-  for(size_t i = 0; i < how_many-2; i++){
+  checkError(status, "failed to finish queue1");
+  status = clFinish(queue2);
+  checkError(status, "failed to finish queue2");
+  status = clFinish(queue3);
+  checkError(status, "failed to finish queue3");
+  status = clFinish(queue4);
+  checkError(status, "failed to finish queue4");
+  status = clFinish(queue5);
+  checkError(status, "failed to finish queue5");
+  status = clFinish(queue6);
+  checkError(status, "failed to finish queue6");
+  status = clFinish(queue7);
+  checkError(status, "failed to finish queue7");
+  status = clFinish(read_queue);
+  checkError(status, "failed to finish queue of reads");
+
+  // kernel time of the pieces, excluding the time the pipeline waits for
+  // transfers between them and counting once the drain of a piece
+  // overlapping the start of the next one
+  cl_ulong prev_end = 0;
+  for(unsigned i = 0; i < num_pieces; i++){
+    cl_event *event = &events[4 * (size_t)i];
+    cl_ulong start = 0, end = 0;
+
+    clGetEventProfilingInfo(event[0], CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start, NULL);
+    clGetEventProfilingInfo(event[0], CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, NULL);
+    fft_time.pcie_write_t += (cl_double)(end - start) * (cl_double)(1e-06);
+
+    clGetEventProfilingInfo(event[1], CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start, NULL);
+    clGetEventProfilingInfo(event[2], CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, NULL);
+    if(start < prev_end)
+      start = prev_end;
+    fft_time.exec_t += (cl_double)(end - start) * (cl_double)(1e-06);
+    prev_end = end;
+
+    clGetEventProfilingInfo(event[3], CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start, NULL);
+    clGetEventProfilingInfo(event[3], CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, NULL);
+    fft_time.pcie_read_t += (cl_double)(end - start) * (cl_double)(1e-06);
+
+    for(unsigned e = 0; e < 4; e++){
+      clReleaseEvent(event[e]);
+    }
+  }
+  free(events);
 
-    // Unblocking transfers between DDR and host 
-    if( (i % 4) == 0){
-      status = clEnqueueWriteBuffer(queue7, d_inData3, CL_FALSE, 0, sizeof(float2) * num_pts, &inp[( (i+2) * num_pts)], 0, NULL, &write_event[1]);
-      checkError(status, "Failed to write to DDR buffer");
+  clReleaseCommandQueue(write_queue);
+  clReleaseCommandQueue(read_queue);
+  queue_cleanup();
 
-      status = clEnqueueReadBuffer(queue6, d_outData1, CL_FALSE, 0, sizeof(float2) * num_pts, &out[(i * num_pts)], 0, NULL, &write_event[0]);
-      checkError(status, "Failed to read from DDR buffer");
+  for(unsigned b = 0; b < 2; b++){
+    if (d_inData[b])
+      clReleaseMemObject(d_inData[b]);
+    if (d_outData[b]) 
+      clReleaseMemObject(d_outData[b]);
+  }
+  if (d_transposeA) 
+    clReleaseMemObject(d_transposeA);
+  if (d_transposeB) 
+    clReleaseMemObject(d_transposeB);
 
-      status=clSetKernelArg(fetch_kernel, 0, sizeof(cl_mem), (void *)&d_inData2);
-      checkError(status, "Failed to set fetch1 kernel arg");
-    
-      status=clSetKernelArg(transpose3D_kernel, 0, sizeof(cl_mem), (void *)&d_transpose4);
-      checkError(status, "Failed to set transpose3D_kernel kernel arg 0");
+  if(fetch_kernel) 
+    clReleaseKernel(fetch_kernel);  
+  if(transpose3D_kernel) 
+    clReleaseKernel(transpose3D_kernel);  
 
-      status=clSetKernelArg(transpose3D_kernel, 1, sizeof(cl_mem), (void *)&d_transpose4);
-      checkError(status, "Failed to set transpose3D_kernel kernel arg 1");
+  if(ffta_kernel) 
+    clReleaseKernel(ffta_kernel);  
+  if(fftb_kernel) 
+    clReleaseKernel(fftb_kernel);  
+  if(fftc_kernel) 
+    clReleaseKernel(fftc_kernel);  
 
-      mode = WR_GLOBALMEM;
-      status=clSetKernelArg(transpose3D_kernel, 2, sizeof(cl_int), (void*)&mode);
-      checkError(status, "Failed to set transpose3D kernel arg 2");
+  if(transpose_kernel) 
+    clReleaseKernel(transpose_kernel);  
 
-      status=clSetKernelArg(store_kernel, 0, sizeof(cl_mem), (void *)&d_outData2);
-      checkError(status, "Failed to set store2 kernel arg");
-    }
-    else if( (i % 4) == 1){
-      status = clEnqueueWriteBuffer(queue7, d_inData4, CL_FALSE, 0, sizeof(float2) * num_pts, &inp[((i + 2) * num_pts)], 0, NULL, &write_event[1]);
-      checkError(status, "Failed to write to DDR buffer");
+  if(store_kernel) 
+    clReleaseKernel(store_kernel);  
 
-      status = clEnqueueReadBuffer(queue6, d_outData2, CL_FALSE, 0, sizeof(float2) * num_pts, &out[(i * num_pts)], 0, NULL, &write_event[0]);
-      checkError(status, "Failed to read from DDR buffer");
+  fft_time.valid = 1;
+  return fft_time;
+}
 
-      status=clSetKernelArg(fetch_kernel, 0, sizeof(cl_mem), (void *)&d_inData3);
-      checkError(status, "Failed to set fetch kernel arg");
-    
-      status=clSetKernelArg(transpose3D_kernel, 0, sizeof(cl_mem), (void *)&d_transpose1);
-      checkError(status, "Failed to set transpose3D_kernel kernel arg 0");
+/**
+ * \brief  compute a single precision complex 3D-FFT of a buffer on the FPGA into another using the DDR of the FPGA for 3D Transpose, without transfers to or from the host
+ * \param  N    : unsigned integer denoting the size of FFT3d
+ * \param  inp  : handle to the device buffer of the input of at least [N * N * N] points
+ * \param  out  : handle to the device buffer of the output of at least [N * N * N] points, can be the same as inp
+ * \param  inv  : toggle to activate backward FFT
+ * \param  unordered : toggle for the forward FFT to write and the backward FFT to read the frequencies bit-reversed along each dimension
+ * \param  transposed : toggle to write the output in the layout [y][z][x] and to read the input of a backward FFT in this layout
+ * \return fpga_t : time taken in milliseconds for execution
+ */
+fpga_t fftfpgaf_c2c_3d_ddr_dev(const unsigned N, const fftfpga_buffer inp, fftfpga_buffer out, const bool inv, const bool unordered, const bool transposed) {
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0};
+  const unsigned num_pts = N * N * N;
 
-      status=clSetKernelArg(transpose3D_kernel, 1, sizeof(cl_mem), (void *)&d_transpose1);
-      checkError(status, "Failed to set transpose3D_kernel kernel arg 1");
+  // if N is not a power of 2
+  if(( (N & (N-1)) !=0) || N < 8 || !buffer_valid(inp, num_pts) || !buffer_valid(out, num_pts)){
+    return fft_time;
+  }
 
-      mode = WR_GLOBALMEM;
-      status=clSetKernelArg(transpose3D_kernel, 2, sizeof(cl_int), (void*)&mode);
-      checkError(status, "Failed to set transpose3D kernel arg 2");  
+  ddr_pipeline_t pipe = ddr_pipeline_create(N);
 
-      status=clSetKernelArg(store_kernel, 0, sizeof(cl_mem), (void *)&d_outData3);
-      checkError(status, "Failed to set store kernel arg");
-    }
-    else if( (i % 4) == 2){
-      status = clEnqueueWriteBuffer(queue7, d_inData1, CL_FALSE, 0, sizeof(float2) * num_pts, &inp[( (i + 2) * num_pts)], 0, NULL, &write_event[1]);
-      checkError(status, "Failed to write to DDR buffer");
+  queue_setup();
 
-      status = clEnqueueReadBuffer(queue6, d_outData3, CL_FALSE, 0, sizeof(float2) * num_pts, &out[(i * num_pts)], 0, NULL, &write_event[0]);
-      checkError(status, "Failed to read from DDR buffer");
+  ddr_transpose_t d_transpose = ddr_transpose_create(&pipe, N, CL_CHANNEL_2_INTELFPGA);
 
-      status=clSetKernelArg(fetch_kernel, 0, sizeof(cl_mem), (void *)&d_inData4);
-      checkError(status, "Failed to set fetch kernel arg");
-    
-      status=clSetKernelArg(transpose3D_kernel, 0, sizeof(cl_mem), (void *)&d_transpose2);
-      checkError(status, "Failed to set transpose3D_kernel kernel arg 0");
+  fft_time.exec_t = ddr_pipeline_run(&pipe, inp->mem, &d_transpose, out->mem, inv, unordered, transposed);
 
-      status=clSetKernelArg(transpose3D_kernel, 1, sizeof(cl_mem), (void *)&d_transpose2);
-      checkError(status, "Failed to set transpose3D_kernel kernel arg 1");
+  queue_cleanup();
 
-      mode = WR_GLOBALMEM;
-      status=clSetKernelArg(transpose3D_kernel, 2, sizeof(cl_int), (void*)&mode);
-      checkError(status, "Failed to set transpose3D kernel arg 2"); 
+  ddr_transpose_release(&d_transpose);
 
-      status=clSetKernelArg(store_kernel, 0, sizeof(cl_mem), (void *)&d_outData4);
-      checkError(status, "Failed to set store kernel arg");
-    }
-    else{
-      status = clEnqueueWriteBuffer(queue7, d_inData2, CL_FALSE, 0, sizeof(float2) * num_pts, &inp[( (i+2) * num_pts)], 0, NULL, &write_event[1]);
-      checkError(status, "Failed to write to DDR buffer");
+  ddr_pipeline_release(&pipe);
 
-      status = clEnqueueReadBuffer(queue6, d_outData4, CL_FALSE, 0, sizeof(float2) * num_pts, &out[(i * num_pts)], 0, NULL, &write_event[0]);
-      checkError(status, "Failed to read from DDR buffer");
+  fft_time.valid = 1;
+  return fft_time;
+}
 
-      status=clSetKernelArg(fetch_kernel, 0, sizeof(cl_mem), (void *)&d_inData1);
-      checkError(status, "Failed to set fetch kernel arg");
-    
-      status=clSetKernelArg(transpose3D_kernel, 0, sizeof(cl_mem), (void *)&d_transpose3);
-      checkError(status, "Failed to set transpose3D_kernel kernel arg 0");
+/**
+ * \brief  compute an out-of-place single precision complex 3D-FFT of an input that is zero outside of a sub-box using the DDR of the FPGA for 3D Transpose. Only the sub-box is transferred to the FPGA, the fetch kernel fills in the zeros.
+ * \param  N      : unsigned integer denoting the size of FFT3d
+ * \param  box    : size of the sub-box along x, y and z, the size along x being a multiple of 8
+ * \param  origin : first point of the sub-box along x, y and z, the sub-box wraps around periodically. The origin along x is a multiple of 8
+ * \param  inp    : float2 pointer to the points of the sub-box of size [box[2] * box[1] * box[0]] in the layout [z][y][x]
+ * \param  out    : float2 pointer to output data of size [N * N * N]
+ * \param  inv    : toggle to activate backward FFT
+ * \return fpga_t : time taken in milliseconds for data transfers and execution
+ */
+fpga_t fftfpgaf_c2c_3d_ddr_pruned(const unsigned N, const unsigned box[3], const unsigned origin[3], const float2 *inp, float2 *out, const bool inv) {
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0};
+  cl_int status = 0;
+  const unsigned num_pts = N * N * N;
 
-      status=clSetKernelArg(transpose3D_kernel, 1, sizeof(cl_mem), (void *)&d_transpose3);
-      checkError(status, "Failed to set transpose3D_kernel kernel arg 1");
+  // if N is not a power of 2
+  if(inp == NULL || out == NULL || box == NULL || origin == NULL || ( (N & (N-1)) !=0) || N < 8){
+    return fft_time;
+  }
 
-      mode = WR_GLOBALMEM;
-      status=clSetKernelArg(transpose3D_kernel, 2, sizeof(cl_int), (void*)&mode);
-      checkError(status, "Failed to set transpose3D kernel arg 2"); ;
+  // sub-box within the cube, read in whole groups of 8 points along x
+  for(unsigned i = 0; i < 3; i++){
+    if(box[i] == 0 || box[i] > N || origin[i] >= N)
+      return fft_time;
+  }
+  if((box[0] % 8) != 0 || (origin[0] % 8) != 0){
+    return fft_time;
+  }
+  const size_t box_pts = (size_t)box[0] * box[1] * box[2];
 
-      status=clSetKernelArg(store_kernel, 0, sizeof(cl_mem), (void *)&d_outData1);
-      checkError(status, "Failed to set store kernel arg");
-    }
+  ddr_pipeline_t pipe = ddr_pipeline_create(N);
+  ddr_pipeline_prune(&pipe, box, origin);
 
-    // Set Kernel Arguments before execution
-    status = clEnqueueTask(queue1, fetch_kernel, 0, NULL, NULL);
-    checkError(status, "Failed to launch fetch kernel");
+  queue_setup();
 
-    status = clEnqueueTask(queue2, ffta_kernel, 0, NULL, NULL);
-    checkError(status, "Failed to launch fft kernel");
+  // the sub-box is packed at the start of the buffer, the transform is in place
+  cl_mem d_data;
+  d_data = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_CHANNEL_1_INTELFPGA, sizeof(float2) * num_pts, NULL, &status);
+  checkError(status, "Failed to allocate input device buffer\n");
 
-    status = clEnqueueTask(queue3, transpose_kernel, 0, NULL, NULL);
-    checkError(status, "Failed to launch transpose kernel");
+  ddr_transpose_t d_transpose = ddr_transpose_create(&pipe, N, CL_CHANNEL_2_INTELFPGA);
 
-    status = clEnqueueTask(queue4, fftb_kernel, 0, NULL, NULL);
-    checkError(status, "Failed to launch second fft kernel");
+  // Copy the sub-box from host to device
+  cl_event writeBuf_event;
+  status = clEnqueueWriteBuffer(queue1, d_data, CL_TRUE, 0, sizeof(float2) * box_pts, inp, 0, NULL, &writeBuf_event);
+  checkError(status, "Failed to copy data to device");
 
-    status = clEnqueueTask(queue5, transpose3D_kernel, 0, NULL, NULL);
-    checkError(status, "Failed to launch transpose3D_kernel kernel");
-
-    status = clFinish(queue1);
-    checkError(status, "failed to finish queue 1");
-    status = clFinish(queue2);
-    checkError(status, "failed to finish queue 2");
-    status = clFinish(queue3);
-    checkError(status, "failed to finish queue 3");
-    status = clFinish(queue4);
-    checkError(status, "failed to finish queue 4");
-    status = clFinish(queue5);
-    checkError(status, "failed to finish queue 5");
-
-    mode = RD_GLOBALMEM;
-    status=clSetKernelArg(transpose3D_kernel, 2, sizeof(cl_int), (void*)&mode);
-    checkError(status, "Failed to set transpose3D kernel arg 2");
+  status = clFinish(queue1);
+  checkError(status, "Failed to finish data transfer to device");
 
-    status = clEnqueueTask(queue5, transpose3D_kernel, 0, NULL, NULL);
-    checkError(status, "Failed to launch transpose3D_kernel kernel");
+  cl_ulong writeBuf_start = 0, writeBuf_end = 0;
+  clGetEventProfilingInfo(writeBuf_event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &writeBuf_start, NULL);
+  clGetEventProfilingInfo(writeBuf_event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &writeBuf_end, NULL);
 
-    status = clEnqueueTask(queue4, fftc_kernel, 0, NULL, NULL);
-    checkError(status, "Failed to launch fft kernel");
+  fft_time.pcie_write_t = (cl_double)(writeBuf_end - writeBuf_start) * (cl_double)(1e-06);
 
-    status = clEnqueueTask(queue3, store_kernel, 0, NULL, NULL);
-    checkError(status, "Failed to launch transpose kernel");
+  fft_time.exec_t = ddr_pipeline_run(&pipe, d_data, &d_transpose, d_data, inv, false, false);
 
-    status = clFinish(queue1);
-    checkError(status, "failed to finish queue1");
-    status = clFinish(queue2);
-    checkError(status, "failed to finish queue2");
-    status = clFinish(queue3);
-    checkError(status, "failed to finish queue3");
-    status = clFinish(queue4);
-    checkError(status, "failed to finish queue4");
-    status = clFinish(queue5);
-    checkError(status, "failed to finish queue5");
-    status = clFinish(queue6);
-    checkError(status, "failed to finish queue6");
-    status = clFinish(queue7);
-    checkError(status, "failed to finish queue7");
-
-    clWaitForEvents(2, write_event);
-    clReleaseEvent(write_event[0]);
-    clReleaseEvent(write_event[1]);
-  }
+  // Copy results from device to host
+  cl_event readBuf_event;
+  status = clEnqueueReadBuffer(queue1, d_data, CL_TRUE, 0, sizeof(float2) * num_pts, out, 0, NULL, &readBuf_event);
+  checkError(status, "Failed to copy data from device to host");
+  status = clFinish(queue1);
+  checkError(status, "failed to finish reading DDR using PCIe");
 
-  if( (how_many % 4) == 0){
-    status = clEnqueueReadBuffer(queue6, d_outData3, CL_FALSE, 0, sizeof(float2) * num_pts, &out[(how_many - 2) * num_pts], 0, NULL, &write_event[0]);
-    checkError(status, "Failed to read from DDR buffer");
+  cl_ulong readBuf_start = 0, readBuf_end = 0;
+  clGetEventProfilingInfo(readBuf_event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &readBuf_start, NULL);
+  clGetEventProfilingInfo(readBuf_event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &readBuf_end, NULL);
 
-    status=clSetKernelArg(fetch_kernel, 0, sizeof(cl_mem), (void *)&d_inData4);
-    checkError(status, "Failed to set fetch1 kernel arg");
-  
-    status=clSetKernelArg(transpose3D_kernel, 0, sizeof(cl_mem), (void *)&d_transpose2);
-    checkError(status, "Failed to set transpose3D_kernel kernel arg 0");
+  fft_time.pcie_read_t = (cl_double)(readBuf_end - readBuf_start) * (cl_double)(1e-06);
 
-    status=clSetKernelArg(transpose3D_kernel, 1, sizeof(cl_mem), (void *)&d_transpose2);
-    checkError(status, "Failed to set transpose3D_kernel kernel arg 1");
+  queue_cleanup();
 
-    mode = WR_GLOBALMEM;
-    status=clSetKernelArg(transpose3D_kernel, 2, sizeof(cl_int), (void*)&mode);
-    checkError(status, "Failed to set transpose3D kernel arg 2");   
+  if (d_data)
+    clReleaseMemObject(d_data);
+  ddr_transpose_release(&d_transpose);
 
-    status=clSetKernelArg(store_kernel, 0, sizeof(cl_mem), (void *)&d_outData4);
-    checkError(status, "Failed to set store2 kernel arg");
-  }
-  else if((how_many % 4) == 1){
-    status = clEnqueueReadBuffer(queue6, d_outData4, CL_FALSE, 0, sizeof(float2) * num_pts, &out[(how_many - 2) * num_pts], 0, NULL, &write_event[0]);
-    checkError(status, "Failed to read from DDR buffer");
+  ddr_pipeline_release(&pipe);
 
-    status=clSetKernelArg(fetch_kernel, 0, sizeof(cl_mem), (void *)&d_inData1);
-    checkError(status, "Failed to set fetch1 kernel arg");
-  
-    status=clSetKernelArg(transpose3D_kernel, 0, sizeof(cl_mem), (void *)&d_transpose3);
-    checkError(status, "Failed to set transpose3D_kernel kernel arg 0");
-
-    status=clSetKernelArg(transpose3D_kernel, 1, sizeof(cl_mem), (void *)&d_transpose3);
-    checkError(status, "Failed to set transpose3D_kernel kernel arg 1");
-
-    mode = WR_GLOBALMEM;
-    status=clSetKernelArg(transpose3D_kernel, 2, sizeof(cl_int), (void*)&mode);
-    checkError(status, "Failed to set transpose3D kernel arg 2"); 
-    
-    status=clSetKernelArg(store_kernel, 0, sizeof(cl_mem), (void *)&d_outData1);
-    checkError(status, "Failed to set store2 kernel arg");
-  }
-  else if((how_many % 4) == 2){
-    status = clEnqueueReadBuffer(queue6, d_outData1, CL_FALSE, 0, sizeof(float2) * num_pts, &out[(how_many - 2) * num_pts], 0, NULL, &write_event[0]);
-    checkError(status, "Failed to read from DDR buffer");
+  fft_time.valid = 1;
+  return fft_time;
+}
 
-    status=clSetKernelArg(fetch_kernel, 0, sizeof(cl_mem), (void *)&d_inData2);
-    checkError(status, "Failed to set fetch1 kernel arg");
-  
-    status=clSetKernelArg(transpose3D_kernel, 0, sizeof(cl_mem), (void *)&d_transpose4);
-    checkError(status, "Failed to set transpose3D_kernel kernel arg 0");
-
-    status=clSetKernelArg(transpose3D_kernel, 1, sizeof(cl_mem), (void *)&d_transpose4);
-    checkError(status, "Failed to set transpose3D_kernel kernel arg 1");
-
-    mode = WR_GLOBALMEM;
-    status=clSetKernelArg(transpose3D_kernel, 2, sizeof(cl_int), (void*)&mode);
-    checkError(status, "Failed to set transpose3D kernel arg 2"); 
-    
-    status=clSetKernelArg(store_kernel, 0, sizeof(cl_mem), (void *)&d_outData2);
-    checkError(status, "Failed to set store2 kernel arg");
-  }
-  else{
-    status = clEnqueueReadBuffer(queue6, d_outData2, CL_FALSE, 0, sizeof(float2) * num_pts, &out[(how_many - 2) * num_pts], 0, NULL, &write_event[0]);
-    checkError(status, "Failed to read from DDR buffer");
+/**
+ * \brief  compute a single precision complex 3D-FFT using the DDR of the FPGA for 3D Transpose, reading back only a sub-box of the output with rectangular transfers
+ * \param  N      : unsigned integer denoting the size of FFT3d
+ * \param  inp    : float2 pointer to input data of size [N * N * N]
+ * \param  inv    : toggle to activate backward FFT
+ * \param  box    : size of the sub-box of the output along x, y and z
+ * \param  origin : first point of the sub-box along x, y and z, the sub-box wraps around periodically
+ * \param  out    : float2 pointer to the first point of the sub-box in the host array
+ * \param  ld     : number of points per row and rows per slice of the host array
+ * \return fpga_t : time taken in milliseconds for data transfers and execution
+ */
+fpga_t fftfpgaf_c2c_3d_ddr_region(const unsigned N, const float2 *inp, const bool inv, const unsigned box[3], const unsigned origin[3], float2 *out, const unsigned ld[2]) {
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0};
+  cl_int status = 0;
+  const unsigned num_pts = N * N * N;
 
-    status=clSetKernelArg(fetch_kernel, 0, sizeof(cl_mem), (void *)&d_inData3);
-    checkError(status, "Failed to set fetch1 kernel arg");
-  
-    status=clSetKernelArg(transpose3D_kernel, 0, sizeof(cl_mem), (void *)&d_transpose1);
-    checkError(status, "Failed to set transpose3D_kernel kernel arg 0");
-
-    status=clSetKernelArg(transpose3D_kernel, 1, sizeof(cl_mem), (void *)&d_transpose1);
-    checkError(status, "Failed to set transpose3D_kernel kernel arg 1");
-
-    mode = WR_GLOBALMEM;
-    status=clSetKernelArg(transpose3D_kernel, 2, sizeof(cl_int), (void*)&mode);
-    checkError(status, "Failed to set transpose3D kernel arg 2"); 
-    
-    status=clSetKernelArg(store_kernel, 0, sizeof(cl_mem), (void *)&d_outData3);
-    checkError(status, "Failed to set store2 kernel arg");
+  // if N is not a power of 2
+  if(inp == NULL || out == NULL || ( (N & (N-1)) !=0) || N < 8 || !region_valid(N, box, origin, ld)){
+    return fft_time;
   }
 
-  status = clEnqueueTask(queue1, fetch_kernel, 0, NULL, NULL);
-  checkError(status, "Failed to launch fetch kernel");
+  ddr_pipeline_t pipe = ddr_pipeline_create(N);
 
-  status = clEnqueueTask(queue2, ffta_kernel, 0, NULL, NULL);
-  checkError(status, "Failed to launch fft kernel");
+  queue_setup();
 
-  status = clEnqueueTask(queue3, transpose_kernel, 0, NULL, NULL);
-  checkError(status, "Failed to launch transpose kernel");
+  cl_mem d_data;
+  d_data = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_CHANNEL_1_INTELFPGA, sizeof(float2) * num_pts, NULL, &status);
+  checkError(status, "Failed to allocate input device buffer\n");
 
-  status = clEnqueueTask(queue4, fftb_kernel, 0, NULL, NULL);
-  checkError(status, "Failed to launch second fft kernel");
+  ddr_transpose_t d_transpose = ddr_transpose_create(&pipe, N, CL_CHANNEL_2_INTELFPGA);
 
-  status = clEnqueueTask(queue5, transpose3D_kernel, 0, NULL, NULL);
-  checkError(status, "Failed to launch transpose3D_kernel kernel");
+  // Copy data from host to device
+  cl_event writeBuf_event;
+  status = clEnqueueWriteBuffer(queue1, d_data, CL_TRUE, 0, sizeof(float2) * num_pts, inp, 0, NULL, &writeBuf_event);
+  checkError(status, "Failed to copy data to device");
 
   status = clFinish(queue1);
-  checkError(status, "failed to finish queue 1");
-  status = clFinish(queue2);
-  checkError(status, "failed to finish queue 2");
-  status = clFinish(queue3);
-  checkError(status, "failed to finish queue 3");
-  status = clFinish(queue4);
-  checkError(status, "failed to finish queue 4");
-  status = clFinish(queue5);
-  checkError(status, "failed to finish queue 5");
-
-  mode = RD_GLOBALMEM;
-  status=clSetKernelArg(transpose3D_kernel, 2, sizeof(cl_int), (void*)&mode);
-  checkError(status, "Failed to set transpose3D kernel arg 2");
-
-  status = clEnqueueTask(queue5, transpose3D_kernel, 0, NULL, NULL);
-  checkError(status, "Failed to launch transpose3D_kernel kernel");
-
-  status = clEnqueueTask(queue4, fftc_kernel, 0, NULL, NULL);
-  checkError(status, "Failed to launch fft kernel");
-
-  status = clEnqueueTask(queue3, store_kernel, 0, NULL, NULL);
-  checkError(status, "Failed to launch store kernel");
+  checkError(status, "Failed to finish data transfer to device");
 
-  clWaitForEvents(1, &write_event[0]);
-  clReleaseEvent(write_event[0]);
-  status = clFinish(queue3);
-  checkError(status, "failed to finish queue3");
-  status = clFinish(queue4);
-  checkError(status, "failed to finish queue4");
-  status = clFinish(queue5);
-  checkError(status, "failed to finish queue5");
-  status = clFinish(queue6);
-  checkError(status, "failed to finish queue6");
+  cl_ulong writeBuf_start = 0, writeBuf_end = 0;
+  clGetEventProfilingInfo(writeBuf_event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &writeBuf_start, NULL);
+  clGetEventProfilingInfo(writeBuf_event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &writeBuf_end, NULL);
 
-  if( (how_many % 4) == 0){
-    status = clEnqueueReadBuffer(queue6, d_outData4, CL_FALSE, 0, sizeof(float2) * num_pts, &out[(how_many - 1) * num_pts], 0, NULL, &write_event[0]);
-    checkError(status, "Failed to read from DDR buffer");
-  }
-  else if((how_many % 4) == 1){
-    status = clEnqueueReadBuffer(queue6, d_outData1, CL_FALSE, 0, sizeof(float2) * num_pts, &out[(how_many - 1) * num_pts], 0, NULL, &write_event[0]);
-    checkError(status, "Failed to read from DDR buffer");
-  }
-  else if((how_many % 4) == 2){
-    status = clEnqueueReadBuffer(queue6, d_outData2, CL_FALSE, 0, sizeof(float2) * num_pts, &out[(how_many - 1) * num_pts], 0, NULL, &write_event[0]);
-    checkError(status, "Failed to read from DDR buffer");
-  }
-  else{
-    status = clEnqueueReadBuffer(queue6, d_outData3, CL_FALSE, 0, sizeof(float2) * num_pts, &out[(how_many - 1) * num_pts], 0, NULL, &write_event[0]);
-    checkError(status, "Failed to read from DDR buffer");
-  }
+  fft_time.pcie_write_t = (cl_double)(writeBuf_end - writeBuf_start) * (cl_double)(1e-06);
 
-  status = clFinish(queue6);
-  checkError(status, "failed to finish reading DDR using PCIe");
+  fft_time.exec_t = ddr_pipeline_run(&pipe, d_data, &d_transpose, d_data, inv, false, false);
 
-  clWaitForEvents(1, &write_event[0]);
-  clReleaseEvent(write_event[0]);
+  // Copy only the sub-box from device to host
+  fft_time.pcie_read_t = buffer_read_region(d_data, N, box, origin, out, ld);
 
-  fft_time.exec_t = getTimeinMilliSec() - fft_time.exec_t;
-  checkError(status, "Failed to copy data from device");
-  
   queue_cleanup();
 
-  if (d_inData1)
-    clReleaseMemObject(d_inData1);
-  if (d_inData2)
-    clReleaseMemObject(d_inData2);
-  if (d_inData3)
-    clReleaseMemObject(d_inData3);
-  if (d_inData4)
-    clReleaseMemObject(d_inData4);
-
-  if (d_outData1) 
-    clReleaseMemObject(d_outData1);
-  if (d_outData2) 
-    clReleaseMemObject(d_outData2);
-  if (d_outData3) 
-    clReleaseMemObject(d_outData3);
-  if (d_outData4) 
-    clReleaseMemObject(d_outData4);
-
-  if (d_transpose1) 
-    clReleaseMemObject(d_transpose1);
-  if (d_transpose2) 
-    clReleaseMemObject(d_transpose2);
-  if (d_transpose3) 
-    clReleaseMemObject(d_transpose3);
-  if (d_transpose4) 
-    clReleaseMemObject(d_transpose4);
+  if (d_data)
+    clReleaseMemObject(d_data);
+  ddr_transpose_release(&d_transpose);
 
-  if(fetch_kernel) 
-    clReleaseKernel(fetch_kernel);  
-  if(transpose3D_kernel) 
-    clReleaseKernel(transpose3D_kernel);  
-
-  if(ffta_kernel) 
-    clReleaseKernel(ffta_kernel);  
-  if(fftb_kernel) 
-    clReleaseKernel(fftb_kernel);  
-  if(fftc_kernel) 
-    clReleaseKernel(fftc_kernel);  
-
-  if(transpose_kernel) 
-    clReleaseKernel(transpose_kernel);  
-
-  if(store_kernel) 
-    clReleaseKernel(store_kernel);  
+  ddr_pipeline_release(&pipe);
 
   fft_time.valid = 1;
   return fft_time;
-}
\ No newline at end of file
+}
@@ -0,0 +1,109 @@
+// Author: Arjun Ramaswami
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+#define CL_VERSION_2_0
+#include <CL/cl_ext_intelfpga.h> // to disable interleaving & transfer data to specific banks - CL_CHANNEL_1_INTELFPGA
+#include "CL/opencl.h"
+
+#include "fpga_state.h"
+#include "fftfpga/fftfpga.h"
+#include "opencl_utils.h"
+
+/**
+ * \brief  time a kernel launched alone on queue1
+ * \param  kernel : kernel with its arguments set
+ * \return time taken in milliseconds for the execution
+ */
+static double bench_run(cl_kernel kernel){
+  cl_int status = 0;
+  cl_event exec_event;
+
+  status = clEnqueueTask(queue1, kernel, 0, NULL, &exec_event);
+  checkError(status, "Failed to launch benchmark kernel");
+  status = clFinish(queue1);
+  checkError(status, "failed to finish benchmark kernel");
+
+  cl_ulong kernel_start = 0, kernel_end = 0;
+  clGetEventProfilingInfo(exec_event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &kernel_start, NULL);
+  clGetEventProfilingInfo(exec_event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &kernel_end, NULL);
+  clReleaseEvent(exec_event);
+
+  return (cl_double)(kernel_end - kernel_start) * (cl_double)(1e-06);
+}
+
+/**
+ * \brief  measure the DDR accesses of the 3D Transpose with the transpose3d_bench bitstream: the sequential write of the transform and its read along z in the layout given
+ * \param  N        : unsigned integer denoting the size of FFT3d
+ * \param  log_tile : log2 of the number of planes along z per block of the layout, 0 for the layout [z][y][x]
+ * \param  write_t  : time taken in milliseconds for the write
+ * \param  read_t   : time taken in milliseconds for the read
+ * \return 0 if successful
+ *        -1 if the arguments are invalid or no bitstream is loaded
+ *        -2 if the bitstream loaded has no benchmark kernels
+ */
+int fftfpgaf_transpose3d_bench(const unsigned N, const unsigned log_tile, double *write_t, double *read_t){
+  cl_int status = 0;
+
+  // if N is not a power of 2
+  if(write_t == NULL || read_t == NULL || program == NULL || N < 8 || ( (N & (N-1)) !=0)){
+    return -1;
+  }
+
+  const int logN = (int)log2(N);
+  const int log_tile_int = (int)log_tile;
+  if(log_tile_int > logN){
+    return -1;
+  }
+
+  if(!kernelExists(program, "bench_write") || !kernelExists(program, "bench_read")){
+    return -2;
+  }
+
+  const size_t num_pts = (size_t)N * N * N;
+
+  cl_kernel write_kernel = clCreateKernel(program, "bench_write", &status);
+  checkError(status, "Failed to create bench_write kernel");
+  cl_kernel read_kernel = clCreateKernel(program, "bench_read", &status);
+  checkError(status, "Failed to create bench_read kernel");
+
+  queue_setup();
+
+  cl_mem d_transpose = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_CHANNEL_1_INTELFPGA, sizeof(float2) * num_pts, NULL, &status);
+  checkError(status, "Failed to allocate transpose device buffer\n");
+  cl_mem d_check = clCreateBuffer(context, CL_MEM_WRITE_ONLY | CL_CHANNEL_1_INTELFPGA, 2 * sizeof(cl_uint), NULL, &status);
+  checkError(status, "Failed to allocate check device buffer\n");
+
+  status = clSetKernelArg(write_kernel, 0, sizeof(cl_mem), (void *)&d_transpose);
+  checkError(status, "Failed to set bench_write kernel arg 0");
+  status = clSetKernelArg(write_kernel, 1, sizeof(cl_int), (void *)&logN);
+  checkError(status, "Failed to set bench_write kernel arg 1");
+
+  status = clSetKernelArg(read_kernel, 0, sizeof(cl_mem), (void *)&d_transpose);
+  checkError(status, "Failed to set bench_read kernel arg 0");
+  status = clSetKernelArg(read_kernel, 1, sizeof(cl_mem), (void *)&d_check);
+  checkError(status, "Failed to set bench_read kernel arg 1");
+  status = clSetKernelArg(read_kernel, 2, sizeof(cl_int), (void *)&logN);
+  checkError(status, "Failed to set bench_read kernel arg 2");
+  status = clSetKernelArg(read_kernel, 3, sizeof(cl_int), (void *)&log_tile_int);
+  checkError(status, "Failed to set bench_read kernel arg 3");
+
+  *write_t = bench_run(write_kernel);
+  *read_t = bench_run(read_kernel);
+
+  queue_cleanup();
+
+  if (d_transpose)
+    clReleaseMemObject(d_transpose);
+  if (d_check)
+    clReleaseMemObject(d_check);
+
+  if(write_kernel)
+    clReleaseKernel(write_kernel);
+  if(read_kernel)
+    clReleaseKernel(read_kernel);
+
+  return 0;
+}
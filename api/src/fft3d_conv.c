@@ -0,0 +1,226 @@
+// Author: Arjun Ramaswami
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+#define CL_VERSION_2_0
+#include <CL/cl_ext_intelfpga.h> // to disable interleaving & transfer data to specific banks - CL_CHANNEL_1_INTELFPGA
+#include "CL/opencl.h"
+
+#include "fpga_state.h"
+#include "fftfpga/fftfpga.h"
+#include "fft3d_conv.h"
+#include "fft3d_pipeline.h"
+#include "fft_buffer.h"
+#include "opencl_utils.h"
+#include "misc.h"
+
+// Kernel array of the convolution, resident on the device between calls
+static cl_mem d_coeff = NULL;
+static unsigned coeff_N = 0;
+
+/**
+ * \brief  upload the kernel array of the convolution to the device, where it is kept for the following calls to fftfpgaf_c2c_3d_conv
+ * \param  N     : unsigned integer denoting the size of FFT3d
+ * \param  coeff : float2 pointer to the kernel array in frequency space of size [N * N * N]
+ * \return 0 if successful
+ *        -1 if the arguments are invalid or no bitstream is loaded
+ *        -2 if the bitstream loaded has no pointwise multiplication kernel
+ */
+int fftfpgaf_conv3d_set_kernel(const unsigned N, const float2 *coeff){
+  cl_int status = 0;
+
+  // if N is not a power of 2
+  if(coeff == NULL || program == NULL || N < 8 || ( (N & (N-1)) !=0)){
+    return -1;
+  }
+
+  if(!kernelExists(program, "pointwise")){
+    return -2;
+  }
+
+  // reorder to the layout of the spectrum: transposed to [y][z][x] and bit-reversed along each dimension
+  const unsigned logN = (unsigned)log2(N);
+  const size_t sz = sizeof(float2) * N * N * N;
+  float2 *tmp = (float2*)alignedMalloc(sz);
+  for(unsigned y = 0; y < N; y++){
+    for(unsigned z = 0; z < N; z++){
+      for(unsigned x = 0; x < N; x++){
+        const size_t from = ((size_t)bit_reversed(z, logN) * N + bit_reversed(y, logN)) * N + bit_reversed(x, logN);
+        tmp[((size_t)y * N + z) * N + x] = coeff[from];
+      }
+    }
+  }
+
+  if(d_coeff == NULL || coeff_N != N){
+    conv_cleanup();
+    d_coeff = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_CHANNEL_2_INTELFPGA, sz, NULL, &status);
+    checkError(status, "Failed to allocate kernel array device buffer\n");
+    coeff_N = N;
+  }
+
+  queue_setup();
+
+  status = clEnqueueWriteBuffer(queue1, d_coeff, CL_TRUE, 0, sz, tmp, 0, NULL, NULL);
+  checkError(status, "Failed to copy kernel array to device");
+
+  queue_cleanup();
+  free(tmp);
+  return 0;
+}
+
+/**
+ * \brief  compute the convolution of a device buffer into another: forward 3D-FFT, pointwise multiplication with the kernel array and backward 3D-FFT. The queues must have been setup.
+ * \param  N    : unsigned integer denoting the size of FFT3d
+ * \param  src  : device buffer of the input
+ * \param  dest : device buffer of the output, can be the same as src
+ * \return time taken in milliseconds for the execution of the three stages
+ */
+static double conv_run(const unsigned N, cl_mem src, cl_mem dest){
+  cl_int status = 0;
+  const unsigned num_pts = N * N * N;
+  double exec_t = 0.0;
+
+  ddr_pipeline_t pipe = ddr_pipeline_create(N);
+  cl_kernel pointwise_kernel = clCreateKernel(program, "pointwise", &status);
+  checkError(status, "Failed to create pointwise kernel");
+
+  // the spectrum is placed in the bank other than the kernel array
+  cl_mem d_spectrum;
+  ddr_transpose_t d_transpose = ddr_transpose_create(&pipe, N, CL_CHANNEL_2_INTELFPGA);
+
+  d_spectrum = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_CHANNEL_1_INTELFPGA, sizeof(float2) * num_pts, NULL, &status);
+  checkError(status, "Failed to allocate spectrum device buffer\n");
+
+  // Forward transform into the spectrum, unordered and transposed as the kernel array
+  exec_t = ddr_pipeline_run(&pipe, src, &d_transpose, d_spectrum, false, true, true);
+
+  // Multiplication with the kernel array
+  status = clSetKernelArg(pointwise_kernel, 0, sizeof(cl_mem), (void *)&d_spectrum);
+  checkError(status, "Failed to set pointwise kernel arg 0");
+  status = clSetKernelArg(pointwise_kernel, 1, sizeof(cl_mem), (void *)&d_coeff);
+  checkError(status, "Failed to set pointwise kernel arg 1");
+  status = clSetKernelArg(pointwise_kernel, 2, sizeof(cl_uint), (void *)&num_pts);
+  checkError(status, "Failed to set pointwise kernel arg 2");
+
+  cl_event pointwise_event;
+  status = clEnqueueTask(queue1, pointwise_kernel, 0, NULL, &pointwise_event);
+  checkError(status, "Failed to launch pointwise kernel");
+  status = clFinish(queue1);
+  checkError(status, "failed to finish pointwise kernel");
+
+  cl_ulong kernel_start = 0, kernel_end = 0;
+  clGetEventProfilingInfo(pointwise_event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &kernel_start, NULL);
+  clGetEventProfilingInfo(pointwise_event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &kernel_end, NULL);
+  clReleaseEvent(pointwise_event);
+
+  exec_t += (cl_double)(kernel_end - kernel_start) * (cl_double)(1e-06);
+
+  // Backward transform of the transposed spectrum gives the layout of the input
+  exec_t += ddr_pipeline_run(&pipe, d_spectrum, &d_transpose, dest, true, true, true);
+
+  ddr_transpose_release(&d_transpose);
+  if (d_spectrum)
+    clReleaseMemObject(d_spectrum);
+
+  ddr_pipeline_release(&pipe);
+  if(pointwise_kernel)
+    clReleaseKernel(pointwise_kernel);
+
+  return exec_t;
+}
+
+/**
+ * \brief  compute an out-of-place single precision complex 3D convolution on the FPGA: forward 3D-FFT, pointwise multiplication with the kernel array set by fftfpgaf_conv3d_set_kernel and backward 3D-FFT. The intermediate spectrum remains in the DDR of the FPGA, so that the data crosses PCIe once in each direction.
+ * \param  N    : unsigned integer denoting the size of FFT3d
+ * \param  inp  : float2 pointer to input data of size [N * N * N]
+ * \param  out  : float2 pointer to output data of size [N * N * N]
+ * \return fpga_t : time taken in milliseconds for data transfers and execution of the three stages
+ */
+fpga_t fftfpgaf_c2c_3d_conv(const unsigned N, const float2 *inp, float2 *out){
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0};
+  cl_int status = 0;
+  const unsigned num_pts = N * N * N;
+
+  // if N is not a power of 2 or the kernel array set is of another size
+  if(inp == NULL || out == NULL || ( (N & (N-1)) !=0) || d_coeff == NULL || coeff_N != N){
+    return fft_time;
+  }
+
+  queue_setup();
+
+  cl_mem d_data = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_CHANNEL_1_INTELFPGA, sizeof(float2) * num_pts, NULL, &status);
+  checkError(status, "Failed to allocate input device buffer\n");
+
+  // Copy data from host to device
+  cl_event writeBuf_event;
+  status = clEnqueueWriteBuffer(queue1, d_data, CL_TRUE, 0, sizeof(float2) * num_pts, inp, 0, NULL, &writeBuf_event);
+  checkError(status, "Failed to copy data to device");
+
+  status = clFinish(queue1);
+  checkError(status, "Failed to finish data transfer to device");
+
+  cl_ulong writeBuf_start = 0, writeBuf_end = 0;
+  clGetEventProfilingInfo(writeBuf_event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &writeBuf_start, NULL);
+  clGetEventProfilingInfo(writeBuf_event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &writeBuf_end, NULL);
+
+  fft_time.pcie_write_t = (cl_double)(writeBuf_end - writeBuf_start) * (cl_double)(1e-06);
+
+  // result overwrites the input on the device
+  fft_time.exec_t = conv_run(N, d_data, d_data);
+
+  // Copy results from device to host
+  cl_event readBuf_event;
+  status = clEnqueueReadBuffer(queue1, d_data, CL_TRUE, 0, sizeof(float2) * num_pts, out, 0, NULL, &readBuf_event);
+  checkError(status, "Failed to copy data from device to host");
+  status = clFinish(queue1);
+  checkError(status, "failed to finish reading DDR using PCIe");
+
+  cl_ulong readBuf_start = 0, readBuf_end = 0;
+  clGetEventProfilingInfo(readBuf_event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &readBuf_start, NULL);
+  clGetEventProfilingInfo(readBuf_event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &readBuf_end, NULL);
+
+  fft_time.pcie_read_t = (cl_double)(readBuf_end - readBuf_start) * (cl_double)(1e-06);
+
+  queue_cleanup();
+
+  if (d_data)
+    clReleaseMemObject(d_data);
+
+  fft_time.valid = 1;
+  return fft_time;
+}
+
+/**
+ * \brief  compute a single precision complex 3D convolution of a buffer on the FPGA into another, without transfers to or from the host
+ * \param  N    : unsigned integer denoting the size of FFT3d
+ * \param  inp  : handle to the device buffer of the input of at least [N * N * N] points
+ * \param  out  : handle to the device buffer of the output of at least [N * N * N] points, can be the same as inp
+ * \return fpga_t : time taken in milliseconds for the execution of the three stages
+ */
+fpga_t fftfpgaf_c2c_3d_conv_dev(const unsigned N, const fftfpga_buffer inp, fftfpga_buffer out){
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0};
+  const unsigned num_pts = N * N * N;
+
+  if(( (N & (N-1)) !=0) || d_coeff == NULL || coeff_N != N || !buffer_valid(inp, num_pts) || !buffer_valid(out, num_pts)){
+    return fft_time;
+  }
+
+  queue_setup();
+  fft_time.exec_t = conv_run(N, inp->mem, out->mem);
+  queue_cleanup();
+
+  fft_time.valid = 1;
+  return fft_time;
+}
+
+/**
+ * \brief  release the kernel array of the convolution kept on the device
+ */
+void conv_cleanup(){
+  if(d_coeff)
+    clReleaseMemObject(d_coeff);
+  d_coeff = NULL;
+  coeff_N = 0;
+}
@@ -0,0 +1,9 @@
+// Author: Arjun Ramaswami
+
+#ifndef FFT3D_CONV_H
+#define FFT3D_CONV_H
+
+// Release the kernel array of the convolution kept on the device
+void conv_cleanup();
+
+#endif
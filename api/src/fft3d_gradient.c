@@ -0,0 +1,149 @@
+// Author: Arjun Ramaswami
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+#define CL_VERSION_2_0
+#include <CL/cl_ext_intelfpga.h> // to disable interleaving & transfer data to specific banks - CL_CHANNEL_1_INTELFPGA
+#include "CL/opencl.h"
+
+#include "fpga_state.h"
+#include "fftfpga/fftfpga.h"
+#include "fft3d_pipeline.h"
+#include "opencl_utils.h"
+
+/**
+ * \brief  compute the gradient of a 3D field on the FPGA in the spectral domain: a forward 3D-FFT, then for each axis the multiplication of the spectrum by i * k, with the k-vectors generated on the device, and a backward 3D-FFT. The field is transferred to the device once and the spectrum remains in its DDR. The readback of a component overlaps the computation of the next one.
+ * \param  N      : unsigned integer denoting the size of FFT3d
+ * \param  inp    : float2 pointer to the field of size [N * N * N] in the layout [z][y][x]
+ * \param  grad_x : float2 pointer to the derivative along x of size [N * N * N]
+ * \param  grad_y : float2 pointer to the derivative along y of size [N * N * N]
+ * \param  grad_z : float2 pointer to the derivative along z of size [N * N * N]
+ * \param  L      : length of the periodic box along each dimension
+ * \return fpga_t : time taken in milliseconds for data transfers and execution
+ */
+fpga_t fftfpgaf_gradient_3d(const unsigned N, const float2 *inp, float2 *grad_x, float2 *grad_y, float2 *grad_z, const float L){
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0};
+  cl_int status = 0;
+  const unsigned num_pts = N * N * N;
+  float2 *grad[3] = {grad_x, grad_y, grad_z};
+
+  // if N is not a power of 2
+  if(inp == NULL || grad_x == NULL || grad_y == NULL || grad_z == NULL || ( (N & (N-1)) !=0) || N < 8 || !(L > 0.0f)){
+    return fft_time;
+  }
+
+  if(program == NULL || !kernelExists(program, "derivative")){
+    return fft_time;
+  }
+
+  // 2 pi / L per unit of frequency, with the normalization of the backward transform
+  const float scale = (float)(2.0 * M_PI / L / num_pts);
+
+  ddr_pipeline_t pipe = ddr_pipeline_create(N);
+  cl_kernel derivative_kernel = clCreateKernel(program, "derivative", &status);
+  checkError(status, "Failed to create derivative kernel");
+
+  queue_setup();
+
+  // Device memory buffers, the derivatives alternate between two buffers so that the readback of one overlaps the computation of the next
+  cl_mem d_data, d_deriv[2];
+  d_data = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_CHANNEL_1_INTELFPGA, sizeof(float2) * num_pts, NULL, &status);
+  checkError(status, "Failed to allocate input device buffer\n");
+
+  ddr_transpose_t d_transpose = ddr_transpose_create(&pipe, N, CL_CHANNEL_2_INTELFPGA);
+
+  for(unsigned i = 0; i < 2; i++){
+    d_deriv[i] = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_CHANNEL_1_INTELFPGA, sizeof(float2) * num_pts, NULL, &status);
+    checkError(status, "Failed to allocate derivative device buffer\n");
+  }
+
+  // Copy data from host to device
+  cl_event writeBuf_event;
+  status = clEnqueueWriteBuffer(queue1, d_data, CL_TRUE, 0, sizeof(float2) * num_pts, inp, 0, NULL, &writeBuf_event);
+  checkError(status, "Failed to copy data to device");
+
+  status = clFinish(queue1);
+  checkError(status, "Failed to finish data transfer to device");
+
+  cl_ulong writeBuf_start = 0, writeBuf_end = 0;
+  clGetEventProfilingInfo(writeBuf_event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &writeBuf_start, NULL);
+  clGetEventProfilingInfo(writeBuf_event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &writeBuf_end, NULL);
+
+  fft_time.pcie_write_t = (cl_double)(writeBuf_end - writeBuf_start) * (cl_double)(1e-06);
+
+  // Forward transform in place, the spectrum is kept unordered and transposed to [y][z][x] for the three derivatives
+  fft_time.exec_t = ddr_pipeline_run(&pipe, d_data, &d_transpose, d_data, false, true, true);
+
+  cl_event readBuf_event[3];
+  for(int axis = 0; axis < 3; axis++){
+    cl_mem d_out = d_deriv[axis % 2];
+
+    // the buffer is reused once its previous component has been read back
+    if(axis >= 2){
+      status = clWaitForEvents(1, &readBuf_event[axis - 2]);
+      checkError(status, "Failed to wait for reading derivative");
+    }
+
+    status = clSetKernelArg(derivative_kernel, 0, sizeof(cl_mem), (void *)&d_data);
+    checkError(status, "Failed to set derivative kernel arg 0");
+    status = clSetKernelArg(derivative_kernel, 1, sizeof(cl_mem), (void *)&d_out);
+    checkError(status, "Failed to set derivative kernel arg 1");
+    // position of the axis in the transposed layout, 0 for the contiguous one
+    int dim = (axis == 0) ? 0 : 3 - axis;
+    status = clSetKernelArg(derivative_kernel, 2, sizeof(cl_int), (void *)&dim);
+    checkError(status, "Failed to set derivative kernel arg 2");
+    status = clSetKernelArg(derivative_kernel, 3, sizeof(cl_float), (void *)&scale);
+    checkError(status, "Failed to set derivative kernel arg 3");
+
+    cl_event derivative_event;
+    status = clEnqueueTask(queue1, derivative_kernel, 0, NULL, &derivative_event);
+    checkError(status, "Failed to launch derivative kernel");
+    status = clFinish(queue1);
+    checkError(status, "failed to finish derivative kernel");
+
+    cl_ulong kernel_start = 0, kernel_end = 0;
+    clGetEventProfilingInfo(derivative_event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &kernel_start, NULL);
+    clGetEventProfilingInfo(derivative_event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &kernel_end, NULL);
+    clReleaseEvent(derivative_event);
+
+    fft_time.exec_t += (cl_double)(kernel_end - kernel_start) * (cl_double)(1e-06);
+
+    // Backward transform in place
+    fft_time.exec_t += ddr_pipeline_run(&pipe, d_out, &d_transpose, d_out, true, true, true);
+
+    // Copy the component to the host while the next one is computed
+    status = clEnqueueReadBuffer(queue8, d_out, CL_FALSE, 0, sizeof(float2) * num_pts, grad[axis], 0, NULL, &readBuf_event[axis]);
+    checkError(status, "Failed to copy data from device to host");
+  }
+
+  status = clFinish(queue8);
+  checkError(status, "failed to finish reading DDR using PCIe");
+
+  for(unsigned axis = 0; axis < 3; axis++){
+    cl_ulong readBuf_start = 0, readBuf_end = 0;
+    clGetEventProfilingInfo(readBuf_event[axis], CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &readBuf_start, NULL);
+    clGetEventProfilingInfo(readBuf_event[axis], CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &readBuf_end, NULL);
+    clReleaseEvent(readBuf_event[axis]);
+
+    fft_time.pcie_read_t += (cl_double)(readBuf_end - readBuf_start) * (cl_double)(1e-06);
+  }
+
+  queue_cleanup();
+
+  if (d_data)
+    clReleaseMemObject(d_data);
+  ddr_transpose_release(&d_transpose);
+  for(unsigned i = 0; i < 2; i++){
+    if (d_deriv[i])
+      clReleaseMemObject(d_deriv[i]);
+  }
+
+  ddr_pipeline_release(&pipe);
+  if(derivative_kernel)
+    clReleaseKernel(derivative_kernel);
+
+  fft_time.valid = 1;
+  return fft_time;
+}
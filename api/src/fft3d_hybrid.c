@@ -0,0 +1,255 @@
+// Author: Arjun Ramaswami
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <math.h>
+#include <fftw3.h>
+#define CL_VERSION_2_0
+#include <CL/cl_ext_intelfpga.h> // to disable interleaving & transfer data to specific banks - CL_CHANNEL_1_INTELFPGA
+#include "CL/opencl.h"
+
+#include "fpga_state.h"
+#include "fftfpga/fftfpga.h"
+#include "opencl_utils.h"
+#include "misc.h"
+
+// Number of groups of xy-planes, the z-FFTs of a group overlap the 2D FFTs of the following groups
+#define HYBRID_GROUPS 8
+
+/**
+ * \brief  multiply the planes of a group by the twiddle factors combining the groups, plane k1 of group r by exp(-+2 pi i r k1 / N)
+ * \param  group : first plane of the group, [N / HYBRID_GROUPS][N][N] points
+ */
+static void twiddle_group(float2 *group, const unsigned N, const unsigned r, const bool inv){
+  const unsigned planes = N / HYBRID_GROUPS;
+  const size_t plane_pts = (size_t)N * N;
+  const double sign = inv ? 1.0 : -1.0;
+
+  for(unsigned k = 1; k < planes; k++){
+    const double theta = sign * 2.0 * M_PI * (double)(r * k) / (double)N;
+    const float c = (float)cos(theta), s = (float)sin(theta);
+    float2 *plane = &group[k * plane_pts];
+    for(size_t i = 0; i < plane_pts; i++){
+      const float re = plane[i].x, im = plane[i].y;
+      plane[i].x = re * c - im * s;
+      plane[i].y = re * s + im * c;
+    }
+  }
+}
+
+/**
+ * \brief  compute an out-of-place single precision complex 3D-FFT by splitting the dimensions between the FPGA and the CPU, overlapping the two. The z-FFT is split as in a radix-G step, G = HYBRID_GROUPS: the planes z with z mod G = r form group r. The FPGA computes the 2D-FFTs of the planes of one group after the other, each group by a batched run of the 2D BRAM kernels. As soon as a group is read back, the CPU computes its N / G-point FFTs along z and multiplies them by the twiddle factors, while the FPGA computes the following groups. The G-point FFTs along z combining the groups are computed once all groups are done.
+ * \param  N    : unsigned integer denoting the size of FFT3d
+ * \param  inp  : float2 pointer to input data of size [N * N * N]
+ * \param  out  : float2 pointer to output data of size [N * N * N]
+ * \param  inv  : toggle to activate backward FFT
+ * \param  interleaving : toggle to use burst interleaved global memory buffers
+ * \return fpga_t : time taken in milliseconds for data transfers, execution and the CPU computation
+ */
+fpga_t fftfpgaf_c2c_3d_hybrid(const unsigned N, const float2 *inp, float2 *out, const bool inv, const bool interleaving){
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0};
+  cl_kernel ffta_kernel = NULL, fftb_kernel = NULL;
+  cl_kernel fetch_kernel = NULL, store_kernel = NULL;
+  cl_kernel transpose_kernel = NULL;
+  cl_int status = 0;
+
+  // if N is not a power of 2 or not large enough to be split into groups
+  if(inp == NULL || out == NULL || ( (N & (N-1)) !=0) || N < HYBRID_GROUPS){
+    return fft_time;
+  }
+
+  // planes of a group
+  const unsigned how_many = N / HYBRID_GROUPS;
+  const size_t plane_pts = (size_t)N * N;
+  const size_t group_pts = how_many * plane_pts;
+
+  queue_setup();
+
+  cl_mem_flags flagbuf1, flagbuf2;
+  if(interleaving == 1){
+    flagbuf1 = CL_MEM_READ_WRITE;
+    flagbuf2 = CL_MEM_READ_WRITE;
+  }
+  else{
+    flagbuf1 = CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA;
+    flagbuf2 = CL_MEM_WRITE_ONLY | CL_CHANNEL_2_INTELFPGA;
+  }
+
+  // Device memory buffers of every group
+  cl_mem d_inData[HYBRID_GROUPS], d_outData[HYBRID_GROUPS];
+  for(unsigned r = 0; r < HYBRID_GROUPS; r++){
+    d_inData[r] = clCreateBuffer(context, flagbuf1, sizeof(float2) * group_pts, NULL, &status);
+    checkError(status, "Failed to allocate input device buffer\n");
+
+    d_outData[r] = clCreateBuffer(context, flagbuf2, sizeof(float2) * group_pts, NULL, &status);
+    checkError(status, "Failed to allocate output device buffer\n");
+  }
+
+  // Can't pass bool to device, so convert it to int
+  int inverse_int = (int)inv;
+
+  ffta_kernel = clCreateKernel(program, "fft2da", &status);
+  checkError(status, "Failed to create fft2da kernel");
+  fftb_kernel = clCreateKernel(program, "fft2db", &status);
+  checkError(status, "Failed to create fft2db kernel");
+  fetch_kernel = clCreateKernel(program, "fetchBitrev", &status);
+  checkError(status, "Failed to create fetch kernel");
+  transpose_kernel = clCreateKernel(program, "transpose", &status);
+  checkError(status, "Failed to create transpose kernel");
+  store_kernel = clCreateKernel(program, "transposeStore", &status);
+  checkError(status, "Failed to create store kernel");
+
+  status = clSetKernelArg(fetch_kernel, 1, sizeof(cl_int), (void *)&how_many);
+  checkError(status, "Failed to set fetch kernel arg 1");
+  status = clSetKernelArg(ffta_kernel, 0, sizeof(cl_int), (void*)&inverse_int);
+  checkError(status, "Failed to set ffta kernel arg 0");
+  status = clSetKernelArg(ffta_kernel, 1, sizeof(cl_int), (void*)&how_many);
+  checkError(status, "Failed to set ffta kernel arg 1");
+  status = clSetKernelArg(transpose_kernel, 0, sizeof(cl_int), (void*)&how_many);
+  checkError(status, "Failed to set transpose kernel arg 0");
+  status = clSetKernelArg(fftb_kernel, 0, sizeof(cl_int), (void*)&inverse_int);
+  checkError(status, "Failed to set fftb kernel arg 0");
+  status = clSetKernelArg(fftb_kernel, 1, sizeof(cl_int), (void*)&how_many);
+  checkError(status, "Failed to set fftb kernel arg 1");
+  status = clSetKernelArg(store_kernel, 1, sizeof(cl_int), (void *)&how_many);
+  checkError(status, "Failed to set store kernel arg 1");
+
+  // Enqueue every group: the write gathers its planes, every HYBRID_GROUPS-th
+  // plane of the input, the kernels compute their 2D FFTs and the read copies
+  // them to the planes r * how_many .. (r + 1) * how_many - 1 of the output
+  cl_event writeBuf_event[HYBRID_GROUPS], startExec_event[HYBRID_GROUPS];
+  cl_event endExec_event[HYBRID_GROUPS], readBuf_event[HYBRID_GROUPS];
+  const size_t row_pitch = sizeof(float2) * N;
+  const size_t slice_pitch = sizeof(float2) * plane_pts;
+  for(unsigned r = 0; r < HYBRID_GROUPS; r++){
+    const size_t origin[3] = {0, 0, 0};
+    const size_t region[3] = {sizeof(float2) * N, N, how_many};
+
+    status = clEnqueueWriteBufferRect(queue7, d_inData[r], CL_FALSE, origin, origin, region, row_pitch, slice_pitch, row_pitch, slice_pitch * HYBRID_GROUPS, &inp[r * plane_pts], 0, NULL, &writeBuf_event[r]);
+    checkError(status, "Failed to copy data to device");
+
+    status = clSetKernelArg(fetch_kernel, 0, sizeof(cl_mem), (void *)&d_inData[r]);
+    checkError(status, "Failed to set fetch kernel arg 0");
+    status = clSetKernelArg(store_kernel, 0, sizeof(cl_mem), (void *)&d_outData[r]);
+    checkError(status, "Failed to set store kernel arg 0");
+
+    status = clEnqueueTask(queue1, fetch_kernel, 1, &writeBuf_event[r], &startExec_event[r]);
+    checkError(status, "Failed to launch fetch kernel");
+    status = clEnqueueTask(queue2, ffta_kernel, 0, NULL, NULL);
+    checkError(status, "Failed to launch fft kernel");
+    status = clEnqueueTask(queue3, transpose_kernel, 0, NULL, NULL);
+    checkError(status, "Failed to launch transpose kernel");
+    status = clEnqueueTask(queue4, fftb_kernel, 0, NULL, NULL);
+    checkError(status, "Failed to launch second fft kernel");
+    status = clEnqueueTask(queue5, store_kernel, 0, NULL, &endExec_event[r]);
+    checkError(status, "Failed to launch store kernel");
+
+    status = clEnqueueReadBuffer(queue6, d_outData[r], CL_FALSE, 0, sizeof(float2) * group_pts, &out[r * group_pts], 1, &endExec_event[r], &readBuf_event[r]);
+    checkError(status, "Failed to copy data from device");
+  }
+  status = clFlush(queue7);
+  checkError(status, "Failed to flush queue7");
+  status = clFlush(queue1);
+  checkError(status, "Failed to flush queue1");
+  status = clFlush(queue2);
+  checkError(status, "Failed to flush queue2");
+  status = clFlush(queue3);
+  checkError(status, "Failed to flush queue3");
+  status = clFlush(queue4);
+  checkError(status, "Failed to flush queue4");
+  status = clFlush(queue5);
+  checkError(status, "Failed to flush queue5");
+  status = clFlush(queue6);
+  checkError(status, "Failed to flush queue6");
+
+  // how_many-point FFTs along z of a group: N * N columns with a stride of N * N points
+  int n[1] = {(int)how_many};
+  fftwf_plan plan = fftwf_plan_many_dft(1, n, (int)plane_pts, (fftwf_complex*)out, NULL, (int)plane_pts, 1, (fftwf_complex*)out, NULL, (int)plane_pts, 1, inv ? FFTW_BACKWARD : FFTW_FORWARD, FFTW_ESTIMATE | FFTW_UNALIGNED);
+
+  // FFTs and twiddles of a group while the FPGA computes the following groups
+  for(unsigned r = 0; r < HYBRID_GROUPS; r++){
+    status = clWaitForEvents(1, &readBuf_event[r]);
+    checkError(status, "Failed to wait for readback of group");
+
+    double cpu_start = getTimeinMilliSec();
+    fftwf_complex *group_ptr = (fftwf_complex*)&out[r * group_pts];
+    fftwf_execute_dft(plan, group_ptr, group_ptr);
+    twiddle_group(&out[r * group_pts], N, r, inv);
+    fft_time.cpu_t += getTimeinMilliSec() - cpu_start;
+  }
+
+  fftwf_destroy_plan(plan);
+
+  // HYBRID_GROUPS-point FFTs along z combining the groups, in place: group r
+  // holds the frequencies r * how_many + k1 of the output at the points of k1
+  double cpu_start = getTimeinMilliSec();
+  int n_groups[1] = {HYBRID_GROUPS};
+  fftwf_plan plan_groups = fftwf_plan_many_dft(1, n_groups, (int)group_pts, (fftwf_complex*)out, NULL, (int)group_pts, 1, (fftwf_complex*)out, NULL, (int)group_pts, 1, inv ? FFTW_BACKWARD : FFTW_FORWARD, FFTW_ESTIMATE | FFTW_UNALIGNED);
+  fftwf_execute(plan_groups);
+  fftwf_destroy_plan(plan_groups);
+  fft_time.cpu_t += getTimeinMilliSec() - cpu_start;
+
+  status = clFinish(queue1);
+  checkError(status, "failed to finish queue1");
+  status = clFinish(queue2);
+  checkError(status, "failed to finish queue2");
+  status = clFinish(queue3);
+  checkError(status, "failed to finish queue3");
+  status = clFinish(queue4);
+  checkError(status, "failed to finish queue4");
+  status = clFinish(queue5);
+  checkError(status, "failed to finish queue5");
+  status = clFinish(queue6);
+  checkError(status, "failed to finish queue6");
+  status = clFinish(queue7);
+  checkError(status, "failed to finish queue7");
+
+  // kernels from the fetch of the first group to the store of the last, transfers summed over the groups
+  cl_ulong kernel_start = 0, kernel_end = 0;
+  clGetEventProfilingInfo(startExec_event[0], CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &kernel_start, NULL);
+  clGetEventProfilingInfo(endExec_event[HYBRID_GROUPS - 1], CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &kernel_end, NULL);
+
+  fft_time.exec_t = (cl_double)(kernel_end - kernel_start) * (cl_double)(1e-06);
+
+  for(unsigned r = 0; r < HYBRID_GROUPS; r++){
+    cl_ulong start = 0, end = 0;
+    clGetEventProfilingInfo(writeBuf_event[r], CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start, NULL);
+    clGetEventProfilingInfo(writeBuf_event[r], CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, NULL);
+    fft_time.pcie_write_t += (cl_double)(end - start) * (cl_double)(1e-06);
+
+    clGetEventProfilingInfo(readBuf_event[r], CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start, NULL);
+    clGetEventProfilingInfo(readBuf_event[r], CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, NULL);
+    fft_time.pcie_read_t += (cl_double)(end - start) * (cl_double)(1e-06);
+
+    clReleaseEvent(writeBuf_event[r]);
+    clReleaseEvent(startExec_event[r]);
+    clReleaseEvent(endExec_event[r]);
+    clReleaseEvent(readBuf_event[r]);
+  }
+
+  queue_cleanup();
+
+  for(unsigned r = 0; r < HYBRID_GROUPS; r++){
+    if (d_inData[r])
+      clReleaseMemObject(d_inData[r]);
+    if (d_outData[r])
+      clReleaseMemObject(d_outData[r]);
+  }
+
+  if(fetch_kernel)
+    clReleaseKernel(fetch_kernel);
+  if(ffta_kernel)
+    clReleaseKernel(ffta_kernel);
+  if(fftb_kernel)
+    clReleaseKernel(fftb_kernel);
+  if(transpose_kernel)
+    clReleaseKernel(transpose_kernel);
+  if(store_kernel)
+    clReleaseKernel(store_kernel);
+
+  fft_time.valid = 1;
+  return fft_time;
+}
@@ -0,0 +1,409 @@
+// Author: Arjun Ramaswami
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#define CL_VERSION_2_0
+#include <CL/cl_ext_intelfpga.h> // to disable interleaving & transfer data to specific banks - CL_CHANNEL_1_INTELFPGA
+#include "CL/opencl.h"
+
+#include "fpga_state.h"
+#include "fftfpga/fftfpga.h"
+#include "fft3d_pipeline.h"
+#include "opencl_utils.h"
+
+// Arguments of the fetch kernel, followed by the direction of the transform with autorun stages
+#define FETCH_NUM_ARGS 8
+
+/**
+ * \brief  create a kernel of the pipeline, suffixed by the index of the pipeline in a bitstream with replicated pipelines
+ * \param  name  : name of the kernel
+ * \param  index : index of the pipeline, or -1 for the single pipeline of the bitstream
+ * \return cl_kernel : the kernel
+ */
+static cl_kernel create_kernel(const char *name, const int index){
+  cl_int status = 0;
+  char kernel_name[32];
+
+  if(index < 0)
+    snprintf(kernel_name, sizeof(kernel_name), "%s", name);
+  else
+    snprintf(kernel_name, sizeof(kernel_name), "%s%d", name, index);
+
+  cl_kernel kernel = clCreateKernel(program, kernel_name, &status);
+  checkError(status, "Failed to create kernel of the 3D FFT pipeline");
+  return kernel;
+}
+
+/**
+ * \brief  create the kernels of a 3D FFT pipeline using the DDR for the 3D Transpose
+ * \param  N     : unsigned integer denoting the size of FFT3d
+ * \param  index : index of the pipeline, or -1 for the single pipeline of the bitstream
+ * \return ddr_pipeline_t : kernels of the pipeline, reading the whole input
+ */
+static ddr_pipeline_t create_pipeline(const unsigned N, const int index){
+  ddr_pipeline_t pipe;
+  cl_uint num_args = 0;
+
+  pipe.fetch = create_kernel("fetch", index);
+  cl_int status = clGetKernelInfo(pipe.fetch, CL_KERNEL_NUM_ARGS, sizeof(cl_uint), &num_args, NULL);
+  checkError(status, "Failed to query fetch kernel arguments");
+  pipe.autorun = (num_args > FETCH_NUM_ARGS);
+
+  // autorun kernels run from the programming of the bitstream
+  if(pipe.autorun){
+    pipe.ffta = pipe.transpose = pipe.fftb = pipe.fftc = NULL;
+  }
+  else{
+    pipe.ffta = create_kernel("fft3da", index);
+    pipe.transpose = create_kernel("transpose", index);
+    pipe.fftb = create_kernel("fft3db", index);
+    pipe.fftc = create_kernel("fft3dc", index);
+  }
+  // the hybrid 3D Transpose writes and reads the transform in one kernel, in bitstreams with a single pipeline
+  if(index < 0 && kernelExists(program, "transpose3D_hybrid")){
+    pipe.transpose3D_wr = create_kernel("transpose3D_hybrid", index);
+    pipe.transpose3D_rd = NULL;
+  }
+  else{
+    pipe.transpose3D_wr = create_kernel("transpose3D_wr", index);
+    pipe.transpose3D_rd = create_kernel("transpose3D_rd", index);
+  }
+  // the striped kernels take a buffer per bank before the order
+  status = clGetKernelInfo(pipe.transpose3D_wr, CL_KERNEL_NUM_ARGS, sizeof(cl_uint), &num_args, NULL);
+  checkError(status, "Failed to query transpose3D_wr kernel arguments");
+  pipe.transpose_banks = num_args - 1;
+  pipe.store = create_kernel("store", index);
+
+  for(unsigned i = 0; i < 2; i++){
+    pipe.transpose_buf[i] = NULL;
+    pipe.transpose_read[i] = NULL;
+  }
+  pipe.transpose_last = 0;
+
+  const unsigned box[3] = {N, N, N}, origin[3] = {0, 0, 0};
+  ddr_pipeline_prune(&pipe, box, origin);
+
+  return pipe;
+}
+
+/**
+ * \brief  create the kernels of the 3D FFT using the DDR for the 3D Transpose. In a bitstream with replicated pipelines, these are the kernels of the first one.
+ * \param  N : unsigned integer denoting the size of FFT3d
+ * \return ddr_pipeline_t : kernels of the pipeline, reading the whole input
+ */
+ddr_pipeline_t ddr_pipeline_create(const unsigned N){
+  return create_pipeline(N, ddr_pipeline_replicas() > 0 ? 0 : -1);
+}
+
+/**
+ * \brief  number of replicated pipelines in the bitstream loaded, whose kernels are suffixed by the index of the pipeline
+ * \return number of replicated pipelines, 0 if the bitstream has none
+ */
+unsigned ddr_pipeline_replicas(){
+  unsigned replicas = 0;
+  char kernel_name[32];
+
+  if(program == NULL)
+    return 0;
+
+  for(; replicas < DDR_PIPELINES_MAX; replicas++){
+    snprintf(kernel_name, sizeof(kernel_name), "fetch%u", replicas);
+    if(!kernelExists(program, kernel_name))
+      break;
+  }
+  return replicas;
+}
+
+/**
+ * \brief  create the kernels of one of the replicated pipelines of the bitstream loaded
+ * \param  N     : unsigned integer denoting the size of FFT3d
+ * \param  index : index of the pipeline, less than ddr_pipeline_replicas()
+ * \return ddr_pipeline_t : kernels of the pipeline, reading the whole input
+ */
+ddr_pipeline_t ddr_pipeline_create_replica(const unsigned N, const unsigned index){
+  return create_pipeline(N, (int)index);
+}
+
+/**
+ * \brief  allocate the buffer of the 3D Transpose of a pipeline. With the striped kernels of the fft3d_ddr_striped bitstream, the buffer is split into a part in each DDR bank, each holding every fourth block of the layout of the 3D Transpose.
+ * \param  pipe : kernels of the pipeline
+ * \param  N    : unsigned integer denoting the size of FFT3d
+ * \param  bank : channel flag of the DDR bank of the buffer if not striped
+ * \return ddr_transpose_t : the buffer of the 3D Transpose
+ */
+ddr_transpose_t ddr_transpose_create(const ddr_pipeline_t *pipe, const unsigned N, const cl_mem_flags bank){
+  cl_int status = 0;
+  const cl_mem_flags banks[TRANSPOSE3D_BANKS_MAX] = {CL_CHANNEL_1_INTELFPGA, CL_CHANNEL_2_INTELFPGA, CL_CHANNEL_3_INTELFPGA, CL_CHANNEL_4_INTELFPGA};
+  const size_t num_pts = (size_t)N * N * N;
+  ddr_transpose_t transpose;
+
+  transpose.banks = pipe->transpose_banks;
+  for(unsigned b = 0; b < TRANSPOSE3D_BANKS_MAX; b++){
+    transpose.bank[b] = NULL;
+  }
+
+  if(transpose.banks == 1){
+    transpose.bank[0] = clCreateBuffer(context, CL_MEM_READ_WRITE | bank, sizeof(float2) * num_pts, NULL, &status);
+    checkError(status, "Failed to allocate transpose device buffer\n");
+    return transpose;
+  }
+
+  for(unsigned b = 0; b < transpose.banks; b++){
+    transpose.bank[b] = clCreateBuffer(context, CL_MEM_READ_WRITE | banks[b], sizeof(float2) * num_pts / transpose.banks, NULL, &status);
+    checkError(status, "Failed to allocate striped transpose device buffer\n");
+  }
+  return transpose;
+}
+
+/**
+ * \brief  release the buffer of the 3D Transpose
+ * \param  transpose : buffer of the 3D Transpose
+ */
+void ddr_transpose_release(ddr_transpose_t *transpose){
+  for(unsigned b = 0; b < TRANSPOSE3D_BANKS_MAX; b++){
+    if(transpose->bank[b])
+      clReleaseMemObject(transpose->bank[b]);
+    transpose->bank[b] = NULL;
+  }
+}
+
+/**
+ * \brief  restrict the points read by the fetch kernel to a sub-box of the input, packed in the layout [z][y][x]. The other points are zero.
+ * \param  pipe   : kernels of the pipeline
+ * \param  box    : size of the sub-box along x, y and z, the size along x being a multiple of 8
+ * \param  origin : first point of the sub-box along x, y and z, wrapping around periodically
+ */
+void ddr_pipeline_prune(const ddr_pipeline_t *pipe, const unsigned box[3], const unsigned origin[3]){
+  cl_int status = 0;
+
+  for(cl_uint i = 0; i < 3; i++){
+    status = clSetKernelArg(pipe->fetch, 2 + i, sizeof(cl_uint), (void *)&box[i]);
+    checkError(status, "Failed to set fetch kernel box arg");
+    status = clSetKernelArg(pipe->fetch, 5 + i, sizeof(cl_uint), (void *)&origin[i]);
+    checkError(status, "Failed to set fetch kernel origin arg");
+  }
+}
+
+/**
+ * \brief  enqueue a 3D FFT of a device buffer into another without waiting for its completion. As each kernel is enqueued to its own in-order queue, successive transforms enqueued to the same queues stream through the pipeline one after another. The read of the 3D Transpose waits for its write, and the write waits for the previous read of the same buffer, so that alternating between two transpose buffers overlaps the write of a transform with the read of the previous one. The hybrid 3D Transpose is a single kernel launched on the queue of the write. With autorun stages, only the fetch, transpose3D_wr, transpose3D_rd and store kernels are launched, the fetch kernel passing the direction and order to the stages.
+ * \param  pipe      : kernels of the pipeline
+ * \param  queues    : queues of the fetch, fft3da, transpose, fft3db, transpose3D_wr, transpose3D_rd, fft3dc and store kernels, the queues of the autorun kernels being unused. The write and read of the 3D Transpose can share a queue if the transforms are not overlapped.
+ * \param  src       : device buffer of the input
+ * \param  transpose : buffer used for the 3D Transpose, allocated by ddr_transpose_create for the pipeline
+ * \param  dest      : device buffer of the output, can be the same as src
+ * \param  inv       : toggle to activate backward FFT
+ * \param  unordered : forward transforms write and backward transforms read the frequencies bit-reversed along each dimension
+ * \param  transposed : the output is stored in the layout [y][z][x] without the scatter along z
+ * \param  start     : set to the event of the fetch kernel if not NULL
+ * \param  end       : set to the event of the store kernel if not NULL
+ */
+void ddr_pipeline_enqueue(ddr_pipeline_t *pipe, cl_command_queue queues[8], cl_mem src, const ddr_transpose_t *transpose, cl_mem dest, const bool inv, const bool unordered, const bool transposed, cl_event *start, cl_event *end){
+  cl_int status = 0;
+  int order = ORDER_NATURAL;
+  if(unordered)
+    order = inv ? ORDER_BITREV_IN : ORDER_BITREV_OUT;
+
+  // Can't pass bool to device, so convert it to int
+  int inverse_int = (int)inv;
+  int transposed_int = (int)transposed;
+
+  status = clSetKernelArg(pipe->fetch, 0, sizeof(cl_mem), (void *)&src);
+  checkError(status, "Failed to set fetch kernel arg 0");
+  status = clSetKernelArg(pipe->fetch, 1, sizeof(cl_int), (void *)&order);
+  checkError(status, "Failed to set fetch kernel arg 1");
+  if(pipe->autorun){
+    status = clSetKernelArg(pipe->fetch, FETCH_NUM_ARGS, sizeof(cl_int), (void *)&inverse_int);
+    checkError(status, "Failed to set fetch kernel direction arg");
+  }
+  else{
+    status = clSetKernelArg(pipe->transpose, 0, sizeof(cl_int), (void *)&order);
+    checkError(status, "Failed to set transpose kernel arg");
+    status = clSetKernelArg(pipe->ffta, 0, sizeof(cl_int), (void*)&inverse_int);
+    checkError(status, "Failed to set ffta kernel arg");
+    status = clSetKernelArg(pipe->fftb, 0, sizeof(cl_int), (void*)&inverse_int);
+    checkError(status, "Failed to set fftb kernel arg");
+    status = clSetKernelArg(pipe->fftc, 0, sizeof(cl_int), (void*)&inverse_int);
+    checkError(status, "Failed to set fftc kernel arg");
+  }
+  // one buffer argument per bank of the 3D Transpose, followed by the order
+  const cl_uint banks = pipe->transpose_banks;
+  for(cl_uint b = 0; b < banks; b++){
+    status = clSetKernelArg(pipe->transpose3D_wr, b, sizeof(cl_mem), (void *)&transpose->bank[b]);
+    checkError(status, "Failed to set transpose3D_wr kernel buffer arg");
+  }
+  status = clSetKernelArg(pipe->transpose3D_wr, banks, sizeof(cl_int), (void*)&order);
+  checkError(status, "Failed to set transpose3D_wr kernel order arg");
+  if(pipe->transpose3D_rd){
+    for(cl_uint b = 0; b < banks; b++){
+      status = clSetKernelArg(pipe->transpose3D_rd, b, sizeof(cl_mem), (void *)&transpose->bank[b]);
+      checkError(status, "Failed to set transpose3D_rd kernel buffer arg");
+    }
+    status = clSetKernelArg(pipe->transpose3D_rd, banks, sizeof(cl_int), (void*)&order);
+    checkError(status, "Failed to set transpose3D_rd kernel order arg");
+  }
+  status = clSetKernelArg(pipe->store, 0, sizeof(cl_mem), (void *)&dest);
+  checkError(status, "Failed to set store kernel arg 0");
+  status = clSetKernelArg(pipe->store, 1, sizeof(cl_int), (void *)&order);
+  checkError(status, "Failed to set store kernel arg 1");
+  status = clSetKernelArg(pipe->store, 2, sizeof(cl_int), (void *)&transposed_int);
+  checkError(status, "Failed to set store kernel arg 2");
+
+  // the transpose buffer, identified by its first part, replaces the least recently used one of the two tracked
+  unsigned slot = !pipe->transpose_last;
+  if(pipe->transpose_buf[pipe->transpose_last] == transpose->bank[0])
+    slot = pipe->transpose_last;
+  else if(pipe->transpose_buf[slot] != transpose->bank[0] && pipe->transpose_read[slot] != NULL){
+    clReleaseEvent(pipe->transpose_read[slot]);
+    pipe->transpose_read[slot] = NULL;
+  }
+  pipe->transpose_buf[slot] = transpose->bank[0];
+  pipe->transpose_last = slot;
+
+  // Kernel Execution
+  status = clEnqueueTask(queues[7], pipe->store, 0, NULL, end);
+  checkError(status, "Failed to launch store kernel");
+
+  if(!pipe->autorun){
+    status = clEnqueueTask(queues[6], pipe->fftc, 0, NULL, NULL);
+    checkError(status, "Failed to launch fft kernel");
+  }
+
+  // the write does not overwrite the buffer before its previous read has completed
+  cl_event write_event;
+  cl_event *read_event = &pipe->transpose_read[slot];
+  const cl_uint num_wait = (*read_event != NULL) ? 1 : 0;
+  status = clEnqueueTask(queues[4], pipe->transpose3D_wr, num_wait, num_wait ? read_event : NULL, &write_event);
+  checkError(status, "Failed to launch write of transpose3d kernel");
+
+  if(*read_event != NULL)
+    clReleaseEvent(*read_event);
+
+  // read of the 3D transpose once its write has completed, part of the write with the hybrid transpose
+  if(pipe->transpose3D_rd){
+    status = clEnqueueTask(queues[5], pipe->transpose3D_rd, 1, &write_event, read_event);
+    checkError(status, "Failed to launch read of transpose3d kernel");
+    clReleaseEvent(write_event);
+  }
+  else{
+    *read_event = write_event;
+  }
+
+  if(!pipe->autorun){
+    status = clEnqueueTask(queues[3], pipe->fftb, 0, NULL, NULL);
+    checkError(status, "Failed to launch second fft kernel");
+
+    status = clEnqueueTask(queues[2], pipe->transpose, 0, NULL, NULL);
+    checkError(status, "Failed to launch transpose kernel");
+
+    status = clEnqueueTask(queues[1], pipe->ffta, 0, NULL, NULL);
+    checkError(status, "Failed to launch fft kernel");
+  }
+
+  status = clEnqueueTask(queues[0], pipe->fetch, 0, NULL, start);
+  checkError(status, "Failed to launch fetch kernel");
+}
+
+/**
+ * \brief  compute a 3D FFT of a device buffer into another without transfers to the host. The queues must have been setup.
+ * \param  pipe      : kernels of the pipeline
+ * \param  src       : device buffer of the input
+ * \param  transpose : buffer used for the 3D Transpose, allocated by ddr_transpose_create for the pipeline
+ * \param  dest      : device buffer of the output, can be the same as src
+ * \param  inv       : toggle to activate backward FFT
+ * \param  unordered : forward transforms write and backward transforms read the frequencies bit-reversed along each dimension
+ * \param  transposed : the output is stored in the layout [y][z][x] without the scatter along z. As the pipeline transforms the dimensions in the order they are stored, an input in this layout gives an output in the layout [z][y][x].
+ * \return time taken in milliseconds for the execution
+ */
+double ddr_pipeline_run(ddr_pipeline_t *pipe, cl_mem src, const ddr_transpose_t *transpose, cl_mem dest, const bool inv, const bool unordered, const bool transposed){
+  cl_int status = 0;
+  // a single transform, the write and read of the 3D Transpose share a queue
+  cl_command_queue queues[8] = {queue1, queue2, queue3, queue4, queue5, queue5, queue6, queue7};
+
+  cl_event startExec_event, endExec_event;
+  ddr_pipeline_enqueue(pipe, queues, src, transpose, dest, inv, unordered, transposed, &startExec_event, &endExec_event);
+
+  status = clFinish(queue1);
+  checkError(status, "failed to finish queue1");
+  status = clFinish(queue2);
+  checkError(status, "failed to finish queue2");
+  status = clFinish(queue3);
+  checkError(status, "failed to finish queue3");
+  status = clFinish(queue4);
+  checkError(status, "failed to finish queue4");
+  status = clFinish(queue5);
+  checkError(status, "failed to finish queue5");
+  status = clFinish(queue6);
+  checkError(status, "failed to finish queue6");
+  status = clFinish(queue7);
+  checkError(status, "failed to finish queue7");
+
+  cl_ulong kernel_start = 0, kernel_end = 0;
+  clGetEventProfilingInfo(startExec_event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &kernel_start, NULL);
+  clGetEventProfilingInfo(endExec_event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &kernel_end, NULL);
+
+  clReleaseEvent(startExec_event);
+  clReleaseEvent(endExec_event);
+
+  return (cl_double)(kernel_end - kernel_start) * (cl_double)(1e-06);
+}
+
+/**
+ * \brief  release the kernels of the pipeline
+ * \param  pipe : kernels of the pipeline
+ */
+void ddr_pipeline_release(ddr_pipeline_t *pipe){
+  if(pipe->fetch)
+    clReleaseKernel(pipe->fetch);
+  if(pipe->ffta)
+    clReleaseKernel(pipe->ffta);
+  if(pipe->transpose)
+    clReleaseKernel(pipe->transpose);
+  if(pipe->fftb)
+    clReleaseKernel(pipe->fftb);
+  if(pipe->transpose3D_wr)
+    clReleaseKernel(pipe->transpose3D_wr);
+  if(pipe->transpose3D_rd)
+    clReleaseKernel(pipe->transpose3D_rd);
+  if(pipe->fftc)
+    clReleaseKernel(pipe->fftc);
+  if(pipe->store)
+    clReleaseKernel(pipe->store);
+
+  for(unsigned i = 0; i < 2; i++){
+    if(pipe->transpose_read[i])
+      clReleaseEvent(pipe->transpose_read[i]);
+    pipe->transpose_read[i] = NULL;
+  }
+}
+
+/**
+ * \brief  largest number of transforms held by a buffer taking 1 / parts of a DDR bank
+ */
+static cl_ulong ddr_batch_limit(const size_t num_pts, const cl_ulong max_alloc, const cl_ulong global_mem, const unsigned parts){
+  cl_ulong limit = global_mem / (4 * parts);
+  if(max_alloc < limit)
+    limit = max_alloc;
+  limit /= sizeof(float2) * num_pts;
+  if(((cl_ulong)1 << 32) / num_pts < limit)
+    limit = ((cl_ulong)1 << 32) / num_pts;
+  return limit;
+}
+
+/**
+ * \brief  number of transforms of a batch computed by each launch of the kernels of the fft3d_ddr_batch bitstream. A piece is as large as the device allows, so that the pipeline drains as rarely as possible: its input and output each fit into a DDR bank, a quarter of the global memory, and into the largest allocation, and the kernels index its points with 32-bit integers. A batch that does not fit into a single piece is split into pieces alternating between two buffers, whose transfers overlap the computation of another piece, so that two of them have to fit into a bank.
+ * \param  N        : unsigned integer denoting the size of FFT3d
+ * \param  how_many : number of transforms of the batch
+ * \return number of transforms per piece, the whole batch if it fits, 0 if a single transform does not fit into the device buffers
+ */
+unsigned ddr_batch_piece(const unsigned N, const unsigned how_many){
+  const size_t num_pts = (size_t)N * N * N;
+  cl_ulong max_alloc = 0, global_mem = 0;
+
+  clGetDeviceInfo(device, CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(cl_ulong), &max_alloc, NULL);
+  clGetDeviceInfo(device, CL_DEVICE_GLOBAL_MEM_SIZE, sizeof(cl_ulong), &global_mem, NULL);
+
+  if(how_many <= ddr_batch_limit(num_pts, max_alloc, global_mem, 1))
+    return how_many;
+  return (unsigned)ddr_batch_limit(num_pts, max_alloc, global_mem, 2);
+}
@@ -0,0 +1,77 @@
+// Author: Arjun Ramaswami
+
+#ifndef FFT3D_PIPELINE_H
+#define FFT3D_PIPELINE_H
+
+#include <stdbool.h>
+#include "CL/opencl.h"
+
+// Kernels of the 3D FFT using the DDR of the FPGA for the 3D Transpose
+typedef struct {
+  cl_kernel fetch;
+  cl_kernel ffta;
+  cl_kernel transpose;
+  cl_kernel fftb;
+  // transpose3D_hybrid in place of transpose3D_wr if the bitstream has it, transpose3D_rd is then NULL
+  cl_kernel transpose3D_wr;
+  cl_kernel transpose3D_rd;
+  // number of DDR banks the buffer of the 3D Transpose is striped across, one buffer argument each
+  unsigned transpose_banks;
+  cl_kernel fftc;
+  cl_kernel store;
+  // fft3da, transpose, fft3db and fft3dc are autorun kernels, not launched by the host
+  bool autorun;
+  // last two buffers of the 3D Transpose and the events of their last reads, which their next writes wait for
+  cl_mem transpose_buf[2];
+  cl_event transpose_read[2];
+  unsigned transpose_last;
+} ddr_pipeline_t;
+
+// Create the kernels of the pipeline from the program loaded, the first one if replicated
+ddr_pipeline_t ddr_pipeline_create(const unsigned N);
+
+// Largest number of replicated pipelines in a bitstream, one per DDR bank
+#define DDR_PIPELINES_MAX 4
+
+// Number of replicated pipelines of the program loaded, suffixed by their index
+unsigned ddr_pipeline_replicas();
+
+// Create the kernels of a replicated pipeline from the program loaded
+ddr_pipeline_t ddr_pipeline_create_replica(const unsigned N, const unsigned index);
+
+// Restrict the input read to a sub-box, the other points being zero
+void ddr_pipeline_prune(const ddr_pipeline_t *pipe, const unsigned box[3], const unsigned origin[3]);
+
+// Largest number of DDR banks the buffer of the 3D Transpose is striped across
+#define TRANSPOSE3D_BANKS_MAX 4
+
+// Buffer of the 3D Transpose, one part per DDR bank with the striped kernels
+typedef struct {
+  cl_mem bank[TRANSPOSE3D_BANKS_MAX];
+  unsigned banks;
+} ddr_transpose_t;
+
+// Allocate the buffer of the 3D Transpose of the pipeline in the bank given, or across all banks if striped
+ddr_transpose_t ddr_transpose_create(const ddr_pipeline_t *pipe, const unsigned N, const cl_mem_flags bank);
+
+// Release the buffer of the 3D Transpose
+void ddr_transpose_release(ddr_transpose_t *transpose);
+
+// Order of the points in global memory passed to the kernels
+#define ORDER_NATURAL 0
+#define ORDER_BITREV_OUT 1
+#define ORDER_BITREV_IN 2
+
+// Enqueue a 3D FFT from one device buffer to another on the queues given, one per kernel, without waiting for it
+void ddr_pipeline_enqueue(ddr_pipeline_t *pipe, cl_command_queue queues[8], cl_mem src, const ddr_transpose_t *transpose, cl_mem dest, const bool inv, const bool unordered, const bool transposed, cl_event *start, cl_event *end);
+
+// Compute a 3D FFT from one device buffer to another, returns the execution time in milliseconds
+double ddr_pipeline_run(ddr_pipeline_t *pipe, cl_mem src, const ddr_transpose_t *transpose, cl_mem dest, const bool inv, const bool unordered, const bool transposed);
+
+// Release the kernels of the pipeline
+void ddr_pipeline_release(ddr_pipeline_t *pipe);
+
+// Number of transforms of a batch computed per launch of the fft3d_ddr_batch kernels, the whole batch if it fits, 0 if a transform does not fit
+unsigned ddr_batch_piece(const unsigned N, const unsigned how_many);
+
+#endif
@@ -0,0 +1,91 @@
+// Author: Arjun Ramaswami
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "fftfpga/fftfpga.h"
+#include "misc.h"
+
+// Tiles of 32 x 32 points, 8 KiB that stay in the L1 cache while transposed
+#define LOG_TILE 5
+#define TILE (1 << LOG_TILE)
+
+/**
+ * \brief  reorder the points of each line from the bit-reversed order of the FFT engine to natural order, out of place. The index of a point is split into a high and a low part of LOG_TILE bits around the middle bits. For each value of the middle bits, the points with all values of the high and low parts are copied as contiguous rows into a tile, which is then written out as contiguous rows with the roles of the parts swapped and reversed. Both passes over global memory are thus sequential, as in a copy, with the strided accesses confined to the tile in cache. The tiles are distributed over the threads with OpenMP when the library is built with it.
+ * \param  N        : unsigned integer number of points per line, a power of 2
+ * \param  how_many : number of lines
+ * \param  inp      : float2 pointer to the lines in bit-reversed order, of size [N * how_many]
+ * \param  out      : float2 pointer to the lines in natural order, of the same size and distinct from inp
+ * \return 0 if successful, -1 if the arguments are invalid
+ */
+int fftfpgaf_bit_reverse(const unsigned N, const unsigned how_many, const float2 *inp, float2 *out){
+
+  // if N is not a power of 2
+  if(inp == NULL || out == NULL || inp == out || N == 0 || ((N & (N-1)) != 0)){
+    return -1;
+  }
+
+  unsigned logN = 0;
+  while((1u << logN) < N)
+    logN++;
+
+  const size_t num_lines = how_many;
+
+  // lines smaller than two tiles fit into the cache as a whole
+  if(logN < 2 * LOG_TILE){
+#ifdef _OPENMP
+    #pragma omp parallel for if(num_lines * N >= (1 << 16))
+#endif
+    for(size_t j = 0; j < num_lines; j++){
+      for(unsigned i = 0; i < N; i++){
+        out[(j * N) + i] = inp[(j * N) + bit_reversed(i, logN)];
+      }
+    }
+    return 0;
+  }
+
+  const unsigned mid_bits = logN - 2 * LOG_TILE;
+  const size_t num_mid = (size_t)1 << mid_bits;
+  const unsigned high = logN - LOG_TILE;
+
+  unsigned rev_tile[TILE];
+  for(unsigned a = 0; a < TILE; a++){
+    rev_tile[a] = bit_reversed(a, LOG_TILE);
+  }
+
+#ifdef _OPENMP
+  #pragma omp parallel for
+#endif
+  for(size_t task = 0; task < num_lines * num_mid; task++){
+    const size_t line = task / num_mid;
+    const size_t mid = task % num_mid;
+    const size_t rev_mid = bit_reversed((unsigned)mid, mid_bits);
+    const float2 *src = &inp[line * N];
+    float2 *dest = &out[line * N];
+    float2 tile[TILE * TILE];
+
+    // rows of the tile: the points of a high part, contiguous in the input
+    for(unsigned a = 0; a < TILE; a++){
+      const float2 *row = &src[((size_t)a << high) | (mid << LOG_TILE)];
+#ifdef _OPENMP
+      #pragma omp simd
+#endif
+      for(unsigned b = 0; b < TILE; b++){
+        tile[(a * TILE) + b] = row[b];
+      }
+    }
+
+    // columns of the tile in bit-reversed order: contiguous in the output
+    for(unsigned b = 0; b < TILE; b++){
+      float2 *row = &dest[((size_t)rev_tile[b] << high) | (rev_mid << LOG_TILE)];
+#ifdef _OPENMP
+      #pragma omp simd
+#endif
+      for(unsigned a = 0; a < TILE; a++){
+        row[a] = tile[(rev_tile[a] * TILE) + b];
+      }
+    }
+  }
+
+  return 0;
+}
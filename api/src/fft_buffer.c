@@ -0,0 +1,350 @@
+// Author: Arjun Ramaswami
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#define CL_VERSION_2_0
+#include <CL/cl_ext_intelfpga.h> // to disable interleaving & transfer data to specific banks - CL_CHANNEL_1_INTELFPGA
+#include "CL/opencl.h"
+
+#include "fpga_state.h"
+#include "fftfpga/fftfpga.h"
+#include "fft_buffer.h"
+#include "opencl_utils.h"
+
+// Number of global memory banks that can be selected, 0 being interleaved
+#define NUM_BANKS 5
+
+static const cl_mem_flags bank_flags[NUM_BANKS] = {
+  0, CL_CHANNEL_1_INTELFPGA, CL_CHANNEL_2_INTELFPGA, CL_CHANNEL_3_INTELFPGA, CL_CHANNEL_4_INTELFPGA
+};
+
+// list of the buffers allocated on the device
+static struct fftfpga_buffer_t *buffers = NULL;
+
+/**
+ * \brief  allocate a buffer of single precision complex points in the global memory of the FPGA
+ * \param  num_pts : number of complex points
+ * \param  bank    : global memory bank, 0 for burst interleaved placement or 1 to 4
+ * \return handle to the buffer, NULL if no bitstream is loaded or the allocation fails
+ */
+fftfpga_buffer fftfpgaf_buffer_alloc(const size_t num_pts, const unsigned bank){
+  cl_int status = 0;
+
+  if(program == NULL || num_pts == 0 || bank >= NUM_BANKS)
+    return NULL;
+
+  cl_mem mem = clCreateBuffer(context, CL_MEM_READ_WRITE | bank_flags[bank], sizeof(float2) * num_pts, NULL, &status);
+  if(status != CL_SUCCESS)
+    return NULL;
+
+  fftfpga_buffer buf = (fftfpga_buffer)malloc(sizeof(struct fftfpga_buffer_t));
+  if(buf == NULL){
+    clReleaseMemObject(mem);
+    return NULL;
+  }
+
+  buf->mem = mem;
+  buf->num_pts = num_pts;
+  buf->bank = bank;
+  buf->next = buffers;
+  buffers = buf;
+
+  return buf;
+}
+
+/**
+ * \brief  release a buffer allocated on the FPGA
+ * \param  buf : handle to the buffer, can be NULL
+ */
+void fftfpgaf_buffer_free(fftfpga_buffer buf){
+  if(buf == NULL)
+    return;
+
+  for(struct fftfpga_buffer_t **it = &buffers; *it != NULL; it = &(*it)->next){
+    if(*it == buf){
+      *it = buf->next;
+      break;
+    }
+  }
+
+  if(buf->mem)
+    clReleaseMemObject(buf->mem);
+  free(buf);
+}
+
+/**
+ * \brief  copy points from the host to a buffer on the FPGA
+ * \param  buf     : handle to the buffer
+ * \param  inp     : float2 pointer to the points to copy
+ * \param  num_pts : number of points, at most the size of the buffer
+ * \return fpga_t : time taken in milliseconds for the PCIe write
+ */
+fpga_t fftfpgaf_buffer_upload(fftfpga_buffer buf, const float2 *inp, const size_t num_pts){
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0};
+  cl_int status = 0;
+
+  if(inp == NULL || !buffer_valid(buf, num_pts))
+    return fft_time;
+
+  queue_setup();
+
+  cl_event writeBuf_event;
+  status = clEnqueueWriteBuffer(queue1, buf->mem, CL_TRUE, 0, sizeof(float2) * num_pts, inp, 0, NULL, &writeBuf_event);
+  checkError(status, "Failed to copy data to device");
+
+  cl_ulong writeBuf_start = 0, writeBuf_end = 0;
+  clGetEventProfilingInfo(writeBuf_event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &writeBuf_start, NULL);
+  clGetEventProfilingInfo(writeBuf_event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &writeBuf_end, NULL);
+
+  fft_time.pcie_write_t = (cl_double)(writeBuf_end - writeBuf_start) * (cl_double)(1e-06);
+
+  clReleaseEvent(writeBuf_event);
+  queue_cleanup();
+
+  fft_time.valid = 1;
+  return fft_time;
+}
+
+/**
+ * \brief  copy points from a buffer on the FPGA to the host
+ * \param  buf     : handle to the buffer
+ * \param  out     : float2 pointer to the destination
+ * \param  num_pts : number of points, at most the size of the buffer
+ * \return fpga_t : time taken in milliseconds for the PCIe read
+ */
+fpga_t fftfpgaf_buffer_download(const fftfpga_buffer buf, float2 *out, const size_t num_pts){
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0};
+  cl_int status = 0;
+
+  if(out == NULL || !buffer_valid(buf, num_pts))
+    return fft_time;
+
+  queue_setup();
+
+  cl_event readBuf_event;
+  status = clEnqueueReadBuffer(queue1, buf->mem, CL_TRUE, 0, sizeof(float2) * num_pts, out, 0, NULL, &readBuf_event);
+  checkError(status, "Failed to copy data from device to host");
+
+  cl_ulong readBuf_start = 0, readBuf_end = 0;
+  clGetEventProfilingInfo(readBuf_event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &readBuf_start, NULL);
+  clGetEventProfilingInfo(readBuf_event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &readBuf_end, NULL);
+
+  fft_time.pcie_read_t = (cl_double)(readBuf_end - readBuf_start) * (cl_double)(1e-06);
+
+  clReleaseEvent(readBuf_event);
+  queue_cleanup();
+
+  fft_time.valid = 1;
+  return fft_time;
+}
+
+/**
+ * \brief  copy a sub-box of a cube of points from a buffer on the FPGA to a strided host array
+ * \param  buf    : handle to the buffer holding the cube in the layout [z][y][x]
+ * \param  N      : unsigned integer denoting the size of the cube
+ * \param  box    : size of the sub-box along x, y and z
+ * \param  origin : first point of the sub-box along x, y and z, wrapping around periodically
+ * \param  out    : float2 pointer to the first point of the sub-box in the host array
+ * \param  ld     : number of points per row and rows per slice of the host array
+ * \return fpga_t : time taken in milliseconds for the PCIe read
+ */
+fpga_t fftfpgaf_buffer_download_region(const fftfpga_buffer buf, const unsigned N, const unsigned box[3], const unsigned origin[3], float2 *out, const unsigned ld[2]){
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0};
+
+  if(out == NULL || !buffer_valid(buf, (size_t)N * N * N) || !region_valid(N, box, origin, ld))
+    return fft_time;
+
+  queue_setup();
+  fft_time.pcie_read_t = buffer_read_region(buf->mem, N, box, origin, out, ld);
+  queue_cleanup();
+
+  fft_time.valid = 1;
+  return fft_time;
+}
+
+/**
+ * \brief  check if a sub-box is within a cube and fits into the host array
+ * \param  N      : size of the cube
+ * \param  box    : size of the sub-box along x, y and z
+ * \param  origin : first point of the sub-box along x, y and z
+ * \param  ld     : number of points per row and rows per slice of the host array
+ * \return true if the region can be read
+ */
+bool region_valid(const unsigned N, const unsigned box[3], const unsigned origin[3], const unsigned ld[2]){
+  if(box == NULL || origin == NULL || ld == NULL)
+    return false;
+
+  for(unsigned i = 0; i < 3; i++){
+    if(box[i] == 0 || box[i] > N || origin[i] >= N)
+      return false;
+  }
+  return (ld[0] >= box[0]) && (ld[1] >= box[1]);
+}
+
+/**
+ * \brief  read a sub-box of a cube with rectangular transfers, so that only its points cross PCIe. A sub-box wrapping around the cube is read in up to 8 pieces. The queues must have been setup.
+ * \param  mem    : device buffer holding the cube in the layout [z][y][x]
+ * \param  N      : size of the cube
+ * \param  box    : size of the sub-box along x, y and z
+ * \param  origin : first point of the sub-box along x, y and z, wrapping around periodically
+ * \param  out    : float2 pointer to the first point of the sub-box in the host array
+ * \param  ld     : number of points per row and rows per slice of the host array
+ * \return time taken in milliseconds for the PCIe reads
+ */
+double buffer_read_region(cl_mem mem, const unsigned N, const unsigned box[3], const unsigned origin[3], float2 *out, const unsigned ld[2]){
+  cl_int status = 0;
+  double read_t = 0.0;
+
+  // pieces of the sub-box along each dimension: up to the end of the cube and wrapped around
+  size_t start[3][2], len[3][2], host[3][2];
+  for(unsigned i = 0; i < 3; i++){
+    len[i][0] = (origin[i] + box[i] > N) ? N - origin[i] : box[i];
+    start[i][0] = origin[i];
+    host[i][0] = 0;
+    len[i][1] = box[i] - len[i][0];
+    start[i][1] = 0;
+    host[i][1] = len[i][0];
+  }
+
+  cl_event readBuf_event[8];
+  unsigned num_events = 0;
+  for(unsigned pz = 0; pz < 2; pz++){
+    for(unsigned py = 0; py < 2; py++){
+      for(unsigned px = 0; px < 2; px++){
+        if(len[0][px] == 0 || len[1][py] == 0 || len[2][pz] == 0)
+          continue;
+
+        // offsets along x are in bytes
+        const size_t buffer_origin[3] = {start[0][px] * sizeof(float2), start[1][py], start[2][pz]};
+        const size_t host_origin[3] = {host[0][px] * sizeof(float2), host[1][py], host[2][pz]};
+        const size_t region[3] = {len[0][px] * sizeof(float2), len[1][py], len[2][pz]};
+
+        status = clEnqueueReadBufferRect(queue1, mem, CL_FALSE, buffer_origin, host_origin, region,
+          sizeof(float2) * N, sizeof(float2) * N * N,
+          sizeof(float2) * ld[0], sizeof(float2) * ld[0] * ld[1],
+          out, 0, NULL, &readBuf_event[num_events]);
+        checkError(status, "Failed to copy region from device to host");
+        num_events++;
+      }
+    }
+  }
+
+  status = clFinish(queue1);
+  checkError(status, "failed to finish reading DDR using PCIe");
+
+  for(unsigned i = 0; i < num_events; i++){
+    cl_ulong readBuf_start = 0, readBuf_end = 0;
+    clGetEventProfilingInfo(readBuf_event[i], CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &readBuf_start, NULL);
+    clGetEventProfilingInfo(readBuf_event[i], CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &readBuf_end, NULL);
+    clReleaseEvent(readBuf_event[i]);
+
+    read_t += (cl_double)(readBuf_end - readBuf_start) * (cl_double)(1e-06);
+  }
+
+  return read_t;
+}
+
+/**
+ * \brief  check if a layout of transforms given by the stride between their points and the distance between their first points is supported: the points of a transform are contiguous and the transforms do not overlap. Larger strides would need a DMA row per point, slower than gathering the points on the host, which is left to the caller.
+ * \param  num_pts  : number of points of a transform
+ * \param  how_many : number of transforms
+ * \param  stride   : distance between consecutive points of a transform
+ * \param  dist     : distance between the first points of consecutive transforms
+ * \return true if the points are contiguous and the transforms do not overlap
+ */
+bool layout_valid(const size_t num_pts, const unsigned how_many, const size_t stride, const size_t dist){
+  if(num_pts == 0 || how_many == 0 || stride != 1 || dist == 0)
+    return false;
+
+  // transforms one after another
+  return (how_many == 1) || (dist >= num_pts);
+}
+
+/**
+ * \brief  enqueue a transfer of transforms between a contiguous device buffer and a host array in the layout of the advanced interface of FFTW with contiguous points, without gathering them on the host and without waiting for it. Transforms one after another are transferred using a single burst, others using a single rectangular transfer of a row per transform.
+ * \param  queue    : queue of the transfer
+ * \param  mem      : device buffer of how_many * num_pts points
+ * \param  write    : toggle to write to the device, else read from the device
+ * \param  num_pts  : number of points of a transform
+ * \param  how_many : number of transforms
+ * \param  host     : pointer to the host array
+ * \param  dist     : distance between the first points of consecutive transforms in the host array
+ * \param  num_wait : number of events in wait
+ * \param  wait     : events the transfer waits for, NULL if num_wait is 0
+ * \param  event    : set to the event of the transfer
+ */
+void buffer_enqueue_strided(cl_command_queue queue, cl_mem mem, const bool write, const size_t num_pts, const unsigned how_many, void *host, const size_t dist, const cl_uint num_wait, const cl_event *wait, cl_event *event){
+  cl_int status = 0;
+
+  if(dist == num_pts || how_many == 1){
+    if(write)
+      status = clEnqueueWriteBuffer(queue, mem, CL_FALSE, 0, sizeof(float2) * num_pts * how_many, host, num_wait, wait, event);
+    else
+      status = clEnqueueReadBuffer(queue, mem, CL_FALSE, 0, sizeof(float2) * num_pts * how_many, host, num_wait, wait, event);
+  }
+  else{
+    // a row of points per transform
+    const size_t origin[3] = {0, 0, 0};
+    const size_t region[3] = {sizeof(float2) * num_pts, how_many, 1};
+    const size_t buffer_pitch = sizeof(float2) * num_pts, host_pitch = sizeof(float2) * dist;
+    if(write)
+      status = clEnqueueWriteBufferRect(queue, mem, CL_FALSE, origin, origin, region,
+        buffer_pitch, buffer_pitch * how_many, host_pitch, host_pitch * how_many,
+        host, num_wait, wait, event);
+    else
+      status = clEnqueueReadBufferRect(queue, mem, CL_FALSE, origin, origin, region,
+        buffer_pitch, buffer_pitch * how_many, host_pitch, host_pitch * how_many,
+        host, num_wait, wait, event);
+  }
+  checkError(status, "Failed to transfer strided data");
+}
+
+/**
+ * \brief  transfer transforms between a contiguous device buffer and a host array in the layout of the advanced interface of FFTW with contiguous points, as buffer_enqueue_strided, and wait for the transfer. The queues must have been setup.
+ * \param  mem      : device buffer of how_many * num_pts points
+ * \param  write    : toggle to write to the device, else read from the device
+ * \param  num_pts  : number of points of a transform
+ * \param  how_many : number of transforms
+ * \param  host     : pointer to the host array
+ * \param  dist     : distance between the first points of consecutive transforms in the host array
+ * \return time taken in milliseconds for the PCIe transfers
+ */
+double buffer_transfer_strided(cl_mem mem, const bool write, const size_t num_pts, const unsigned how_many, void *host, const size_t dist){
+  cl_int status = 0;
+  cl_event event;
+
+  buffer_enqueue_strided(queue1, mem, write, num_pts, how_many, host, dist, 0, NULL, &event);
+
+  status = clFinish(queue1);
+  checkError(status, "failed to finish strided transfer using PCIe");
+
+  cl_ulong transfer_start = 0, transfer_end = 0;
+  clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &transfer_start, NULL);
+  clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &transfer_end, NULL);
+  clReleaseEvent(event);
+
+  return (cl_double)(transfer_end - transfer_start) * (cl_double)(1e-06);
+}
+
+/**
+ * \brief  check if the handle refers to a device buffer large enough
+ * \param  buf     : handle to the buffer
+ * \param  num_pts : number of points required
+ * \return true if the buffer is allocated on the loaded device with at least num_pts points
+ */
+bool buffer_valid(const fftfpga_buffer buf, const size_t num_pts){
+  return (buf != NULL) && (buf->mem != NULL) && (num_pts > 0) && (num_pts <= buf->num_pts);
+}
+
+/**
+ * \brief  release the device memory of every buffer before the context is released. The handles remain valid for fftfpgaf_buffer_free.
+ */
+void buffer_cleanup(){
+  for(struct fftfpga_buffer_t *it = buffers; it != NULL; it = it->next){
+    if(it->mem)
+      clReleaseMemObject(it->mem);
+    it->mem = NULL;
+  }
+  buffers = NULL;
+}
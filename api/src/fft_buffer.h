@@ -0,0 +1,39 @@
+// Author: Arjun Ramaswami
+
+#ifndef FFT_BUFFER_H
+#define FFT_BUFFER_H
+
+#include <stddef.h>
+#include "CL/opencl.h"
+#include "fftfpga/fftfpga.h"
+
+// Data of a device buffer handle
+struct fftfpga_buffer_t {
+  cl_mem mem;                     // NULL once the device has been released
+  size_t num_pts;                 // number of complex points
+  unsigned bank;                  // 0 if interleaved, else the global memory bank
+  struct fftfpga_buffer_t *next;  // buffers allocated, released by fpga_final
+};
+
+// Check if the handle refers to a device buffer of at least num_pts points
+bool buffer_valid(const fftfpga_buffer buf, const size_t num_pts);
+
+// Release the device memory of every buffer allocated, the handles remain to be freed
+void buffer_cleanup();
+
+// Check if a sub-box of a cube of size N fits into a host array with the leading dimensions ld
+bool region_valid(const unsigned N, const unsigned box[3], const unsigned origin[3], const unsigned ld[2]);
+
+// Read a sub-box of a cube of size N in device memory to a strided host array, returns the PCIe time in milliseconds
+double buffer_read_region(cl_mem mem, const unsigned N, const unsigned box[3], const unsigned origin[3], float2 *out, const unsigned ld[2]);
+
+// Check if how_many transforms of num_pts points with the stride and distance given have contiguous points and do not overlap
+bool layout_valid(const size_t num_pts, const unsigned how_many, const size_t stride, const size_t dist);
+
+// Enqueue a transfer of how_many transforms between a contiguous device buffer and a host array with a distance between them on the queue given
+void buffer_enqueue_strided(cl_command_queue queue, cl_mem mem, const bool write, const size_t num_pts, const unsigned how_many, void *host, const size_t dist, const cl_uint num_wait, const cl_event *wait, cl_event *event);
+
+// Transfer how_many transforms between a contiguous device buffer and a host array with a distance between them, returns the PCIe time in milliseconds
+double buffer_transfer_strided(cl_mem mem, const bool write, const size_t num_pts, const unsigned how_many, void *host, const size_t dist);
+
+#endif
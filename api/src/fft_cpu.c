@@ -0,0 +1,146 @@
+// Author: Arjun Ramaswami
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <fftw3.h>
+
+#include "fftfpga/fftfpga.h"
+#include "fft_cpu.h"
+#include "misc.h"
+
+// Maximum number of FFTW plans kept alive between calls
+#define PLAN_CACHE_SIZE 32
+
+typedef struct {
+  unsigned dim;
+  unsigned N;
+  unsigned how_many;
+  bool inv;
+  bool inplace;
+  bool aligned;
+  fftwf_plan plan;
+} cpu_plan_t;
+
+static cpu_plan_t plan_cache[PLAN_CACHE_SIZE];
+static unsigned num_plans = 0, next_evict = 0;
+static bool threads_initialized = false;
+
+/**
+ * \brief  number of threads used by FFTW, FFTFPGA_CPU_THREADS if set in the environment, otherwise all the online cores
+ * \return number of threads
+ */
+static int cpu_threads(){
+  const char *env = getenv("FFTFPGA_CPU_THREADS");
+  if(env != NULL && atoi(env) > 0)
+    return atoi(env);
+
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  return cores > 0 ? (int)cores : 1;
+}
+
+/**
+ * \brief  returns a cached plan for the given transform, planning it with FFTW_MEASURE on scratch buffers if not found
+ * \return FFTW plan or NULL if planning failed
+ */
+static fftwf_plan get_plan(const unsigned dim, const unsigned N, const unsigned how_many, const bool inv, const bool inplace, const bool aligned){
+
+  for(unsigned i = 0; i < num_plans; i++){
+    cpu_plan_t *p = &plan_cache[i];
+    if(p->dim == dim && p->N == N && p->how_many == how_many && p->inv == inv && p->inplace == inplace && p->aligned == aligned)
+      return p->plan;
+  }
+
+  if(!threads_initialized){
+    fftwf_init_threads();
+    threads_initialized = true;
+  }
+  fftwf_plan_with_nthreads(cpu_threads());
+
+  int n[3] = {N, N, N};
+  size_t sz = 1;
+  for(unsigned i = 0; i < dim; i++)
+    sz *= N;
+  int dist = (int)sz;
+
+  // FFTW_MEASURE overwrites the arrays, hence plan on scratch buffers
+  fftwf_complex *scratch_in = fftwf_alloc_complex(sz * how_many);
+  fftwf_complex *scratch_out = inplace ? scratch_in : fftwf_alloc_complex(sz * how_many);
+  unsigned flags = FFTW_MEASURE | (aligned ? 0 : FFTW_UNALIGNED);
+
+  fftwf_plan plan = fftwf_plan_many_dft(dim, n, how_many, scratch_in, NULL, 1, dist, scratch_out, NULL, 1, dist, inv ? FFTW_BACKWARD : FFTW_FORWARD, flags);
+
+  if(!inplace)
+    fftwf_free(scratch_out);
+  fftwf_free(scratch_in);
+
+  if(plan == NULL)
+    return NULL;
+
+  // evict the oldest plan when the cache is full
+  unsigned slot;
+  if(num_plans < PLAN_CACHE_SIZE){
+    slot = num_plans++;
+  }
+  else{
+    slot = next_evict;
+    next_evict = (next_evict + 1) % PLAN_CACHE_SIZE;
+    fftwf_destroy_plan(plan_cache[slot].plan);
+  }
+
+  cpu_plan_t entry = {dim, N, how_many, inv, inplace, aligned, plan};
+  plan_cache[slot] = entry;
+  return plan;
+}
+
+/**
+ * \brief  compute how_many single precision complex FFTs of N^dim points on the CPU using FFTW. Plans are created once per configuration and cached.
+ * \param  dim  : number of dimensions, 1 to 3
+ * \param  N    : unsigned integer size of a dimension
+ * \param  inp  : float2 pointer to input data of size [how_many * N^dim]
+ * \param  out  : float2 pointer to output data of size [how_many * N^dim]
+ * \param  inv  : toggle to activate backward FFT
+ * \param  how_many : number of FFTs to compute
+ * \return fpga_t : time taken in milliseconds for the computation in cpu_t
+ */
+fpga_t fftcpuf_c2c(const unsigned dim, const unsigned N, const float2 *inp, float2 *out, const bool inv, const unsigned how_many){
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0};
+
+  if(inp == NULL || out == NULL || dim < 1 || dim > 3 || how_many == 0 || ( (N & (N-1)) !=0)){
+    return fft_time;
+  }
+
+  const bool inplace = ((const void*)inp == (void*)out);
+  const bool aligned = (fftwf_alignment_of((float*)inp) == 0) && (fftwf_alignment_of((float*)out) == 0);
+
+  fftwf_plan plan = get_plan(dim, N, how_many, inv, inplace, aligned);
+  if(plan == NULL){
+    fprintf(stderr, "Failed to create FFTW plan\n");
+    return fft_time;
+  }
+
+  // out-of-place complex plans preserve the input
+  double start = getTimeinMilliSec();
+  fftwf_execute_dft(plan, (fftwf_complex*)inp, (fftwf_complex*)out);
+  fft_time.cpu_t = getTimeinMilliSec() - start;
+
+  fft_time.valid = 1;
+  return fft_time;
+}
+
+/**
+ * \brief Destroy the cached FFTW plans
+ */
+void fftcpu_cleanup(){
+  for(unsigned i = 0; i < num_plans; i++)
+    fftwf_destroy_plan(plan_cache[i].plan);
+  num_plans = 0;
+  next_evict = 0;
+
+  if(threads_initialized){
+    fftwf_cleanup_threads();
+    threads_initialized = false;
+  }
+}
@@ -0,0 +1,15 @@
+// Author: Arjun Ramaswami
+
+#ifndef FFT_CPU_H
+#define FFT_CPU_H
+
+#include <stdbool.h>
+#include "fftfpga/fftfpga.h"
+
+// Compute how_many single precision complex FFTs of N^dim points on the host using FFTW
+fpga_t fftcpuf_c2c(const unsigned dim, const unsigned N, const float2 *inp, float2 *out, const bool inv, const unsigned how_many);
+
+// Destroy the cached FFTW plans
+void fftcpu_cleanup();
+
+#endif
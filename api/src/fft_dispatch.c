@@ -0,0 +1,291 @@
+// Author: Arjun Ramaswami
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <math.h>
+#include "CL/opencl.h"
+
+#include "fpga_state.h"
+#include "fftfpga/fftfpga.h"
+#include "fft_dispatch.h"
+#include "fft_cpu.h"
+#include "model.h"
+#include "opencl_utils.h"
+#include "misc.h"
+
+// Maximum number of (dimension, N, batch, direction) configurations remembered
+#define DISPATCH_CACHE_SIZE 64
+
+// Relative noise power above which the FPGA result is considered wrong
+#define DISPATCH_MAX_NOISE 1e-6
+
+typedef enum {
+  BACKEND_CPU,
+  BACKEND_FPGA
+} backend_t;
+
+typedef struct {
+  unsigned dim;
+  unsigned N;
+  unsigned how_many;
+  bool inv;
+  backend_t backend;
+  selection_t sel;      // variant and placement measured on the FPGA
+} dispatch_t;
+
+static dispatch_t dispatch_cache[DISPATCH_CACHE_SIZE];
+static unsigned num_dispatch = 0, next_evict = 0;
+
+/**
+ * \brief  compute the transform using the variant selected by the performance model
+ * \return fpga_t : accumulated time of the FPGA executions
+ */
+static fpga_t fpga_c2c(const selection_t sel, const unsigned dim, const unsigned N, const float2 *inp, float2 *out, const bool inv, const unsigned how_many){
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0};
+  const size_t sz = (size_t)pow(N, dim);
+
+  switch(sel.variant){
+    case VARIANT_1D:
+      fft_time = fftfpgaf_c2c_1d(N, inp, out, inv, how_many);
+      break;
+    case VARIANT_2D_BRAM:
+      fft_time = fftfpgaf_c2c_2d_bram(N, inp, out, inv, sel.interleaving, how_many);
+      break;
+    case VARIANT_3D_DDR_BATCH:
+      fft_time = fftfpgaf_c2c_3d_ddr_batch(N, inp, out, inv, sel.interleaving, how_many);
+      break;
+    case VARIANT_3D_DDR_SVM_BATCH:
+      fft_time = fftfpgaf_c2c_3d_ddr_svm_batch(N, inp, out, inv, how_many);
+      break;
+    case VARIANT_NONE:
+      break;
+    default: {
+      // remaining pipelines compute a single transform per call
+      for(size_t j = 0; j < how_many; j++){
+        fpga_t t;
+        if(sel.variant == VARIANT_2D_DDR)
+          t = fftfpgaf_c2c_2d_ddr(N, &inp[j * sz], &out[j * sz], inv);
+        else if(sel.variant == VARIANT_3D_BRAM)
+          t = fftfpgaf_c2c_3d_bram(N, &inp[j * sz], &out[j * sz], inv, sel.interleaving);
+        else if(sel.variant == VARIANT_3D_DDR_SVM)
+          t = fftfpgaf_c2c_3d_ddr_svm(N, &inp[j * sz], &out[j * sz], inv, sel.interleaving);
+        else
+          t = fftfpgaf_c2c_3d_ddr(N, &inp[j * sz], &out[j * sz], inv);
+
+        if(!t.valid)
+          return t;
+
+        fft_time.pcie_write_t += t.pcie_write_t;
+        fft_time.pcie_read_t += t.pcie_read_t;
+        fft_time.exec_t += t.exec_t;
+        fft_time.svm_copyin_t += t.svm_copyin_t;
+        fft_time.svm_copyout_t += t.svm_copyout_t;
+      }
+      fft_time.valid = 1;
+      break;
+    }
+  }
+
+  model_update(sel, N, how_many, fft_time);
+  return fft_time;
+}
+
+/**
+ * \brief  compare the FPGA result with the CPU result
+ * \return true if the relative noise power is within the bounds of single precision
+ */
+static bool results_match(const float2 *ref, const float2 *res, const size_t num_pts){
+  double mag_sum = 0.0, noise_sum = 0.0;
+  for(size_t i = 0; i < num_pts; i++){
+    double dx = ref[i].x - res[i].x;
+    double dy = ref[i].y - res[i].y;
+    mag_sum += (double)ref[i].x * ref[i].x + (double)ref[i].y * ref[i].y;
+    noise_sum += dx * dx + dy * dy;
+  }
+  return noise_sum <= DISPATCH_MAX_NOISE * mag_sum;
+}
+
+/**
+ * \brief  backend chosen for a configuration
+ * \return entry of the cache, NULL if the configuration has not been measured
+ */
+static const dispatch_t* lookup(const unsigned dim, const unsigned N, const unsigned how_many, const bool inv){
+  for(unsigned i = 0; i < num_dispatch; i++){
+    const dispatch_t *d = &dispatch_cache[i];
+    if(d->dim == dim && d->N == N && d->how_many == how_many && d->inv == inv)
+      return d;
+  }
+  return NULL;
+}
+
+/**
+ * \brief  remember the backend and variant chosen for a configuration, evicting the oldest entry when full
+ */
+static void remember(const unsigned dim, const unsigned N, const unsigned how_many, const bool inv, const backend_t backend, const selection_t sel){
+  unsigned slot;
+  if(num_dispatch < DISPATCH_CACHE_SIZE){
+    slot = num_dispatch++;
+  }
+  else{
+    slot = next_evict;
+    next_evict = (next_evict + 1) % DISPATCH_CACHE_SIZE;
+  }
+  dispatch_t entry = {dim, N, how_many, inv, backend, sel};
+  dispatch_cache[slot] = entry;
+}
+
+/**
+ * \brief  compute a single precision complex FFT on the faster of the FPGA and the CPU, in place if inp and out are the same array. The forward and backward transforms are separate configurations. The first call of a configuration runs on both backends with copies of the input, verifies the FPGA result against the CPU and measures the end-to-end time of each; the faster backend is used for later calls.
+ * \param  dim  : number of dimensions, 1 to 3
+ * \param  N    : unsigned integer size of a dimension
+ * \param  inp  : float2 pointer to input data of size [how_many * N^dim]
+ * \param  out  : float2 pointer to output data of size [how_many * N^dim], can be the same as inp
+ * \param  inv  : toggle to activate backward FFT
+ * \param  how_many : number of FFTs to compute
+ * \return fpga_t : time taken in milliseconds, cpu_t is set if the CPU computed the transform. If the copies of the first call cannot be allocated, the CPU computes the transform and the configuration is measured again by the next call.
+ */
+fpga_t fftfpgaf_c2c(const unsigned dim, const unsigned N, const float2 *inp, float2 *out, const bool inv, const unsigned how_many){
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0};
+
+  if(inp == NULL || out == NULL || dim < 1 || dim > 3 || how_many == 0 || N < 8 || ( (N & (N-1)) !=0)){
+    return fft_time;
+  }
+
+  // backend forced by the environment
+  const char *env = getenv("FFTFPGA_BACKEND");
+  const bool force_fpga = (env != NULL && strcmp(env, "fpga") == 0);
+  if(env != NULL && strcmp(env, "cpu") == 0)
+    return fftcpuf_c2c(dim, N, inp, out, inv, how_many);
+
+  // backend and variant measured by an earlier call or imported from wisdom
+  const dispatch_t *d = lookup(dim, N, how_many, inv);
+  if(d != NULL && !force_fpga){
+    if(d->backend == BACKEND_FPGA && program != NULL && d->sel.variant != VARIANT_NONE)
+      return fpga_c2c(d->sel, dim, N, inp, out, inv, how_many);
+    else
+      return fftcpuf_c2c(dim, N, inp, out, inv, how_many);
+  }
+
+  // fastest variant of the loaded bitstream, the first selection calibrates the model
+  const selection_t sel = model_select(dim, N, how_many);
+  const bool fpga_supports = (program != NULL) && (sel.variant != VARIANT_NONE);
+  if(force_fpga && fpga_supports)
+    return fpga_c2c(sel, dim, N, inp, out, inv, how_many);
+  if(d != NULL)
+    return fftcpuf_c2c(dim, N, inp, out, inv, how_many);
+
+  // the measurements transform copies of the input, so that an in-place call writes its output once
+  const size_t num_pts = (size_t)pow(N, dim) * how_many;
+  float2 *scratch = (float2*)alignedMalloc(sizeof(float2) * num_pts);
+  float2 *ref = (float2*)alignedMalloc(sizeof(float2) * num_pts);
+  if(scratch == NULL || ref == NULL){
+    free(scratch);
+    free(ref);
+    return fftcpuf_c2c(dim, N, inp, out, inv, how_many);
+  }
+  memcpy(scratch, inp, sizeof(float2) * num_pts);
+
+  // CPU result: first call plans, second call is timed. The out-of-place plans preserve the input
+  fft_time = fftcpuf_c2c(dim, N, scratch, ref, inv, how_many);
+  if(!fft_time.valid){
+    free(scratch);
+    free(ref);
+    return fft_time;
+  }
+  double start = getTimeinMilliSec();
+  fft_time = fftcpuf_c2c(dim, N, scratch, ref, inv, how_many);
+  const double cpu_total = getTimeinMilliSec() - start;
+
+  if(!fpga_supports){
+    remember(dim, N, how_many, inv, BACKEND_CPU, sel);
+    memcpy(out, ref, sizeof(float2) * num_pts);
+    free(scratch);
+    free(ref);
+    return fft_time;
+  }
+
+  // FPGA result: first call reconfigures the device and is verified, second call is timed
+  float2 *tmp = (float2*)alignedMalloc(sizeof(float2) * num_pts);
+  if(tmp == NULL){
+    memcpy(out, ref, sizeof(float2) * num_pts);
+    free(scratch);
+    free(ref);
+    return fft_time;
+  }
+  fpga_t fpga_time = fpga_c2c(sel, dim, N, scratch, tmp, inv, how_many);
+  if(!fpga_time.valid || !results_match(ref, tmp, num_pts)){
+    fprintf(stderr, "-- FPGA result of %u^%u points incorrect, using the CPU\n", N, dim);
+    remember(dim, N, how_many, inv, BACKEND_CPU, sel);
+    memcpy(out, ref, sizeof(float2) * num_pts);
+    free(scratch);
+    free(ref);
+    free(tmp);
+    return fft_time;
+  }
+
+  start = getTimeinMilliSec();
+  fpga_c2c(sel, dim, N, scratch, tmp, inv, how_many);
+  const double fpga_total = getTimeinMilliSec() - start;
+
+  // output of the CPU transform of the original input
+  memcpy(out, ref, sizeof(float2) * num_pts);
+  free(scratch);
+  free(ref);
+  free(tmp);
+
+#ifdef DEBUG
+  printf("-- Dispatch %u^%u x %u : CPU %.4lfms FPGA (%s) %.4lfms predicted %.4lfms\n", N, dim, how_many, cpu_total, model_variant_name(sel.variant), fpga_total, sel.predicted_t);
+#endif
+
+  remember(dim, N, how_many, inv, fpga_total < cpu_total ? BACKEND_FPGA : BACKEND_CPU, sel);
+  return fft_time;
+}
+
+/**
+ * \brief  write the backend, variant and placement chosen for every configuration as wisdom
+ * \param  fp : file opened for writing
+ */
+void dispatch_export(FILE *fp){
+  for(unsigned i = 0; i < num_dispatch; i++){
+    const dispatch_t *d = &dispatch_cache[i];
+    fprintf(fp, "crossover %u %u %u %s %s %s %s\n", d->dim, d->N, d->how_many, d->inv ? "backward" : "forward", d->backend == BACKEND_FPGA ? "fpga" : "cpu", model_variant_name(d->sel.variant), d->sel.interleaving ? "interleaved" : "banked");
+  }
+}
+
+/**
+ * \brief  apply a line of wisdom to the backends chosen
+ * \param  key   : name of the value
+ * \param  value : dimension, N, number of transforms, direction, backend, variant and placement
+ * \return true if the key belongs to the dispatcher and was parsed
+ */
+bool dispatch_import(const char *key, const char *value){
+  unsigned dim, N, how_many;
+  char direction[16], backend[8], variant[32], placement[16];
+
+  if(strcmp(key, "crossover") != 0)
+    return false;
+  if(sscanf(value, "%u %u %u %15s %7s %31s %15s", &dim, &N, &how_many, direction, backend, variant, placement) != 7)
+    return false;
+  if(strcmp(direction, "forward") != 0 && strcmp(direction, "backward") != 0)
+    return false;
+
+  // a variant missing from the bitstream leaves the configuration to be measured again
+  const selection_t sel = {model_variant_lookup(variant), strcmp(placement, "interleaved") == 0, 0.0};
+  const backend_t chosen = strcmp(backend, "fpga") == 0 ? BACKEND_FPGA : BACKEND_CPU;
+  if(chosen == BACKEND_FPGA && sel.variant == VARIANT_NONE)
+    return false;
+
+  remember(dim, N, how_many, strcmp(direction, "backward") == 0, chosen, sel);
+  return true;
+}
+
+/**
+ * \brief Forget the backends chosen for the bitstream released
+ */
+void dispatch_cleanup(){
+  num_dispatch = 0;
+  next_evict = 0;
+}
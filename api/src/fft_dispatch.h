@@ -0,0 +1,18 @@
+// Author: Arjun Ramaswami
+
+#ifndef FFT_DISPATCH_H
+#define FFT_DISPATCH_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+// Write the backends chosen as wisdom
+void dispatch_export(FILE *fp);
+
+// Apply a line of wisdom, false if the key is unknown or the value malformed
+bool dispatch_import(const char *key, const char *value);
+
+// Forget the backends chosen for each configuration
+void dispatch_cleanup();
+
+#endif
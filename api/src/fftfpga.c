@@ -14,6 +14,12 @@
 #include "svm.h"
 #include "opencl_utils.h"
 #include "misc.h"
+#include "fft_cpu.h"
+#include "fft_dispatch.h"
+#include "fft3d_conv.h"
+#include "fft_buffer.h"
+#include "model.h"
+#include "wisdom.h"
 
 cl_platform_id platform = NULL;
 cl_device_id *devices;
@@ -126,6 +132,14 @@ int fpga_initialize(const char *platform_name, const char *path, const bool use_
   status = clBuildProgram(program, 0, NULL, "", NULL, NULL);
   checkError(status, "Failed to build program");
 
+  // load the calibration from wisdom if available for this bitstream,
+  // otherwise the model is calibrated by the first transform dispatched
+  model_detect();
+  wisdom_init(path);
+  const char *wisdom = getenv("FFTFPGA_WISDOM");
+  if(wisdom != NULL && fftfpga_import_wisdom(wisdom) == 0)
+    printf("-- Imported wisdom from %s\n", wisdom);
+
   return 0;
 }
 
@@ -134,11 +148,27 @@ int fpga_initialize(const char *platform_name, const char *path, const bool use_
  */
 void fpga_final(){
   printf("-- Cleaning up FPGA resources ...\n");
+
+  // store the calibration and crossovers measured for later runs
+  const char *wisdom = getenv("FFTFPGA_WISDOM");
+  if(wisdom != NULL && fftfpga_export_wisdom(wisdom) == 0)
+    printf("-- Exported wisdom to %s\n", wisdom);
+
+  conv_cleanup();
+  buffer_cleanup();
+  dispatch_cleanup();
+  model_cleanup();
+  wisdom_cleanup();
+  fftcpu_cleanup();
   if(program) 
     clReleaseProgram(program);
   if(context)
     clReleaseContext(context);
   free(devices);
+
+  program = NULL;
+  context = NULL;
+  devices = NULL;
 }
 
 /**
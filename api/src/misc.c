@@ -20,4 +20,20 @@ double getTimeinMilliSec(){
      exit(EXIT_FAILURE);
    }
    return (double)(a.tv_nsec) * 1.0e-6 + (double)(a.tv_sec) * 1.0E3;
-}
\ No newline at end of file
+}
+
+/**
+ * \brief  bit reverse the lowest bits of an integer
+ * \param  x    : integer to reverse
+ * \param  bits : number of lowest bits reversed
+ * \return the bit reversed integer
+ */
+unsigned bit_reversed(unsigned x, const unsigned bits){
+  unsigned y = 0;
+  for(unsigned i = 0; i < bits; i++){
+    y <<= 1;
+    y |= x & 1;
+    x >>= 1;
+  }
+  return y;
+}
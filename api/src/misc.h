@@ -5,4 +5,6 @@
 
 double getTimeinMilliSec();
 
+unsigned bit_reversed(unsigned x, const unsigned bits);
+
 #endif 
\ No newline at end of file
@@ -0,0 +1,469 @@
+// Author: Arjun Ramaswami
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <math.h>
+#define CL_VERSION_2_0
+#include <CL/cl_ext_intelfpga.h> // to disable interleaving & transfer data to specific banks - CL_CHANNEL_1_INTELFPGA
+#include "CL/opencl.h"
+
+#include "fpga_state.h"
+#include "fftfpga/fftfpga.h"
+#include "model.h"
+#include "fft3d_pipeline.h"
+#include "opencl_utils.h"
+#include "misc.h"
+
+// Global memory placements calibrated: interleaved and the first four banks
+#define NUM_BANKS 5
+#define BANK_INTERLEAVED 0
+
+// Sizes of the transfers used to measure bandwidth and latency
+#define CALIB_BYTES (8 * 1024 * 1024)
+#define CALIB_SMALL_BYTES 64
+
+// Weight of a new measurement in the kernel throughput
+#define UPDATE_WEIGHT 0.5
+
+/**
+ * Static properties of a kernel pipeline
+ */
+typedef struct {
+  const char *name;
+  unsigned dim;
+  double passes;        // times the data streams through the pipeline per transform
+  unsigned num_kernels; // kernels created per call
+  bool batched;         // computes all the transforms in a single call
+  bool overlapped;      // overlaps transfers of a transform with the computation of another
+  bool pieces;          // overlaps them per piece of ddr_batch_piece transforms, one transform on replicated pipelines
+  bool svm;             // accesses host memory directly
+  bool interleaving;    // accepts interleaved buffers
+  unsigned bank_in;     // bank of the input buffer if not interleaved
+  unsigned bank_out;    // bank of the output buffer if not interleaved
+} variant_info_t;
+
+static const variant_info_t variants[NUM_VARIANTS] = {
+  [VARIANT_1D]               = {"fft1d",               1, 1.0, 2, true,  false, false, false, false, BANK_INTERLEAVED, 2},
+  [VARIANT_2D_BRAM]          = {"fft2d_bram",          2, 1.0, 5, true,  false, false, false, true,  1, 2},
+  [VARIANT_2D_DDR]           = {"fft2d_ddr",           2, 2.0, 3, false, false, false, false, false, BANK_INTERLEAVED, BANK_INTERLEAVED},
+  [VARIANT_3D_BRAM]          = {"fft3d_bram",          3, 1.0, 7, false, false, false, false, true,  1, 2},
+  [VARIANT_3D_DDR]           = {"fft3d_ddr",           3, 2.0, 7, false, false, false, false, false, 1, 1},
+  [VARIANT_3D_DDR_BATCH]     = {"fft3d_ddr_batch",     3, 2.0, 7, true,  true,  true,  false, false, 1, 2},
+  [VARIANT_3D_DDR_SVM]       = {"fft3d_ddr_svm",       3, 2.0, 8, false, false, false, true,  false, BANK_INTERLEAVED, BANK_INTERLEAVED},
+  [VARIANT_3D_DDR_SVM_BATCH] = {"fft3d_ddr_svm_batch", 3, 2.0, 8, true,  false, false, true,  false, BANK_INTERLEAVED, BANK_INTERLEAVED}
+};
+
+/**
+ * Calibrated state of the performance model
+ */
+typedef struct {
+  bool available[NUM_VARIANTS];
+  double points_per_ms[NUM_VARIANTS]; // kernel throughput
+  double write_bw[NUM_BANKS];         // bytes per ms, 0 if the bank is not available
+  double read_bw[NUM_BANKS];
+  double write_lat[NUM_BANKS];        // ms per transfer
+  double read_lat[NUM_BANKS];
+  double memcpy_bw;                   // bytes per ms of host memory copies
+  double setup_t;                     // ms to setup and release the command queues
+  double kernel_t;                    // ms to create a kernel
+  bool calibrated;                    // measured or imported from wisdom
+  bool replicated;                    // the 3D DDR variants run on the replicated pipelines of fft3d_ddr_multi
+} model_t;
+
+static model_t model;
+
+static const cl_mem_flags bank_flags[NUM_BANKS] = {
+  0, CL_CHANNEL_1_INTELFPGA, CL_CHANNEL_2_INTELFPGA, CL_CHANNEL_3_INTELFPGA, CL_CHANNEL_4_INTELFPGA
+};
+
+/**
+ * \brief  time a blocking transfer between host and device using the profiling information of the event
+ * \return time in milliseconds, negative if the transfer failed
+ */
+static double time_transfer(cl_command_queue queue, cl_mem buf, const bool write, void *host, const size_t bytes){
+  cl_event event;
+  cl_int status;
+
+  if(write)
+    status = clEnqueueWriteBuffer(queue, buf, CL_TRUE, 0, bytes, host, 0, NULL, &event);
+  else
+    status = clEnqueueReadBuffer(queue, buf, CL_TRUE, 0, bytes, host, 0, NULL, &event);
+  if(status != CL_SUCCESS)
+    return -1.0;
+
+  cl_ulong start = 0, end = 0;
+  clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start, NULL);
+  clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, NULL);
+  clReleaseEvent(event);
+
+  return (cl_double)(end - start) * (cl_double)(1e-06);
+}
+
+/**
+ * \brief  measure bandwidth and latency of PCIe transfers to and from a global memory bank. Banks that cannot be allocated are marked unavailable.
+ */
+static void calibrate_bank(cl_command_queue queue, const unsigned bank, void *host){
+  cl_int status = 0;
+
+  cl_mem buf = clCreateBuffer(context, CL_MEM_READ_WRITE | bank_flags[bank], CALIB_BYTES, NULL, &status);
+  if(status != CL_SUCCESS)
+    return;
+
+  // first transfer allocates the buffer on the device
+  double large_wr = time_transfer(queue, buf, true, host, CALIB_BYTES);
+  large_wr = time_transfer(queue, buf, true, host, CALIB_BYTES);
+  double small_wr = time_transfer(queue, buf, true, host, CALIB_SMALL_BYTES);
+  double large_rd = time_transfer(queue, buf, false, host, CALIB_BYTES);
+  double small_rd = time_transfer(queue, buf, false, host, CALIB_SMALL_BYTES);
+
+  if(large_wr > small_wr && small_wr >= 0.0 && large_rd > small_rd && small_rd >= 0.0){
+    model.write_bw[bank] = (CALIB_BYTES - CALIB_SMALL_BYTES) / (large_wr - small_wr);
+    model.read_bw[bank] = (CALIB_BYTES - CALIB_SMALL_BYTES) / (large_rd - small_rd);
+    model.write_lat[bank] = small_wr;
+    model.read_lat[bank] = small_rd;
+  }
+
+  clReleaseMemObject(buf);
+}
+
+/**
+ * \brief  number of arguments of a kernel of the program
+ * \param  name : name of the kernel
+ * \return number of arguments, 0 if the program has no such kernel
+ */
+static cl_uint kernel_num_args(const char *name){
+  cl_int status = 0;
+  cl_uint num_args = 0;
+
+  if(!kernelExists(program, name))
+    return 0;
+
+  cl_kernel kernel = clCreateKernel(program, name, &status);
+  if(status != CL_SUCCESS)
+    return 0;
+  status = clGetKernelInfo(kernel, CL_KERNEL_NUM_ARGS, sizeof(cl_uint), &num_args, NULL);
+  clReleaseKernel(kernel);
+
+  return (status == CL_SUCCESS) ? num_args : 0;
+}
+
+/**
+ * \brief  detect the kernel pipelines available in the program. Variants sharing kernel names are told apart by their arguments: the transpose3D kernel of fft3d_ddr_batch takes the two transpose buffers and the size of the batch, that of fft3d_bram none. The replicated pipelines of fft3d_ddr_multi, whose kernels are suffixed by their index, compute single transforms with the first pipeline and batches with all of them.
+ */
+static void detect_variants(){
+  const bool replicated = (ddr_pipeline_replicas() > 0);
+  model.replicated = replicated;
+
+  model.available[VARIANT_1D] = kernelExists(program, "fft1d");
+  model.available[VARIANT_2D_BRAM] = kernelExists(program, "fft2da");
+  model.available[VARIANT_2D_DDR] = kernelExists(program, "fft2d");
+  model.available[VARIANT_3D_BRAM] = kernelExists(program, "transpose2d");
+  model.available[VARIANT_3D_DDR] = kernelExists(program, "transpose3D_wr") || kernelExists(program, "transpose3D_hybrid") || replicated;
+  model.available[VARIANT_3D_DDR_BATCH] = (kernel_num_args("transpose3D") == 3) || replicated;
+  model.available[VARIANT_3D_DDR_SVM] = svm_enabled && kernelExists(program, "fetchBitrev1");
+  model.available[VARIANT_3D_DDR_SVM_BATCH] = model.available[VARIANT_3D_DDR_SVM];
+}
+
+/**
+ * \brief  reset the performance model and detect the variants in the loaded program
+ */
+void model_detect(){
+  memset(&model, 0, sizeof(model_t));
+  for(unsigned i = 0; i < NUM_VARIANTS; i++)
+    model.points_per_ms[i] = DEFAULT_POINTS_PER_MS;
+
+  detect_variants();
+}
+
+/**
+ * \brief  calibrate the performance model with microbenchmarks of PCIe transfers per bank, host memory copies and the setup of command queues and kernels
+ */
+void model_calibrate(){
+  cl_int status = 0;
+
+  cl_command_queue queue = clCreateCommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE, &status);
+  if(status != CL_SUCCESS)
+    return;
+
+  char *host = (char *)alignedMalloc(CALIB_BYTES);
+  char *host_copy = (char *)alignedMalloc(CALIB_BYTES);
+  memset(host, 0, CALIB_BYTES);
+
+  for(unsigned bank = 0; bank < NUM_BANKS; bank++)
+    calibrate_bank(queue, bank, host);
+
+  clReleaseCommandQueue(queue);
+
+  // host memory copies into and out of SVM buffers
+  memcpy(host_copy, host, CALIB_BYTES);
+  double start = getTimeinMilliSec();
+  memcpy(host_copy, host, CALIB_BYTES);
+  double copy_t = getTimeinMilliSec() - start;
+  model.memcpy_bw = copy_t > 0.0 ? CALIB_BYTES / copy_t : 0.0;
+
+  free(host);
+  free(host_copy);
+
+  // fixed costs of every call
+  start = getTimeinMilliSec();
+  queue_setup();
+  queue_cleanup();
+  model.setup_t = getTimeinMilliSec() - start;
+
+  const char *probe = model.available[VARIANT_1D] ? "fft1d" :
+                      model.available[VARIANT_2D_DDR] ? "fft2d" :
+                      (model.available[VARIANT_2D_BRAM] ? "fft2da" : "fft3da");
+  start = getTimeinMilliSec();
+  cl_kernel kernel = clCreateKernel(program, probe, &status);
+  if(status == CL_SUCCESS){
+    clReleaseKernel(kernel);
+    model.kernel_t = getTimeinMilliSec() - start;
+  }
+
+  model.calibrated = true;
+
+#ifdef DEBUG
+  for(unsigned bank = 0; bank < NUM_BANKS; bank++)
+    printf("-- Bank %u: write %.2lf GB/s read %.2lf GB/s\n", bank, model.write_bw[bank] * 1e-6, model.read_bw[bank] * 1e-6);
+#endif
+}
+
+/**
+ * \brief  predicted time of a PCIe transfer, infinite if the bank is not available
+ */
+static double transfer_t(const bool write, const unsigned bank, const double bytes){
+  const double bw = write ? model.write_bw[bank] : model.read_bw[bank];
+  const double lat = write ? model.write_lat[bank] : model.read_lat[bank];
+  return bw > 0.0 ? lat + bytes / bw : INFINITY;
+}
+
+/**
+ * \brief  predicted end-to-end time in milliseconds of the transforms using a variant
+ */
+static double predict(const variant_t v, const bool interleaving, const unsigned N, const unsigned how_many){
+  const variant_info_t *info = &variants[v];
+  const double points = pow(N, info->dim);
+  const double bytes = points * sizeof(float2);
+  const unsigned bank_in = interleaving ? BANK_INTERLEAVED : info->bank_in;
+  const unsigned bank_out = interleaving ? BANK_INTERLEAVED : info->bank_out;
+
+  const double overhead = model.setup_t + info->num_kernels * model.kernel_t;
+  const double exec = info->passes * points / model.points_per_ms[v];
+
+  if(info->svm){
+    // data is copied into SVM buffers, kernels access the host memory
+    const double copy = model.memcpy_bw > 0.0 ? 2.0 * bytes / model.memcpy_bw : 0.0;
+    if(info->batched)
+      return overhead + how_many * (copy + exec);
+    return how_many * (overhead + copy + exec);
+  }
+
+  if(info->overlapped){
+    // transfers of a piece overlap the computation of the previous and next pieces
+    const unsigned piece = (info->pieces && !model.replicated) ? ddr_batch_piece(N, how_many) : 1;
+    if(piece == 0)
+      return INFINITY;
+    const unsigned num_pieces = (how_many + piece - 1) / piece;
+    const double wr = transfer_t(true, bank_in, piece * bytes);
+    const double rd = transfer_t(false, bank_out, piece * bytes);
+    const double exec_piece = piece * exec;
+    return overhead + wr + exec_piece + rd + (num_pieces - 1) * fmax(exec_piece, fmax(wr, rd));
+  }
+
+  if(info->batched)
+    return overhead + transfer_t(true, bank_in, how_many * bytes) + how_many * exec + transfer_t(false, bank_out, how_many * bytes);
+
+  return how_many * (overhead + transfer_t(true, bank_in, bytes) + exec + transfer_t(false, bank_out, bytes));
+}
+
+/**
+ * \brief  select the variant with the lowest predicted end-to-end time among those in the loaded bitstream, calibrating the model first if it has not been calibrated or imported from wisdom
+ * \param  dim  : number of dimensions
+ * \param  N    : size of a dimension
+ * \param  how_many : number of transforms
+ * \return selection with variant VARIANT_NONE if no variant computes the transform
+ */
+selection_t model_select(const unsigned dim, const unsigned N, const unsigned how_many){
+  selection_t best = {VARIANT_NONE, false, INFINITY};
+
+  // calibrate on the first selection so that initialization stays cheap
+  if(!model.calibrated && program != NULL){
+    printf("-- Calibrating performance model\n");
+    model_calibrate();
+  }
+
+  for(unsigned v = 0; v < NUM_VARIANTS; v++){
+    if(!model.available[v] || variants[v].dim != dim)
+      continue;
+    // the batched DDR pipeline needs at least two transforms to overlap
+    if(v == VARIANT_3D_DDR_BATCH && how_many < 2)
+      continue;
+
+    for(unsigned inter = 0; inter < (variants[v].interleaving ? 2 : 1); inter++){
+      const double t = predict((variant_t)v, inter == 1, N, how_many);
+      if(t < best.predicted_t || best.variant == VARIANT_NONE){
+        best.variant = (variant_t)v;
+        best.interleaving = (inter == 1);
+        best.predicted_t = t;
+      }
+    }
+  }
+  return best;
+}
+
+/**
+ * \brief  refine the kernel throughput of the variant using the measured execution time
+ * \param  sel  : variant executed
+ * \param  N    : size of a dimension
+ * \param  how_many : number of transforms
+ * \param  measured : timing returned by the execution
+ */
+void model_update(const selection_t sel, const unsigned N, const unsigned how_many, const fpga_t measured){
+  if(sel.variant == VARIANT_NONE || !measured.valid || measured.exec_t <= 0.0)
+    return;
+
+  // execution time is accumulated over all the transforms, the batched DDR
+  // pipelines report the time of their kernels without the transfers
+  const variant_info_t *info = &variants[sel.variant];
+  const double exec = measured.exec_t / how_many;
+  const double points_per_ms = info->passes * pow(N, info->dim) / exec;
+  double *ppm = &model.points_per_ms[sel.variant];
+  *ppm = (1.0 - UPDATE_WEIGHT) * (*ppm) + UPDATE_WEIGHT * points_per_ms;
+}
+
+/**
+ * \brief  name of the bitstream variant
+ */
+const char* model_variant_name(const variant_t variant){
+  if(variant >= NUM_VARIANTS)
+    return "none";
+  return variants[variant].name;
+}
+
+/**
+ * \brief  variant of a name written by model_variant_name
+ * \return variant, VARIANT_NONE if the name is unknown or the variant is not in the loaded bitstream
+ */
+variant_t model_variant_lookup(const char *name){
+  for(unsigned v = 0; v < NUM_VARIANTS; v++){
+    if(strcmp(name, variants[v].name) == 0)
+      return model.available[v] ? (variant_t)v : VARIANT_NONE;
+  }
+  return VARIANT_NONE;
+}
+
+/**
+ * \brief  print a space separated list of values
+ */
+static void write_values(FILE *fp, const char *key, const double *values, const unsigned num){
+  fprintf(fp, "%s", key);
+  for(unsigned i = 0; i < num; i++)
+    fprintf(fp, " %.17g", values[i]);
+  fprintf(fp, "\n");
+}
+
+/**
+ * \brief  parse a space separated list of exactly num values
+ * \return true if successful
+ */
+static bool read_values(const char *str, double *values, const unsigned num){
+  double tmp[NUM_BANKS > NUM_VARIANTS ? NUM_BANKS : NUM_VARIANTS];
+  char *end;
+  for(unsigned i = 0; i < num; i++){
+    tmp[i] = strtod(str, &end);
+    if(end == str)
+      return false;
+    str = end;
+  }
+  memcpy(values, tmp, sizeof(double) * num);
+  return true;
+}
+
+/**
+ * \brief  write the calibration and the kernel throughput of the variants as wisdom
+ * \param  fp : file opened for writing
+ * \return true if the model has been calibrated and was written
+ */
+bool model_export(FILE *fp){
+  if(!model.calibrated || fp == NULL)
+    return false;
+
+  write_values(fp, "write_bw", model.write_bw, NUM_BANKS);
+  write_values(fp, "read_bw", model.read_bw, NUM_BANKS);
+  write_values(fp, "write_lat", model.write_lat, NUM_BANKS);
+  write_values(fp, "read_lat", model.read_lat, NUM_BANKS);
+  write_values(fp, "memcpy_bw", &model.memcpy_bw, 1);
+  write_values(fp, "setup_t", &model.setup_t, 1);
+  write_values(fp, "kernel_t", &model.kernel_t, 1);
+  write_values(fp, "points_per_ms", model.points_per_ms, NUM_VARIANTS);
+  return true;
+}
+
+/**
+ * \brief  apply a line of wisdom to the model
+ * \param  key   : name of the value
+ * \param  value : space separated values
+ * \return true if the key belongs to the model and was parsed
+ */
+bool model_import(const char *key, const char *value){
+  bool ok = false;
+
+  if(strcmp(key, "write_bw") == 0)
+    ok = read_values(value, model.write_bw, NUM_BANKS);
+  else if(strcmp(key, "read_bw") == 0)
+    ok = read_values(value, model.read_bw, NUM_BANKS);
+  else if(strcmp(key, "write_lat") == 0)
+    ok = read_values(value, model.write_lat, NUM_BANKS);
+  else if(strcmp(key, "read_lat") == 0)
+    ok = read_values(value, model.read_lat, NUM_BANKS);
+  else if(strcmp(key, "memcpy_bw") == 0)
+    ok = read_values(value, &model.memcpy_bw, 1);
+  else if(strcmp(key, "setup_t") == 0)
+    ok = read_values(value, &model.setup_t, 1);
+  else if(strcmp(key, "kernel_t") == 0)
+    ok = read_values(value, &model.kernel_t, 1);
+  else if(strcmp(key, "points_per_ms") == 0)
+    ok = read_values(value, model.points_per_ms, NUM_VARIANTS);
+
+  if(ok)
+    model.calibrated = true;
+  return ok;
+}
+
+/**
+ * \brief  check if the model has been calibrated or imported from wisdom
+ */
+bool model_is_calibrated(){
+  return model.calibrated;
+}
+
+/**
+ * \brief Forget the variants and calibration of the released bitstream
+ */
+void model_cleanup(){
+  memset(&model, 0, sizeof(model_t));
+}
+
+/**
+ * \brief  predict the end-to-end time of a transform on the FPGA using the performance model, calibrated by the first prediction
+ * \param  dim  : number of dimensions, 1 to 3
+ * \param  N    : unsigned integer size of a dimension
+ * \param  how_many : number of FFTs to compute
+ * \return predicted time in milliseconds of the fastest variant in the loaded bitstream, negative if none computes the transform
+ */
+double fftfpgaf_predict(const unsigned dim, const unsigned N, const unsigned how_many){
+  if(dim < 1 || dim > 3 || how_many == 0 || N < 8 || ( (N & (N-1)) !=0))
+    return -1.0;
+
+  selection_t sel = model_select(dim, N, how_many);
+  if(sel.variant == VARIANT_NONE || isinf(sel.predicted_t))
+    return -1.0;
+
+#ifdef DEBUG
+  printf("-- Predicted %s: %.4lfms\n", model_variant_name(sel.variant), sel.predicted_t);
+#endif
+  return sel.predicted_t;
+}
@@ -0,0 +1,66 @@
+// Author: Arjun Ramaswami
+
+#ifndef MODEL_H
+#define MODEL_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "fftfpga/fftfpga.h"
+
+// Kernel throughput in points per millisecond assumed for a variant until it
+// has been measured. A guess of 8 points per cycle at 300 MHz: the kernel fmax
+// of the bitstream is not queried, the measurements of model_update replace it
+#define DEFAULT_POINTS_PER_MS (8 * 300e3)
+
+// Kernel pipelines that can be found in a bitstream
+typedef enum {
+  VARIANT_1D,
+  VARIANT_2D_BRAM,
+  VARIANT_2D_DDR,
+  VARIANT_3D_BRAM,
+  VARIANT_3D_DDR,
+  VARIANT_3D_DDR_BATCH,
+  VARIANT_3D_DDR_SVM,
+  VARIANT_3D_DDR_SVM_BATCH,
+  NUM_VARIANTS,
+  VARIANT_NONE = NUM_VARIANTS
+} variant_t;
+
+// Variant and memory placement chosen for a transform
+typedef struct {
+  variant_t variant;
+  bool interleaving;
+  double predicted_t;
+} selection_t;
+
+// Reset the model and detect the variants available in the program
+void model_detect();
+
+// Measure the PCIe bandwidth and the fixed costs of a call, done by the first model_select
+void model_calibrate();
+
+// Check if the model has been calibrated or imported from wisdom
+bool model_is_calibrated();
+
+// Write the calibration as wisdom, false if not calibrated
+bool model_export(FILE *fp);
+
+// Apply a line of wisdom, false if the key is unknown or the value malformed
+bool model_import(const char *key, const char *value);
+
+// Fastest variant for the transform, VARIANT_NONE if the bitstream cannot compute it. Calibrates the model if needed
+selection_t model_select(const unsigned dim, const unsigned N, const unsigned how_many);
+
+// Refine the kernel throughput of a variant with a measured execution
+void model_update(const selection_t sel, const unsigned N, const unsigned how_many, const fpga_t measured);
+
+// Name of the variant
+const char* model_variant_name(const variant_t variant);
+
+// Variant of a name, VARIANT_NONE if unknown or not in the loaded bitstream
+variant_t model_variant_lookup(const char *name);
+
+// Forget the variants and calibration of the released bitstream
+void model_cleanup();
+
+#endif
@@ -170,6 +170,39 @@ cl_program getProgramWithBinary(cl_context context, cl_device_id *devices, cl_ui
   return program;
 }
 
+/**
+ * \brief  checks if the program contains a kernel with the given name
+ * \param  program: program created from the binary
+ * \param  kernel_name: name of the kernel to search for
+ * \retval true if found and false otherwise
+ */
+bool kernelExists(cl_program program, const char *kernel_name){
+  size_t names_sz = 0;
+  bool found = false;
+
+  if(program == NULL || kernel_name == NULL)
+    return false;
+
+  // Kernel names are returned as a semicolon separated list
+  cl_int status = clGetProgramInfo(program, CL_PROGRAM_KERNEL_NAMES, 0, NULL, &names_sz);
+  if(status != CL_SUCCESS || names_sz == 0)
+    return false;
+
+  char *names = (char *)malloc(names_sz);
+  status = clGetProgramInfo(program, CL_PROGRAM_KERNEL_NAMES, names_sz, names, NULL);
+  if(status == CL_SUCCESS){
+    char *save = NULL;
+    for(char *tok = strtok_r(names, ";", &save); tok != NULL; tok = strtok_r(NULL, ";", &save)){
+      if(strcmp(tok, kernel_name) == 0){
+        found = true;
+        break;
+      }
+    }
+  }
+  free(names);
+  return found;
+}
+
 static size_t loadBinary(const char *binary_path, char **buf){
   FILE *fp;
 
@@ -3,6 +3,8 @@
 #ifndef OPENCL_UTILS_H
 #define OPENCL_UTILS_H
 
+#include <stdbool.h>
+
 extern void queue_cleanup();
 extern void fpga_final();
 
@@ -18,6 +20,9 @@ cl_device_id* getDevices(cl_platform_id pid, cl_device_type device_type, cl_uint
 // OpenCL program created for all the devices of the context with the same binary
 cl_program getProgramWithBinary(cl_context context, cl_device_id *devices, cl_uint num_devices, const char *data_path);
 
+// Check if a kernel of the given name is part of the program
+bool kernelExists(cl_program program, const char *kernel_name);
+
 void* alignedMalloc(size_t size);
 
 void _checkError(const char *file, int line, const char *func, cl_int err, const char *msg, ...);
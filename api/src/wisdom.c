@@ -0,0 +1,220 @@
+// Author: Arjun Ramaswami
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include "CL/opencl.h"
+
+#include "fpga_state.h"
+#include "fftfpga/fftfpga.h"
+#include "wisdom.h"
+#include "model.h"
+#include "fft_dispatch.h"
+
+#define WISDOM_HEADER "fftfpga-wisdom 1"
+#define WISDOM_LINE_SIZE 1024
+
+// Names of the lines of the key, in the order written
+#define NUM_KEYS 4
+static const char *key_names[NUM_KEYS] = {"device", "bsp", "driver", "bitstream"};
+
+// Path of the bitstream loaded, NULL if none
+static char *bitstream_path = NULL;
+
+// FNV-1a hash of the bitstream loaded, 0 until computed
+static uint64_t bitstream_hash = 0;
+
+/**
+ * \brief  remember the bitstream loaded, hashed only when wisdom is exported or imported
+ * \param  path : path to the bitstream loaded
+ */
+void wisdom_init(const char *path){
+  wisdom_cleanup();
+  if(path == NULL)
+    return;
+  bitstream_path = (char *)malloc(strlen(path) + 1);
+  if(bitstream_path != NULL)
+    strcpy(bitstream_path, path);
+}
+
+/**
+ * \brief  forget the bitstream released
+ */
+void wisdom_cleanup(){
+  free(bitstream_path);
+  bitstream_path = NULL;
+  bitstream_hash = 0;
+}
+
+/**
+ * \brief  hash the bitstream using 64-bit FNV-1a on first use
+ * \return hash, 0 if no bitstream is loaded or it cannot be read
+ */
+static uint64_t get_bitstream_hash(){
+  unsigned char buf[4096];
+  size_t len;
+
+  if(bitstream_hash != 0 || bitstream_path == NULL)
+    return bitstream_hash;
+
+  FILE *fp = fopen(bitstream_path, "rb");
+  if(fp == NULL)
+    return 0;
+
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  while((len = fread(buf, 1, sizeof(buf), fp)) > 0){
+    for(size_t i = 0; i < len; i++){
+      hash ^= buf[i];
+      hash *= 0x100000001b3ULL;
+    }
+  }
+  fclose(fp);
+  bitstream_hash = hash;
+  return bitstream_hash;
+}
+
+/**
+ * \brief  query a string property of the device, newlines are removed to keep one property per line
+ */
+static void device_string(const cl_device_info param, char *buf, const size_t sz){
+  buf[0] = '\0';
+  if(clGetDeviceInfo(device, param, sz, buf, NULL) != CL_SUCCESS)
+    buf[0] = '\0';
+  buf[sz - 1] = '\0';
+  buf[strcspn(buf, "\r\n")] = '\0';
+}
+
+/**
+ * \brief  write the key identifying the device, the board support package and the bitstream
+ */
+static void write_key(FILE *fp){
+  char str[256];
+
+  device_string(CL_DEVICE_NAME, str, sizeof(str));
+  fprintf(fp, "device %s\n", str);
+  device_string(CL_DEVICE_VERSION, str, sizeof(str));
+  fprintf(fp, "bsp %s\n", str);
+  device_string(CL_DRIVER_VERSION, str, sizeof(str));
+  fprintf(fp, "driver %s\n", str);
+  fprintf(fp, "bitstream %016" PRIx64 "\n", get_bitstream_hash());
+}
+
+/**
+ * \brief  index of a line of the key
+ * \return index in key_names, -1 if the name is not part of the key
+ */
+static int key_index(const char *key){
+  for(int i = 0; i < NUM_KEYS; i++){
+    if(strcmp(key, key_names[i]) == 0)
+      return i;
+  }
+  return -1;
+}
+
+/**
+ * \brief  check if a line of the key matches the current device and bitstream
+ * \param  index : index of the line in key_names
+ */
+static bool key_matches(const int index, const char *value){
+  char str[256];
+
+  switch(index){
+    case 0:
+      device_string(CL_DEVICE_NAME, str, sizeof(str));
+      break;
+    case 1:
+      device_string(CL_DEVICE_VERSION, str, sizeof(str));
+      break;
+    case 2:
+      device_string(CL_DRIVER_VERSION, str, sizeof(str));
+      break;
+    default:
+      snprintf(str, sizeof(str), "%016" PRIx64, get_bitstream_hash());
+      break;
+  }
+
+  return strcmp(str, value) == 0;
+}
+
+/**
+ * \brief  export the performance model calibration and the CPU/FPGA crossover as wisdom to a file
+ * \param  filename : path to the wisdom file, overwritten if it exists
+ * \return 0 if successful
+ *        -1 if no bitstream is loaded or calibrated, or the file cannot be written
+ */
+int fftfpga_export_wisdom(const char *filename){
+  if(filename == NULL || program == NULL || !model_is_calibrated() || get_bitstream_hash() == 0)
+    return -1;
+
+  FILE *fp = fopen(filename, "w");
+  if(fp == NULL)
+    return -1;
+
+  fprintf(fp, "%s\n", WISDOM_HEADER);
+  write_key(fp);
+  model_export(fp);
+  dispatch_export(fp);
+
+  return fclose(fp) == 0 ? 0 : -1;
+}
+
+/**
+ * \brief  import wisdom from a file exported for the same device, board support package and bitstream
+ * \param  filename : path to the wisdom file
+ * \return 0 if successful
+ *        -1 if no bitstream is loaded, or the file is missing or malformed, including a key with a line missing or repeated
+ *        -2 if the wisdom was exported for another device, board support package or bitstream
+ */
+int fftfpga_import_wisdom(const char *filename){
+  char line[WISDOM_LINE_SIZE];
+  bool key_seen[NUM_KEYS] = {false};
+  unsigned key_lines = 0;
+  bool applied = false;
+
+  if(filename == NULL || program == NULL || get_bitstream_hash() == 0)
+    return -1;
+
+  FILE *fp = fopen(filename, "r");
+  if(fp == NULL)
+    return -1;
+
+  if(fgets(line, sizeof(line), fp) == NULL || strncmp(line, WISDOM_HEADER, strlen(WISDOM_HEADER)) != 0){
+    fclose(fp);
+    return -1;
+  }
+
+  while(fgets(line, sizeof(line), fp) != NULL){
+    line[strcspn(line, "\r\n")] = '\0';
+
+    char *value = strchr(line, ' ');
+    if(value == NULL)
+      continue;
+    *value++ = '\0';
+
+    // the lines of the key precede the tuning data, each exactly once
+    if(key_lines < NUM_KEYS){
+      const int index = key_index(line);
+      if(index < 0 || key_seen[index]){
+        fclose(fp);
+        return -1;
+      }
+      if(!key_matches(index, value)){
+        fclose(fp);
+        return -2;
+      }
+      key_seen[index] = true;
+      key_lines++;
+      continue;
+    }
+
+    // unknown keys are skipped
+    if(model_import(line, value) || dispatch_import(line, value))
+      applied = true;
+  }
+  fclose(fp);
+
+  return (key_lines == NUM_KEYS && applied && model_is_calibrated()) ? 0 : -1;
+}
@@ -0,0 +1,12 @@
+// Author: Arjun Ramaswami
+
+#ifndef WISDOM_H
+#define WISDOM_H
+
+// Remember the bitstream loaded, whose hash keys the wisdom
+void wisdom_init(const char *path);
+
+// Forget the bitstream released
+void wisdom_cleanup();
+
+#endif
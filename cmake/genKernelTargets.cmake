@@ -33,7 +33,7 @@ function(gen_fft_targets)
     )
     
     add_custom_target(${kernel_fname}_emulate
-      DEPENDS ${EMU_BSTREAM} ${CL_SRC} ${CL_HEADER}
+      DEPENDS ${EMU_BSTREAM} ${CL_SRC} ${CL_HEADER} ${FFT_CALLBACKS_PATH}
       COMMENT 
         "Building ${kernel_fname} for emulation to folder ${CMAKE_RUNTIME_OUTPUT_DIRECTORY}"
     )
@@ -46,7 +46,7 @@ function(gen_fft_targets)
     )
     
     add_custom_target(${kernel_fname}_report
-      DEPENDS ${REP_BSTREAM} ${CL_SRC} ${CL_HEADER}
+      DEPENDS ${REP_BSTREAM} ${CL_SRC} ${CL_HEADER} ${FFT_CALLBACKS_PATH}
       COMMENT 
         "Building a report for ${kernel_fname} to folder ${CMAKE_RUNTIME_OUTPUT_DIRECTORY}"
     )
@@ -58,7 +58,7 @@ function(gen_fft_targets)
     )
     
     add_custom_target(${kernel_fname}_profile
-      DEPENDS ${PROF_BSTREAM} ${CL_SRC} ${CL_HEADER}
+      DEPENDS ${PROF_BSTREAM} ${CL_SRC} ${CL_HEADER} ${FFT_CALLBACKS_PATH}
       COMMENT 
         "Profiling for ${kernel_fname} using ${FPGA_BOARD_NAME} to folder ${CMAKE_RUNTIME_OUTPUT_DIRECTORY}"
     )
@@ -70,7 +70,7 @@ function(gen_fft_targets)
     )
     
     add_custom_target(${kernel_fname}_syn
-      DEPENDS ${SYN_BSTREAM} ${CL_SRC} ${CL_HEADER}
+      DEPENDS ${SYN_BSTREAM} ${CL_SRC} ${CL_HEADER} ${FFT_CALLBACKS_PATH}
       COMMENT 
         "Synthesizing for ${kernel_fname} using ${FPGA_BOARD_NAME} to folder ${CMAKE_RUNTIME_OUTPUT_DIRECTORY}"
     )
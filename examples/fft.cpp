@@ -35,43 +35,53 @@ int main(int argc, char* argv[]){
     const unsigned inv = config.inv;
     const bool burst = config.burst;
 
+    if(config.use_auto)
+      fftfpgaf_predict(config.dim, num, config.batch);
+
     for(unsigned i = 0; i < config.iter; i++){
       cout << i << ": Calculating FFT - " << endl;
-      switch(config.dim) {
-        case 1: {
-          if(config.use_usm)
-            runtime[i] = fftfpgaf_c2c_1d_svm(num, inp, out, inv, config.batch);
-          else
-            runtime[i] = fftfpgaf_c2c_1d(num, inp, out, inv, config.batch);
-          break;
-        }
-        case 2: {
-          if(config.use_bram && config.use_usm)
-            runtime[i] = fftfpgaf_c2c_2d_bram_svm(num, inp, out, inv, config.batch);
-          else if(config.use_bram && !config.use_usm)
-            runtime[i] = fftfpgaf_c2c_2d_bram(num, inp, out, inv, burst, config.batch);
-          else
-            runtime[i] = fftfpgaf_c2c_2d_ddr(num, inp, out, inv); 
-          break;
-        }
-        case 3:{
-          if(config.use_bram)
-            runtime[i] = fftfpgaf_c2c_3d_bram(num, inp, out, inv, burst);
-          else if(!config.use_bram && (!config.use_usm) && (config.batch > 1))
-            runtime[i] = fftfpgaf_c2c_3d_ddr_batch(num, inp, out, inv, burst, config.batch);
-          else if(config.use_usm){
-            if(config.batch > 1)
-              runtime[i] = fftfpgaf_c2c_3d_ddr_svm_batch(num, inp, out, inv, config.batch);
-            else 
-              runtime[i] = fftfpgaf_c2c_3d_ddr_svm(num, inp, out, inv, burst);
+      if(config.use_auto){
+        runtime[i] = fftfpgaf_c2c(config.dim, num, inp, out, inv, config.batch);
+      }
+      else{
+        switch(config.dim) {
+          case 1: {
+            if(config.use_usm)
+              runtime[i] = fftfpgaf_c2c_1d_svm(num, inp, out, inv, config.batch);
+            else
+              runtime[i] = fftfpgaf_c2c_1d(num, inp, out, inv, config.batch);
             break;
           }
-          else
-            runtime[i] = fftfpgaf_c2c_3d_ddr(num, inp, out, inv);
-          break;
+          case 2: {
+            if(config.use_bram && config.use_usm)
+              runtime[i] = fftfpgaf_c2c_2d_bram_svm(num, inp, out, inv, config.batch);
+            else if(config.use_bram && !config.use_usm)
+              runtime[i] = fftfpgaf_c2c_2d_bram(num, inp, out, inv, burst, config.batch);
+            else
+              runtime[i] = fftfpgaf_c2c_2d_ddr(num, inp, out, inv); 
+            break;
+          }
+          case 3:{
+            if(config.use_hybrid)
+              runtime[i] = fftfpgaf_c2c_3d_hybrid(num, inp, out, inv, burst);
+            else if(config.use_bram)
+              runtime[i] = fftfpgaf_c2c_3d_bram(num, inp, out, inv, burst);
+            else if(!config.use_bram && (!config.use_usm) && (config.batch > 1))
+              runtime[i] = fftfpgaf_c2c_3d_ddr_batch(num, inp, out, inv, burst, config.batch);
+            else if(config.use_usm){
+              if(config.batch > 1)
+                runtime[i] = fftfpgaf_c2c_3d_ddr_svm_batch(num, inp, out, inv, config.batch);
+              else 
+                runtime[i] = fftfpgaf_c2c_3d_ddr_svm(num, inp, out, inv, burst);
+              break;
+            }
+            else
+              runtime[i] = fftfpgaf_c2c_3d_ddr(num, inp, out, inv);
+            break;
+          }
+          default:
+            break;
         }
-        default:
-          break;
       }
 
       if(!config.noverify){
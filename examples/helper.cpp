@@ -7,16 +7,6 @@
 
 using namespace std;
 
-unsigned bit_reversed(unsigned x, const unsigned bits) {
-  unsigned y = 0;
-  for (unsigned i = 0; i < bits; i++) {
-    y <<= 1;
-    y |= x & 1;
-    x >>= 1;
-  }
-  return y;
-}
-
 /**
  * \brief  create random single precision complex floating point values  
  * \param  inp : pointer to float2 data of size N 
@@ -53,6 +43,8 @@ void parse_args(int argc, char* argv[], CONFIG &config){
       ("t, burst", "Toggle to use burst interleaved global memory accesses  in FPGA", cxxopts::value<bool>()->default_value("false") )
       ("m, use_bram", "Toggle to use BRAM instead of DDR for 3D Transpose  ", cxxopts::value<bool>()->default_value("false") )
       ("s, use_usm", "Toggle to use Unified Shared Memory features for data transfers between host and device", cxxopts::value<bool>()->default_value("false") )
+      ("u, use_hybrid", "Toggle to compute the 3D FFT using both the FPGA and the CPU", cxxopts::value<bool>()->default_value("false") )
+      ("a, auto", "Toggle to select the fastest of the FPGA variants and the CPU automatically", cxxopts::value<bool>()->default_value("false") )
       ("e, emulate", "Toggle to enable emulation ", cxxopts::value<bool>()->default_value("false") )
       ("h,help", "Print usage");
     auto opt = options.parse(argc, argv);
@@ -73,6 +65,8 @@ void parse_args(int argc, char* argv[], CONFIG &config){
     config.use_bram = opt["use_bram"].as<bool>();
     config.emulate = opt["emulate"].as<bool>();
     config.use_usm = opt["use_usm"].as<bool>();
+    config.use_hybrid = opt["use_hybrid"].as<bool>();
+    config.use_auto = opt["auto"].as<bool>();
 
     if(opt.count("path")){
       config.path = opt["path"].as<string>();
@@ -101,6 +95,8 @@ void print_config(const CONFIG config){
   printf("Burst Interleaving : %s \n", config.burst ? "Yes":"No");
   printf("Emulation          : %s \n", config.emulate ? "Yes":"No");
   printf("USM Feature        : %s \n", config.use_usm ? "Yes":"No");
+  printf("Hybrid CPU+FPGA    : %s \n", config.use_hybrid ? "Yes":"No");
+  printf("Auto Selection     : %s \n", config.use_auto ? "Yes":"No");
   printf("--------------------------------------------\n\n");
 }
 
@@ -140,27 +136,6 @@ bool verify_fftwf(const float2 *verify, float2 *fpgaout, const CONFIG config){
 
   fftwf_execute(plan);
 
-  if(config.dim == 1){
-    unsigned log_dim = log2(config.num);
-    float2 *tmp = new float2[total_sz]();
-
-    for(unsigned j = 0; j < config.batch; j++){
-      for(unsigned i = 0; i < config.num; i++){
-        unsigned index = (j*config.num) + i;
-        unsigned bit_rev = (j*config.num) + bit_reversed(i, log_dim);
-        
-        tmp[index].x = fpgaout[bit_rev].x;
-        tmp[index].y = fpgaout[bit_rev].y;
-      }
-    }
-    for(unsigned i = 0; i < total_sz; i++ ){
-      fpgaout[i].x = tmp[i].x;
-      fpgaout[i].y = tmp[i].y;
-    }
-
-    delete tmp;
-  }
-
   // Verification using SNR
   float mag_sum = 0, noise_sum = 0, magnitude, noise;
   for (size_t i = 0; i < total_sz; i++) {
@@ -212,10 +187,12 @@ void perf_measures(const CONFIG config, fpga_t *runtime){
     avg_runtime.exec_t += runtime[i].exec_t;
     avg_runtime.pcie_read_t += runtime[i].pcie_read_t;
     avg_runtime.pcie_write_t += runtime[i].pcie_write_t;
+    avg_runtime.cpu_t += runtime[i].cpu_t;
   }
   avg_runtime.exec_t = avg_runtime.exec_t / config.iter;
   avg_runtime.pcie_read_t = avg_runtime.pcie_read_t / config.iter;
   avg_runtime.pcie_write_t = avg_runtime.pcie_write_t / config.iter;
+  avg_runtime.cpu_t = avg_runtime.cpu_t / config.iter;
 
   fpga_t variance = {0.0, 0.0, 0.0, 0.0, 0.0, 0};
   fpga_t sd = {0.0, 0.0, 0.0, 0.0, 0.0, 0};
@@ -229,6 +206,9 @@ void perf_measures(const CONFIG config, fpga_t *runtime){
   sd.pcie_write_t = sqrt(variance.pcie_write_t / config.iter);
 
   double avg_total_runtime = avg_runtime.exec_t + avg_runtime.pcie_write_t + avg_runtime.pcie_read_t;
+  // readback and CPU computation overlap in hybrid executions
+  if(config.use_hybrid)
+    avg_total_runtime = avg_runtime.exec_t + avg_runtime.pcie_write_t + fmax(avg_runtime.pcie_read_t, avg_runtime.cpu_t);
 
   double gpoints_per_sec = (config.batch * pow(config.num, config.dim)) / (avg_runtime.exec_t * 1e-3 * 1024 * 1024);
 
@@ -244,6 +224,8 @@ void perf_measures(const CONFIG config, fpga_t *runtime){
   printf("Kernel Execution    = %.4lfms\n", avg_runtime.exec_t);
   printf("Kernel Exec/Batch   = %.4lfms\n", avg_runtime.exec_t / config.batch);
   printf("PCIe Read           = %.4lfms\n", avg_runtime.pcie_read_t);
+  if(config.use_hybrid)
+    printf("CPU Computation     = %.4lfms\n", avg_runtime.cpu_t);
   printf("Total               = %.4lfms\n", avg_total_runtime);
   printf("Throughput          = %.4lfGFLOPS/s | %.4lf GB/s\n", gflops, gBytes_per_sec);
   if(config.iter > 1){
@@ -16,6 +16,8 @@ struct CONFIG{
   bool use_bram;
   bool emulate;
   bool use_usm;
+  bool use_hybrid;
+  bool use_auto;
 };
 
 void parse_args(int argc, char* argv[], CONFIG &config);
@@ -0,0 +1,103 @@
+#include <iostream>
+#include <iomanip>
+#include <math.h>
+#include "cxxopts.hpp"
+#include "fftfpga/fftfpga.h"
+
+using namespace std;
+
+/**
+ * Microbenchmark of the DDR accesses of the 3D Transpose against N, using
+ * the transpose3d_bench bitstream. Prints the bandwidth of the sequential
+ * write and of the read along z in the layout [z][y][x] and in the tiled
+ * layout, and their efficiency relative to the peak bandwidth of a bank.
+ */
+int main(int argc, char* argv[]){
+
+  string path;
+  unsigned log_tile, min_n, max_n, iter;
+  double peak;
+  bool emulate;
+
+  try{
+    cxxopts::Options options("./transpose3d_bench", "DDR efficiency of the layouts of the 3D Transpose");
+    options.add_options()
+      ("p, path", "Path to the transpose3d_bench bitstream", cxxopts::value<string>())
+      ("l, log_tile", "Log of planes along z per block of the tiled layout", cxxopts::value<unsigned>()->default_value("3"))
+      ("min", "Smallest size of FFT3d", cxxopts::value<unsigned>()->default_value("16"))
+      ("max", "Largest size of FFT3d", cxxopts::value<unsigned>()->default_value("512"))
+      ("i, iter", "Number of iterations", cxxopts::value<unsigned>()->default_value("3"))
+      ("peak", "Peak bandwidth of a DDR bank in GB/s", cxxopts::value<double>()->default_value("19.2"))
+      ("e, emulate", "Toggle to enable emulation ", cxxopts::value<bool>()->default_value("false") )
+      ("h,help", "Print usage");
+    auto opt = options.parse(argc, argv);
+
+    if (opt.count("help")){
+      cout << options.help() << endl;
+      return 0;
+    }
+    if(!opt.count("path")){
+      throw "please input path to bitstream. Exiting! \n";
+    }
+
+    path = opt["path"].as<string>();
+    log_tile = opt["log_tile"].as<unsigned>();
+    min_n = opt["min"].as<unsigned>();
+    max_n = opt["max"].as<unsigned>();
+    iter = opt["iter"].as<unsigned>();
+    peak = opt["peak"].as<double>();
+    emulate = opt["emulate"].as<bool>();
+  }
+  catch(const char *msg){
+    cerr << "Error parsing options: " << msg << endl;
+    return EXIT_FAILURE;
+  }
+
+  const char* platform;
+  if(emulate)
+    platform = "Intel(R) FPGA Emulation Platform for OpenCL(TM)";
+  else
+    platform = "Intel(R) FPGA SDK for OpenCL(TM)";
+
+  int isInit = fpga_initialize(platform, path.data(), false);
+  if(isInit != 0){
+    cerr << "FPGA initialization error\n";
+    return EXIT_FAILURE;
+  }
+
+  cout << setw(6) << "N" << setw(8) << "Layout"
+       << setw(14) << "Write GB/s" << setw(10) << "Write %"
+       << setw(14) << "Read GB/s" << setw(10) << "Read %" << endl;
+
+  for(unsigned n = min_n; n <= max_n; n *= 2){
+    const double bytes = sizeof(float2) * pow(n, 3);
+    const unsigned layouts[2] = {0, log_tile};
+
+    for(unsigned l = 0; l < 2; l++){
+      double write_t = 0.0, read_t = 0.0;
+
+      // best of the iterations
+      for(unsigned i = 0; i < iter; i++){
+        double w = 0.0, r = 0.0;
+        int status = fftfpgaf_transpose3d_bench(n, layouts[l], &w, &r);
+        if(status != 0){
+          cerr << "Benchmark failed for N = " << n << ", status " << status << endl;
+          fpga_final();
+          return EXIT_FAILURE;
+        }
+        write_t = (i == 0 || w < write_t) ? w : write_t;
+        read_t = (i == 0 || r < read_t) ? r : read_t;
+      }
+
+      const double write_bw = bytes / (write_t * 1e6);
+      const double read_bw = bytes / (read_t * 1e6);
+      cout << setw(6) << n << setw(8) << (1u << layouts[l])
+           << fixed << setprecision(2)
+           << setw(14) << write_bw << setw(10) << 100.0 * write_bw / peak
+           << setw(14) << read_bw << setw(10) << 100.0 * read_bw / peak << endl;
+    }
+  }
+
+  fpga_final();
+  return EXIT_SUCCESS;
+}
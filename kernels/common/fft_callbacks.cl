@@ -0,0 +1,27 @@
+// Author: Arjun Ramaswami
+
+/**
+ * Load and store callbacks of the fetch and store kernels.
+ *
+ * fft_load is applied to every point read from global memory before the
+ * transform and fft_store to every point written to global memory after the
+ * transform, with the index of the point in the buffer. A file defining both
+ * functions with the signatures below is injected using the CMake option
+ * FFT_CALLBACKS_FILE, without it the points pass unchanged.
+ */
+
+#ifdef FFT_USE_CALLBACKS
+
+#include FFT_CALLBACKS_FILE
+
+#else
+
+float2 fft_load(float2 value, unsigned index){
+  return value;
+}
+
+float2 fft_store(float2 value, unsigned index){
+  return value;
+}
+
+#endif
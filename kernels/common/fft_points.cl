@@ -0,0 +1,272 @@
+// Author: Arjun Ramaswami
+
+/*
+ * Complex single-precision floating-point radix-2^2 feedforward FFT / iFFT
+ * engine processing POINTS = 2^LOGPOINTS points per invocation, for POINTS
+ * of 8, 16 or 32. It generalizes the 8-point engine of fft_8.cl, which is
+ * used unchanged for POINTS = 8, and keeps its interface: the inputs are
+ * POINTS ordered streams, lane k of step s holding the point
+ * bitrev(k) * (N / POINTS) + s, and lane k of output step s holds the
+ * frequency bitrev(s * POINTS + k). The outputs are delayed by
+ * N / POINTS - 1 steps.
+ *
+ * The bits of the index of the points are transformed from the most
+ * significant one, each by a butterfly between the lanes that differ in the
+ * lane bit holding it:
+ * - the LOGPOINTS highest bits are in the lanes, their butterflies are
+ *   spatial
+ * - every lower bit b is in the time index of the stream. A delay
+ *   commutator of depth 2^b swaps it with the lane bit that holds the bit
+ *   b + LOGPOINTS, transformed already, which becomes bit b of the output
+ *   step as required by the bit-reversed output.
+ *
+ * The twiddles of pairs of consecutive stages are merged as in radix-2^2:
+ * the first stage of a pair only multiplies by -i, the second by a factor
+ * read from the quarter-wave table of twid_quarter.cl.
+ */
+
+#if POINTS == 8
+
+#include "fft_8.cl"
+
+#else
+
+#include "twid_quarter.cl"
+
+#endif
+
+// The POINTS data points processed each step
+typedef struct {
+  float2 i[POINTS];
+} float2xp;
+
+#if POINTS != 8
+
+// Lane bit holding the bit b of the index while it is transformed, and after
+int fftp_lane_bit(int b, int logN) {
+  const int time_bits = logN - LOGPOINTS;
+  return (b >= time_bits) ? logN - 1 - b : (time_bits - 1 - b) % LOGPOINTS;
+}
+
+// Butterflies between the lanes that differ in the lane bit given
+float2xp fftp_butterfly(float2xp data, int lane_bit) {
+  float2xp res;
+  #pragma unroll
+  for (int k = 0; k < POINTS; k++) {
+    int pair = k ^ (1 << lane_bit);
+    if (k & (1 << lane_bit))
+      res.i[k] = data.i[pair] - data.i[k];
+    else
+      res.i[k] = data.i[k] + data.i[pair];
+  }
+  return res;
+}
+
+// Delays the input by 'depth' steps using a segment of the sliding window,
+// as 'delay' in fft_8.cl
+float2 fftp_delay(float2 data, const int depth, float2 *shift_reg) {
+  shift_reg[depth] = data;
+  return shift_reg[0];
+}
+
+// Delay commutator swapping a lane bit with the bit of the time index of
+// weight 'depth'. The lanes with the bit set are delayed before the swap,
+// the others after it, so that both are delayed by 'depth' steps. 'toggle'
+// is the bit of the time index of the input.
+float2xp fftp_reorder(float2xp data, int lane_bit, const int depth, float2 *shift_reg, bool toggle) {
+  #pragma unroll
+  for (int k = 0; k < POINTS; k++) {
+    if (k & (1 << lane_bit))
+      data.i[k] = fftp_delay(data.i[k], depth, shift_reg + k * (depth + 1));
+  }
+
+  if (toggle) {
+    #pragma unroll
+    for (int k = 0; k < POINTS; k++) {
+      if (!(k & (1 << lane_bit))) {
+        float2 tmp = data.i[k];
+        data.i[k] = data.i[k | (1 << lane_bit)];
+        data.i[k | (1 << lane_bit)] = tmp;
+      }
+    }
+  }
+
+  #pragma unroll
+  for (int k = 0; k < POINTS; k++) {
+    if (!(k & (1 << lane_bit)))
+      data.i[k] = fftp_delay(data.i[k], depth, shift_reg + k * (depth + 1));
+  }
+  return data;
+}
+
+// Implements a complex number multiplication
+float2 fftp_mult(float2 a, float2 b) {
+  float2 res;
+  res.x = a.x * b.x - a.y * b.y;
+  res.y = a.x * b.y + a.y * b.x;
+  return res;
+}
+
+// Twiddle factor exp(-2 pi i k / 2^logsize) of the forward transform, read
+// from the quarter-wave table up to the size of the table
+float2 fftp_twiddle(int k, int logsize) {
+  float2 twid;
+  if (logsize <= LOG_TWID_QUARTER) {
+    const int QUARTER = 1 << (LOG_TWID_QUARTER - 2);
+    int pos = (k << (LOG_TWID_QUARTER - logsize)) & ((1 << LOG_TWID_QUARTER) - 1);
+    int quadrant = pos / QUARTER;
+    int rem = pos & (QUARTER - 1);
+    float c = twid_quarter[rem], s = twid_quarter[QUARTER - rem];
+    float cos_pos = (quadrant == 0) ? c : (quadrant == 1) ? -s : (quadrant == 2) ? -c : s;
+    float sin_pos = (quadrant == 0) ? s : (quadrant == 1) ? c : (quadrant == 2) ? -s : -c;
+    twid.x = cos_pos;
+    twid.y = -sin_pos;
+  } else {
+    // This would generate hardware consuming a large number of resources
+    const float TWOPI = 2.0f * M_PI_F;
+    float theta = -1.0f * TWOPI * (float)(k & ((1 << logsize) - 1)) / (float)(1 << logsize);
+    twid.x = cos(theta);
+    twid.y = sin(theta);
+  }
+  return twid;
+}
+
+// Bit b of the index of the point in lane 'lane' and time index 't' before
+// the bit is transformed
+int fftp_index_bit(int lane, int t, int b, int logN) {
+  const int time_bits = logN - LOGPOINTS;
+  return (b < time_bits) ? (t >> b) & 1 : (lane >> (logN - 1 - b)) & 1;
+}
+
+// Process POINTS input points towards a FFT/iFFT of size N, N >= POINTS * POINTS,
+// with the arguments of fft_step in fft_8.cl. The sliding window
+// 'fft_delay_elements' holds N + POINTS * (log(N) - 2) points
+float2xp fftp_step(float2xp data, int step, float2 *fft_delay_elements,
+                   bool inverse, const int logN) {
+  const int size = 1 << logN;
+  const int time_bits = logN - LOGPOINTS;
+  const int steps = size / POINTS;
+
+  // Swap real and imaginary components if doing an inverse transform
+  if (inverse) {
+    #pragma unroll
+    for (int k = 0; k < POINTS; k++) {
+      float tmp = data.i[k].x;
+      data.i[k].x = data.i[k].y;
+      data.i[k].y = tmp;
+    }
+  }
+
+  int head = 0;
+
+  #pragma unroll
+  for (int b = logN - 1; b >= 0; b--) {
+    int lane_bit = fftp_lane_bit(b, logN);
+
+    // Bits of the time index move into the lanes, delaying the data by the
+    // weight of the bit. The time index of the data is corrected by the
+    // delays of the previous stages, 2^time_bits - 2^(b+1) steps
+    int t = step & (steps - 1);
+    if (b < time_bits) {
+      int t_in = (step + (2 << b)) & (steps - 1);
+      data = fftp_reorder(data, lane_bit, 1 << b, fft_delay_elements + head, (t_in >> b) & 1);
+      head += POINTS * ((1 << b) + 1);
+      t = (step + (1 << b)) & (steps - 1);
+    }
+
+    data = fftp_butterfly(data, lane_bit);
+
+    // First stage of a radix-2^2 pair: multiply by -i the differences of
+    // the points whose next bit is set
+    bool first = ((logN - 1 - b) & 1) == 0;
+    if (first && b > 0) {
+      #pragma unroll
+      for (int k = 0; k < POINTS; k++) {
+        if ((k & (1 << lane_bit)) && fftp_index_bit(k, t, b - 1, logN)) {
+          float2 tmp = data.i[k];
+          data.i[k].x = tmp.y;
+          data.i[k].y = -tmp.x;
+        }
+      }
+    }
+
+    // Second stage of a pair: the twiddle of both stages, exp(-2 pi i e / 2^(b+2))
+    // with e the product of the two transformed bits (f_b+1 + 2 f_b) and the
+    // untransformed lower bits of the index
+    if (!first && b > 0) {
+      #pragma unroll
+      for (int k = 0; k < POINTS; k++) {
+        int low = 0;
+        #pragma unroll
+        for (int l = 0; l < b; l++) {
+          low |= fftp_index_bit(k, t, l, logN) << l;
+        }
+        int freq = ((k >> fftp_lane_bit(b + 1, logN)) & 1) + 2 * ((k >> lane_bit) & 1);
+        data.i[k] = fftp_mult(data.i[k], fftp_twiddle(freq * low, b + 2));
+      }
+    }
+  }
+
+  // Lane k of the output holds bit l of its position in the lane bit of
+  // bit l of the index
+  float2xp res;
+  #pragma unroll
+  for (int k = 0; k < POINTS; k++) {
+    int lane = 0;
+    #pragma unroll
+    for (int l = 0; l < LOGPOINTS; l++) {
+      lane |= ((k >> l) & 1) << fftp_lane_bit(l, logN);
+    }
+    res.i[k] = data.i[lane];
+  }
+
+  // Shift the contents of the sliding window
+  #pragma unroll
+  for (int ii = 0; ii < size + POINTS * (logN - 2) - 1; ii++) {
+    fft_delay_elements[ii] = fft_delay_elements[ii + 1];
+  }
+
+  if (inverse) {
+    #pragma unroll
+    for (int k = 0; k < POINTS; k++) {
+      float tmp = res.i[k].x;
+      res.i[k].x = res.i[k].y;
+      res.i[k].y = tmp;
+    }
+  }
+
+  return res;
+}
+
+#endif
+
+// Process POINTS input points towards a FFT/iFFT of size N using the engine
+// of the number of points configured
+float2xp fft_step_points(float2xp data, int step, float2 *fft_delay_elements,
+                         bool inverse, const int logN) {
+#if POINTS == 8
+  float2x8 d;
+  d.i0 = data.i[0];
+  d.i1 = data.i[1];
+  d.i2 = data.i[2];
+  d.i3 = data.i[3];
+  d.i4 = data.i[4];
+  d.i5 = data.i[5];
+  d.i6 = data.i[6];
+  d.i7 = data.i[7];
+
+  d = fft_step(d, step, fft_delay_elements, inverse, logN);
+
+  data.i[0] = d.i0;
+  data.i[1] = d.i1;
+  data.i[2] = d.i2;
+  data.i[3] = d.i3;
+  data.i[4] = d.i4;
+  data.i[5] = d.i5;
+  data.i[6] = d.i6;
+  data.i[7] = d.i7;
+  return data;
+#else
+  return fftp_step(data, step, fft_delay_elements, inverse, logN);
+#endif
+}
@@ -0,0 +1,9 @@
+// Author: Arjun Ramaswami
+
+// Twiddle factors of the radix-2^2 engine of fft_points.cl
+// cos(2 pi k / 4096) for k = 0 .. 1024, a quarter of the unit circle from
+// which the factors of FFT sizes up to 4096 points are derived by symmetry
+
+#define LOG_TWID_QUARTER 12
+
+constant float twid_quarter[1025] = {1.0f, 0.9999988079f, 0.9999952912f, 0.9999893904f, 0.9999811649f, 0.9999706149f, 0.9999576211f, 0.9999423623f, 0.9999247193f, 0.9999046922f, 0.9998823404f, 0.9998576641f, 0.9998306036f, 0.9998011589f, 0.9997693896f, 0.9997352958f, 0.9996988177f, 0.9996600151f, 0.9996188283f, 0.9995753169f, 0.9995294213f, 0.9994812012f, 0.9994305968f, 0.9993776679f, 0.9993223548f, 0.9992647767f, 0.9992047548f, 0.9991424084f, 0.9990777373f, 0.9990106821f, 0.9989413023f, 0.9988695383f, 0.9987954497f, 0.9987190366f, 0.9986402392f, 0.9985590577f, 0.9984755516f, 0.9983897209f, 0.9983015656f, 0.9982110262f, 0.9981181026f, 0.9980228543f, 0.9979252815f, 0.9978253245f, 0.997723043f, 0.9976184368f, 0.9975114465f, 0.9974021316f, 0.9972904325f, 0.9971764088f, 0.9970600605f, 0.996941328f, 0.996820271f, 0.9966968894f, 0.9965711236f, 0.9964430332f, 0.9963126183f, 0.9961798191f, 0.9960446954f, 0.9959072471f, 0.9957674146f, 0.9956252575f, 0.9954807758f, 0.99533391f, 0.9951847196f, 0.9950332046f, 0.9948793054f, 0.9947231412f, 0.9945645928f, 0.9944036603f, 0.9942404628f, 0.9940748811f, 0.9939069748f, 0.9937367439f, 0.9935641289f, 0.9933891892f, 0.993211925f, 0.9930323362f, 0.9928504229f, 0.9926661253f, 0.9924795628f, 0.992290616f, 0.9920992851f, 0.9919056892f, 0.9917097688f, 0.9915114641f, 0.9913108349f, 0.9911079407f, 0.9909026623f, 0.9906949997f, 0.9904850721f, 0.99027282f, 0.9900581837f, 0.9898412824f, 0.9896219969f, 0.9894004464f, 0.9891765118f, 0.9889502525f, 0.9887216687f, 0.9884908199f, 0.988257587f, 0.9880220294f, 0.9877841473f, 0.9875439405f, 0.9873014092f, 0.9870565534f, 0.9868093729f, 0.9865599275f, 0.9863080978f, 0.9860539436f, 0.9857975245f, 0.9855387211f, 0.9852776527f, 0.9850142598f, 0.9847484827f, 0.9844804406f, 0.9842100739f, 0.9839374423f, 0.9836624265f, 0.9833850861f, 0.9831054807f, 0.9828235507f, 0.9825392962f, 0.982252717f, 0.9819638729f, 0.9816727042f, 0.9813792109f, 0.9810833931f, 0.9807852507f, 0.9804848433f, 0.9801821113f, 0.9798771143f, 0.9795697927f, 0.9792601466f, 0.9789481759f, 0.9786339402f, 0.97831738f, 0.9779984951f, 0.9776773453f, 0.9773538709f, 0.9770281315f, 0.9767000675f, 0.9763697386f, 0.9760370851f, 0.975702107f, 0.9753648639f, 0.9750253558f, 0.9746835232f, 0.974339366f, 0.9739929438f, 0.9736442566f, 0.9732932448f, 0.9729399681f, 0.9725843668f, 0.9722265005f, 0.9718663096f, 0.9715039134f, 0.971139133f, 0.9707721472f, 0.9704028368f, 0.9700312614f, 0.9696573615f, 0.9692812562f, 0.9689028263f, 0.9685220718f, 0.968139112f, 0.9677538276f, 0.9673662782f, 0.9669764638f, 0.9665843844f, 0.9661899805f, 0.9657933712f, 0.9653944373f, 0.9649932384f, 0.9645897746f, 0.9641840458f, 0.963776052f, 0.9633657932f, 0.9629532695f, 0.9625384808f, 0.9621214271f, 0.9617020488f, 0.9612804651f, 0.9608566165f, 0.9604305029f, 0.9600021243f, 0.9595715404f, 0.9591386318f, 0.9587034583f, 0.9582660794f, 0.9578264356f, 0.9573845267f, 0.9569403529f, 0.9564939141f, 0.95604527f, 0.9555943608f, 0.9551411867f, 0.9546857476f, 0.9542281032f, 0.9537681937f, 0.9533060193f, 0.9528416395f, 0.9523749948f, 0.9519061446f, 0.9514350295f, 0.9509616494f, 0.950486064f, 0.9500082731f, 0.9495281577f, 0.9490458965f, 0.9485613704f, 0.9480745792f, 0.9475855827f, 0.9470943809f, 0.946600914f, 0.9461052418f, 0.9456073046f, 0.9451072216f, 0.9446048141f, 0.9441002607f, 0.9435934424f, 0.9430844188f, 0.9425731897f, 0.9420597553f, 0.9415440559f, 0.9410261512f, 0.940506041f, 0.9399837255f, 0.9394592047f, 0.9389324784f, 0.9384035468f, 0.9378723502f, 0.9373390079f, 0.9368034601f, 0.9362656474f, 0.9357256889f, 0.9351835251f, 0.9346391559f, 0.9340925217f, 0.9335438013f, 0.932992816f, 0.9324396253f, 0.9318842888f, 0.9313266873f, 0.9307669401f, 0.9302050471f, 0.9296408892f, 0.9290745854f, 0.9285060763f, 0.9279354215f, 0.9273625016f, 0.9267874956f, 0.9262102246f, 0.9256308079f, 0.9250492454f, 0.9244654775f, 0.9238795042f, 0.9232914448f, 0.9227011204f, 0.9221086502f, 0.9215140343f, 0.920917213f, 0.9203183055f, 0.919717133f, 0.9191138744f, 0.9185084105f, 0.9179008007f, 0.9172909856f, 0.9166790843f, 0.9160649776f, 0.9154487252f, 0.914830327f, 0.9142097831f, 0.9135870337f, 0.9129621983f, 0.9123351574f, 0.9117060304f, 0.9110747576f, 0.9104412794f, 0.9098057151f, 0.909168005f, 0.9085280895f, 0.9078860879f, 0.9072420001f, 0.9065957069f, 0.905947268f, 0.9052967429f, 0.9046440721f, 0.903989315f, 0.9033323526f, 0.9026733041f, 0.9020121694f, 0.9013488293f, 0.900683403f, 0.9000158906f, 0.8993462324f, 0.8986744881f, 0.898000598f, 0.8973245621f, 0.8966464996f, 0.8959662318f, 0.8952839375f, 0.8945994973f, 0.893912971f, 0.893224299f, 0.8925335407f, 0.8918406963f, 0.8911457658f, 0.8904487491f, 0.8897495866f, 0.8890483379f, 0.8883450627f, 0.8876396418f, 0.8869321346f, 0.8862225413f, 0.8855108619f, 0.8847970963f, 0.8840812445f, 0.8833633661f, 0.882643342f, 0.8819212914f, 0.8811970949f, 0.8804708719f, 0.8797426224f, 0.8790122271f, 0.8782798052f, 0.8775452971f, 0.8768087029f, 0.8760700822f, 0.8753293753f, 0.8745866418f, 0.8738418221f, 0.8730949759f, 0.8723460436f, 0.8715950847f, 0.8708420396f, 0.8700869679f, 0.8693298697f, 0.8685706854f, 0.8678094745f, 0.867046237f, 0.866280973f, 0.8655136228f, 0.864744246f, 0.8639728427f, 0.8631994128f, 0.8624239564f, 0.8616464734f, 0.8608669639f, 0.8600853682f, 0.8593018055f, 0.8585162163f, 0.8577286005f, 0.8569389582f, 0.8561473489f, 0.8553536534f, 0.854557991f, 0.8537603021f, 0.8529605865f, 0.8521589041f, 0.851355195f, 0.8505494595f, 0.8497417569f, 0.8489320278f, 0.8481203318f, 0.8473066092f, 0.8464909196f, 0.8456732631f, 0.84485358f, 0.8440318704f, 0.8432082534f, 0.8423826098f, 0.8415549994f, 0.8407253623f, 0.8398938179f, 0.8390602469f, 0.838224709f, 0.8373872042f, 0.8365477324f, 0.8357062936f, 0.8348628879f, 0.8340175152f, 0.8331701756f, 0.832320869f, 0.8314695954f, 0.8306164145f, 0.8297612071f, 0.8289040923f, 0.8280450702f, 0.8271840215f, 0.8263210654f, 0.8254561424f, 0.8245893121f, 0.8237205148f, 0.8228498101f, 0.8219771385f, 0.8211025f, 0.8202259541f, 0.8193475008f, 0.8184671402f, 0.8175848126f, 0.8167005777f, 0.8158144355f, 0.8149263263f, 0.8140363097f, 0.8131443858f, 0.8122506142f, 0.8113548756f, 0.81045717f, 0.8095576167f, 0.8086561561f, 0.8077528477f, 0.8068475723f, 0.8059403896f, 0.8050313592f, 0.8041203618f, 0.8032075167f, 0.8022928238f, 0.801376164f, 0.8004576564f, 0.7995372415f, 0.7986149788f, 0.7976908684f, 0.796764791f, 0.7958369255f, 0.7949071527f, 0.7939754725f, 0.7930419445f, 0.7921065688f, 0.7911693454f, 0.7902302146f, 0.7892892361f, 0.7883464098f, 0.7874017358f, 0.786455214f, 0.7855068445f, 0.7845565677f, 0.7836045027f, 0.7826505899f, 0.7816948295f, 0.7807372212f, 0.7797777653f, 0.7788165212f, 0.7778534293f, 0.7768884897f, 0.7759217024f, 0.7749531269f, 0.7739827037f, 0.7730104327f, 0.7720363736f, 0.7710605264f, 0.7700828314f, 0.7691033483f, 0.7681220174f, 0.7671388984f, 0.7661539912f, 0.7651672363f, 0.7641787529f, 0.7631884217f, 0.7621963024f, 0.761202395f, 0.7602066994f, 0.7592092156f, 0.7582098842f, 0.7572088242f, 0.756205976f, 0.7552013993f, 0.7541949749f, 0.7531868219f, 0.7521768212f, 0.7511651516f, 0.7501516342f, 0.7491363883f, 0.7481193542f, 0.7471005917f, 0.7460801005f, 0.7450577617f, 0.7440337539f, 0.7430079579f, 0.7419804335f, 0.7409511209f, 0.7399200797f, 0.73888731f, 0.7378528118f, 0.7368165851f, 0.7357785702f, 0.7347388864f, 0.7336974144f, 0.7326542735f, 0.7316094041f, 0.7305627465f, 0.72951442f, 0.728464365f, 0.727412641f, 0.726359129f, 0.7253039479f, 0.724247098f, 0.7231884599f, 0.7221282125f, 0.7210661769f, 0.720002532f, 0.718937099f, 0.7178700566f, 0.7168012857f, 0.7157308459f, 0.7146586776f, 0.7135848403f, 0.7125093937f, 0.7114322186f, 0.7103533745f, 0.7092728019f, 0.7081906199f, 0.7071067691f, 0.7060212493f, 0.7049340606f, 0.7038452625f, 0.7027547359f, 0.7016626f, 0.7005687952f, 0.6994733214f, 0.6983762383f, 0.6972774863f, 0.696177125f, 0.6950750947f, 0.6939714551f, 0.6928661466f, 0.6917592287f, 0.6906507015f, 0.689540565f, 0.6884287596f, 0.6873153448f, 0.6862003207f, 0.6850836873f, 0.683965385f, 0.6828455329f, 0.6817240715f, 0.6806010008f, 0.6794763207f, 0.6783500314f, 0.6772221923f, 0.6760926843f, 0.6749616265f, 0.6738290191f, 0.6726947427f, 0.6715589762f, 0.6704215407f, 0.6692826152f, 0.6681420207f, 0.6669999361f, 0.6658562422f, 0.6647109985f, 0.6635641456f, 0.6624158025f, 0.6612658501f, 0.6601143479f, 0.6589612961f, 0.6578066945f, 0.6566505432f, 0.6554928422f, 0.6543335915f, 0.6531728506f, 0.65201056f, 0.6508466601f, 0.6496813297f, 0.64851439f, 0.6473459601f, 0.6461760402f, 0.6450045109f, 0.6438315511f, 0.6426570415f, 0.6414810419f, 0.6403034925f, 0.6391244531f, 0.6379439235f, 0.6367618442f, 0.6355783343f, 0.6343932748f, 0.6332067847f, 0.6320187449f, 0.630829215f, 0.6296382546f, 0.6284457445f, 0.6272518039f, 0.6260563731f, 0.6248595119f, 0.6236611009f, 0.6224612594f, 0.6212599874f, 0.6200572252f, 0.618852973f, 0.6176472902f, 0.616440177f, 0.6152315736f, 0.6140215397f, 0.6128100753f, 0.6115971804f, 0.6103827953f, 0.6091670394f, 0.6079497933f, 0.6067311168f, 0.6055110693f, 0.6042895317f, 0.6030666232f, 0.6018422246f, 0.6006164551f, 0.5993893147f, 0.5981606841f, 0.5969306827f, 0.5956993103f, 0.5944665074f, 0.5932322741f, 0.5919966698f, 0.5907596946f, 0.5895212889f, 0.5882815719f, 0.5870403647f, 0.5857978463f, 0.584553957f, 0.5833086371f, 0.582062006f, 0.5808139443f, 0.5795645714f, 0.5783137679f, 0.5770616531f, 0.5758081675f, 0.5745533705f, 0.573297143f, 0.5720396042f, 0.5707807541f, 0.5695205331f, 0.5682589412f, 0.566996038f, 0.5657318234f, 0.564466238f, 0.5631993413f, 0.5619311333f, 0.5606615543f, 0.5593907237f, 0.5581185222f, 0.5568450093f, 0.5555702448f, 0.5542941093f, 0.5530167222f, 0.5517379642f, 0.5504579544f, 0.5491766334f, 0.5478940606f, 0.5466101766f, 0.5453249812f, 0.5440385342f, 0.5427507758f, 0.5414617658f, 0.5401714444f, 0.538879931f, 0.5375870466f, 0.5362929702f, 0.534997642f, 0.5337010026f, 0.5324031115f, 0.5311040282f, 0.5298036337f, 0.5285019875f, 0.5271991491f, 0.5258949995f, 0.5245896578f, 0.523283124f, 0.5219752789f, 0.5206662416f, 0.5193560123f, 0.5180445313f, 0.5167317986f, 0.5154178739f, 0.514102757f, 0.5127863884f, 0.5114688277f, 0.510150075f, 0.5088301301f, 0.5075089931f, 0.5061866641f, 0.5048630834f, 0.5035383701f, 0.5022124648f, 0.5008853674f, 0.4995571077f, 0.4982276559f, 0.4968970418f, 0.4955652654f, 0.4942322969f, 0.492898196f, 0.4915629029f, 0.4902264774f, 0.4888888896f, 0.4875501692f, 0.4862102866f, 0.4848692417f, 0.4835270643f, 0.4821837842f, 0.4808393419f, 0.479493767f, 0.4781470597f, 0.4767992198f, 0.4754502773f, 0.4741002023f, 0.4727490246f, 0.4713967443f, 0.4700433314f, 0.4686888158f, 0.4673331976f, 0.4659765065f, 0.4646186829f, 0.4632597864f, 0.4618997872f, 0.4605387151f, 0.4591765404f, 0.4578132927f, 0.4564489722f, 0.4550835788f, 0.4537171125f, 0.4523495734f, 0.4509809911f, 0.449611336f, 0.448240608f, 0.4468688369f, 0.4454960227f, 0.4441221356f, 0.4427472353f, 0.4413712621f, 0.4399942756f, 0.438616246f, 0.4372371733f, 0.4358570874f, 0.4344759583f, 0.433093816f, 0.4317106605f, 0.4303264916f, 0.4289412796f, 0.4275550842f, 0.4261678755f, 0.4247796834f, 0.4233904779f, 0.4220002592f, 0.4206090868f, 0.4192169011f, 0.4178237021f, 0.4164295495f, 0.4150344133f, 0.4136383235f, 0.4122412205f, 0.4108431637f, 0.4094441533f, 0.4080441594f, 0.4066432118f, 0.4052413106f, 0.4038384557f, 0.4024346471f, 0.4010298848f, 0.3996241987f, 0.3982175589f, 0.3968099952f, 0.3954014778f, 0.3939920366f, 0.3925816715f, 0.3911703825f, 0.3897581697f, 0.3883450329f, 0.3869310021f, 0.3855160475f, 0.3841001987f, 0.3826834261f, 0.3812657595f, 0.3798471987f, 0.3784277439f, 0.3770074248f, 0.3755861819f, 0.3741640747f, 0.3727410734f, 0.3713172078f, 0.3698924482f, 0.3684668243f, 0.3670403361f, 0.3656129837f, 0.3641847968f, 0.3627557158f, 0.3613258004f, 0.3598950505f, 0.3584634066f, 0.3570309579f, 0.3555976748f, 0.3541635275f, 0.3527285457f, 0.3512927592f, 0.3498561382f, 0.3484186828f, 0.3469804227f, 0.3455413282f, 0.344101429f, 0.3426607251f, 0.3412192166f, 0.3397768736f, 0.3383337557f, 0.336889863f, 0.3354451358f, 0.3339996636f, 0.3325533569f, 0.3311063051f, 0.3296584487f, 0.3282098472f, 0.3267604411f, 0.3253102899f, 0.3238593638f, 0.3224076927f, 0.3209552467f, 0.3195020258f, 0.3180480897f, 0.3165933788f, 0.3151379228f, 0.3136817515f, 0.3122248054f, 0.310767144f, 0.3093087673f, 0.3078496456f, 0.3063898087f, 0.3049292266f, 0.3034679592f, 0.3020059466f, 0.3005432487f, 0.2990798354f, 0.2976157069f, 0.296150893f, 0.2946853638f, 0.2932191491f, 0.291752249f, 0.2902846634f, 0.2888164222f, 0.2873474658f, 0.2858778238f, 0.2844075263f, 0.282936573f, 0.2814649343f, 0.27999264f, 0.27851969f, 0.2770460844f, 0.2755718231f, 0.2740969062f, 0.2726213634f, 0.271145165f, 0.2696683109f, 0.2681908607f, 0.266712755f, 0.2652340233f, 0.2637546659f, 0.2622747123f, 0.2607941031f, 0.2593129277f, 0.2578310966f, 0.2563486695f, 0.2548656464f, 0.2533820271f, 0.2518978119f, 0.2504130006f, 0.2489276081f, 0.2474416196f, 0.24595505f, 0.2444678992f, 0.2429801822f, 0.241491884f, 0.2400030196f, 0.2385135889f, 0.2370236069f, 0.2355330586f, 0.234041959f, 0.2325503081f, 0.2310581058f, 0.2295653671f, 0.228072077f, 0.2265782654f, 0.2250839174f, 0.2235890329f, 0.2220936269f, 0.2205976844f, 0.2191012353f, 0.2176042795f, 0.2161068022f, 0.2146088183f, 0.2131103128f, 0.2116113305f, 0.2101118416f, 0.208611846f, 0.2071113735f, 0.2056104094f, 0.2041089684f, 0.2026070356f, 0.201104641f, 0.1996017545f, 0.1980984062f, 0.1965945959f, 0.1950903237f, 0.1935855895f, 0.1920803934f, 0.1905747503f, 0.1890686601f, 0.1875621229f, 0.1860551536f, 0.1845477372f, 0.1830398887f, 0.1815316081f, 0.1800228953f, 0.1785137653f, 0.1770042181f, 0.1754942536f, 0.1739838719f, 0.1724730879f, 0.1709618866f, 0.169450298f, 0.167938292f, 0.1664258987f, 0.1649131179f, 0.1633999497f, 0.161886394f, 0.1603724509f, 0.1588581502f, 0.1573434621f, 0.1558284014f, 0.1543129683f, 0.1527971923f, 0.1512810439f, 0.1497645378f, 0.1482476741f, 0.1467304677f, 0.1452129185f, 0.1436950266f, 0.1421768069f, 0.1406582445f, 0.1391393393f, 0.1376201212f, 0.1361005753f, 0.1345807016f, 0.1330605298f, 0.1315400302f, 0.1300192177f, 0.1284981072f, 0.1269766986f, 0.1254549772f, 0.1239329726f, 0.1224106774f, 0.1208880842f, 0.1193652153f, 0.1178420633f, 0.1163186282f, 0.1147949249f, 0.1132709533f, 0.1117467135f, 0.1102222055f, 0.1086974442f, 0.1071724221f, 0.1056471542f, 0.1041216329f, 0.1025958657f, 0.1010698602f, 0.09954361618f, 0.09801714122f, 0.09649042785f, 0.09496349841f, 0.09343633801f, 0.09190895408f, 0.09038136154f, 0.08885355294f, 0.08732553571f, 0.08579730988f, 0.08426889032f, 0.08274026215f, 0.08121144772f, 0.07968243957f, 0.07815324515f, 0.07662386447f, 0.07509429753f, 0.07356456667f, 0.07203464955f, 0.07050457597f, 0.06897433102f, 0.06744392216f, 0.06591334939f, 0.06438262761f, 0.06285175681f, 0.061320737f, 0.05978957191f, 0.05825826526f, 0.05672682077f, 0.05519524589f, 0.05366353691f, 0.05213170499f, 0.05059975013f, 0.04906767607f, 0.04753548279f, 0.04600318149f, 0.04447077215f, 0.0429382585f, 0.04140564054f, 0.03987292573f, 0.03834012151f, 0.03680722415f, 0.03527423739f, 0.0337411724f, 0.03220802546f, 0.030674804f, 0.02914150804f, 0.02760814503f, 0.02607471868f, 0.02454122901f, 0.02300768159f, 0.02147408016f, 0.01994042844f, 0.01840673015f, 0.01687298715f, 0.01533920597f, 0.01380538847f, 0.01227153838f, 0.01073765941f, 0.009203754365f, 0.007669828832f, 0.006135884672f, 0.004601926077f, 0.003067956772f, 0.001533980132f, 6.123234263e-17f};
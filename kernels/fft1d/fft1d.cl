@@ -43,12 +43,13 @@
  * efficient hardware.
  */
 
-// Include source code for an engine that produces 8 points each step
-#include "../common/fft_8.cl" 
-
 #pragma OPENCL EXTENSION cl_intel_channels : enable
 
 #include "fft_config.h"
+#include "../common/fft_callbacks.cl"
+
+// Include source code for an engine that produces POINTS points each step
+#include "../common/fft_points.cl"
 
 #define min(a,b) (a<b?a:b)
 
@@ -56,15 +57,22 @@
 
 // Log of how much to fetch at once for one area of input buffer.
 // LOG_CONT_FACTOR_LIMIT computation makes sure that C_LEN below
-// is non-negative. Keep it bounded by 6, as going larger will waste
-// on-chip resources but won't give performance gains.
+// is non-negative. Keep the local buffer of CONT_FACTOR * POINTS * POINTS
+// points bounded by 4096, i.e. CONT_FACTOR by 64 for 8 points, as going
+// larger will waste on-chip resources but won't give performance gains.
+// The host derives POINTS from the resulting work-group size.
 #define LOG_CONT_FACTOR_LIMIT1 (LOGN - (2 * (LOGPOINTS)))
 #define LOG_CONT_FACTOR_LIMIT2 (((LOG_CONT_FACTOR_LIMIT1) >= 0) ? (LOG_CONT_FACTOR_LIMIT1) : 0)
-#define LOG_CONT_FACTOR        (((LOG_CONT_FACTOR_LIMIT2) <= 6) ? (LOG_CONT_FACTOR_LIMIT1) : 6)
+#define LOG_CONT_FACTOR_MAX    (12 - (2 * (LOGPOINTS)))
+#define LOG_CONT_FACTOR        (((LOG_CONT_FACTOR_LIMIT2) <= LOG_CONT_FACTOR_MAX) ? (LOG_CONT_FACTOR_LIMIT2) : LOG_CONT_FACTOR_MAX)
 #define CONT_FACTOR            (1 << LOG_CONT_FACTOR)
 
+#if LOGN < 2 * LOGPOINTS
+#error "fft1d requires at least POINTS * POINTS points per transform"
+#endif
+
 // Need some depth to our channels to accommodate their bursty filling.
-channel float2 chanin[8] __attribute__((depth(CONT_FACTOR*8)));
+channel float2 chanin[POINTS] __attribute__((depth(CONT_FACTOR*POINTS)));
 
 uint bit_reversed(uint x, uint bits) {
   uint y = 0;
@@ -78,14 +86,42 @@ uint bit_reversed(uint x, uint bits) {
   return y;
 }
 
+// Largest transform reordered to natural order through an on-chip buffer of
+// 2 * N points. Larger transforms scatter their points to the bit-reversed
+// positions in global memory instead.
+#ifndef LOG_ONCHIP_BITREV
+#define LOG_ONCHIP_BITREV 14
+#endif
+#define ONCHIP_BITREV (LOGN <= LOG_ONCHIP_BITREV)
+
+// Reorder the points of a transform from the bit-reversed order of the FFT
+// engine to natural order, as bitreverse_in of the transpose kernels for
+// POINTS points. The points of a step are written to bufA and those of the
+// transform before are read from bufB, delaying them by N / POINTS steps.
+float2xp bitreverse_points(float2xp data, float2 bufA[N], float2 bufB[N], uint row) {
+  uint index = (row & (N / POINTS - 1)) * POINTS;
+
+  #pragma unroll
+  for (uint k = 0; k < POINTS; k++) {
+    bufA[index + k] = data.i[k];
+  }
+
+  float2xp res;
+  #pragma unroll
+  for (uint k = 0; k < POINTS; k++) {
+    res.i[k] = bufB[bit_reversed(index + k, LOGN)];
+  }
+  return res;
+}
+
 // fetch N points as follows:
-// - each thread will load 8 consecutive values
-// - load CONT_FACTOR consecutive loads (8 values each), then jump by N/8, and load next
-//   CONT_FACTOR consecutive values.
-// - Once load CONT_FACTOR values starting at 7N/8, send CONT_FACTOR values
-//   into the channel to the fft kernel.
+// - each thread will load POINTS consecutive values
+// - load CONT_FACTOR consecutive loads (POINTS values each), then jump by
+//   N/POINTS, and load next CONT_FACTOR consecutive values.
+// - Once load CONT_FACTOR values starting at (POINTS-1)N/POINTS, send
+//   CONT_FACTOR values into the channel to the fft kernel.
 // - start process again. 
-// This way, only need 8xCONT_FACTOR local memory buffer, instead of 8xN.
+// This way, only need POINTSxCONT_FACTOR local memory buffer, instead of POINTSxN.
 //
 // Group index is used as follows ( 0 to CONT_FACTOR, iteration num )
 //
@@ -94,8 +130,8 @@ uint bit_reversed(uint x, uint bits) {
 // <   C ><B><  A >
 // 5432109876543210
 //  A -- fetch within contiguous block
-//  B -- B * N/8 region selector
-//  C -- num times fetch cont_factor * 8 values (or num times fill the buffer)
+//  B -- B * N/POINTS region selector
+//  C -- num times fetch cont_factor * POINTS values (or num times fill the buffer)
 
 // INPUT GID POINTS
 // C_LEN must be at least 0. Can't be negative.
@@ -136,10 +172,20 @@ uint permute_gid (uint gid) {
   return result;
 }
 
-// group dimension (N/(8*CONT_FACTOR), num_iterations)
+// Address of the first point of a line, i.e. of a 1D FFT. Lines are counted
+// in groups of 'inner' lines 'inner_dist' apart, the groups 'outer_dist' apart.
+// Together with the 'stride' between the points of a line, this addresses
+// the lines along any axis of a 3D array. Contiguous lines have a stride of 1,
+// 'inner' 1 and 'outer_dist' N.
+uint line_start(uint line, uint inner, uint inner_dist, uint outer_dist) {
+  return (line / inner) * outer_dist + (line % inner) * inner_dist;
+}
+
+// group dimension (N/(POINTS*CONT_FACTOR), num_iterations)
 __attribute__((reqd_work_group_size(CONT_FACTOR * POINTS, 1, 1)))
 kernel 
-void fetch(__global __attribute__((buffer_location(SVM_HOST_BUFFER_LOCATION))) volatile float2 * restrict src) {
+void fetch(__global __attribute__((buffer_location(SVM_HOST_BUFFER_LOCATION))) volatile float2 * restrict src,
+  uint stride, uint inner, uint inner_dist, uint outer_dist) {
 
   // Each thread will fetch POINTS points. Need POINTS times to pass to FFT.
   const int BUF_SIZE = 1 << (LOG_CONT_FACTOR + LOGPOINTS + LOGPOINTS);
@@ -156,16 +202,21 @@ void fetch(__global __attribute__((buffer_location(SVM_HOST_BUFFER_LOCATION))) v
   uint lid = get_local_id(0);
   uint local_addr = lid << LOGPOINTS;
 
+  // position of the points in the array
+  uint start = line_start(global_addr >> LOGN, inner, inner_dist, outer_dist);
+  uint pos = global_addr & (N - 1);
+
   #pragma unroll
   for (uint k = 0; k < POINTS; k++) {
-    buf[local_addr + k] = src[global_addr + k];
+    uint addr = start + (pos + k) * stride;
+    buf[local_addr + k] = fft_load(src[addr], addr);
   }
 
   barrier (CLK_LOCAL_MEM_FENCE);
 
   #pragma unroll
   for (uint k = 0; k < POINTS; k++) {
-    uint buf_addr = bit_reversed(k,3) * CONT_FACTOR * POINTS + lid;
+    uint buf_addr = bit_reversed(k, LOGPOINTS) * CONT_FACTOR * POINTS + lid;
     write_channel_intel (chanin[k], buf[buf_addr]);
   }
 }
@@ -178,10 +229,13 @@ void fetch(__global __attribute__((buffer_location(SVM_HOST_BUFFER_LOCATION))) v
  * using restrict pointers as there are no dependencies between the buffers
  * 'count' represents the number of 4k sets to process
  * 'inverse' toggles between the direct and the inverse transform
+ * 'natural' stores the output in natural order instead of the bit-reversed
+ * order of the FFT engine
  */
 
 kernel 
-void fft1d(__global __attribute__((buffer_location(SVM_HOST_BUFFER_LOCATION))) volatile float2 * restrict dest, int count, int inverse) {
+void fft1d(__global __attribute__((buffer_location(SVM_HOST_BUFFER_LOCATION))) volatile float2 * restrict dest, int count, int inverse,
+  uint stride, uint inner, uint inner_dist, uint outer_dist, int natural) {
 
   /* The FFT engine requires a sliding window array for data reordering; data 
    * stored in this array is carried across loop iterations and shifted by one 
@@ -189,64 +243,85 @@ void fft1d(__global __attribute__((buffer_location(SVM_HOST_BUFFER_LOCATION))) v
    * this array are simple transfers between adjacent array elements
    */
 
-  float2 fft_delay_elements[N + 8 * (LOGN - 2)];
+  float2 fft_delay_elements[N + POINTS * (LOGN - 2)];
+
+#if ONCHIP_BITREV
+  // Reorder buffers swapped every transform, delaying the output by N / POINTS steps
+  float2 bitrev[2][N];
+  bool is_bitrevA = false;
+  const int REORDER_DELAY = natural ? N / POINTS : 0;
+#else
+  const int REORDER_DELAY = 0;
+#endif
 
   /* This is the main loop. It runs 'count' back-to-back FFT transforms
-   * In addition to the 'count * (N / 8)' iterations, it runs 'N / 8 - 1'
-   * additional iterations to drain the last outputs 
-   * (see comments attached to the FFT engine)
+   * In addition to the 'count * (N / POINTS)' iterations, it runs
+   * 'N / POINTS - 1' additional iterations to drain the last outputs 
+   * (see comments attached to the FFT engine), and N / POINTS more to drain
+   * the reorder buffer
    *
    * The compiler leverages pipeline parallelism by overlapping the 
    * iterations of this loop - launching one iteration every clock cycle
    */
 
-  for (unsigned i = 0; i < count * (N / 8) + N / 8 - 1; i++) {
+  for (unsigned i = 0; i < count * (N / POINTS) + N / POINTS - 1 + REORDER_DELAY; i++) {
 
-    /* As required by the FFT engine, gather input data from 8 distinct 
-     * segments of the input buffer; for simplicity, this implementation 
-     * does not attempt to coalesce memory accesses and this leads to 
-     * higher resource utilization (see the fft2d example for advanced 
-     * memory access techniques)
+    /* As required by the FFT engine, gather input data from POINTS distinct 
+     * segments of the input buffer, fetched by the fetch kernel
      */
 
-    int base = (i / (N / 8)) * N;
-    int offset = i % (N / 8);
-
-    float2x8 data;
+    float2xp data;
     // Perform memory transfers only when reading data in range
-    if (i < count * (N / 8)) {
-      data.i0 = read_channel_intel(chanin[0]);
-      data.i1 = read_channel_intel(chanin[1]);
-      data.i2 = read_channel_intel(chanin[2]);
-      data.i3 = read_channel_intel(chanin[3]);
-      data.i4 = read_channel_intel(chanin[4]);
-      data.i5 = read_channel_intel(chanin[5]);
-      data.i6 = read_channel_intel(chanin[6]);
-      data.i7 = read_channel_intel(chanin[7]);
+    if (i < count * (N / POINTS)) {
+      #pragma unroll
+      for (uint k = 0; k < POINTS; k++) {
+        data.i[k] = read_channel_intel(chanin[k]);
+      }
     } else {
-      data.i0 = data.i1 = data.i2 = data.i3 = 
-                data.i4 = data.i5 = data.i6 = data.i7 = 0;
+      #pragma unroll
+      for (uint k = 0; k < POINTS; k++) {
+        data.i[k] = 0;
+      }
     }
 
     // Perform one step of the FFT engine
-    data = fft_step(data, i % (N / 8), fft_delay_elements, inverse, LOGN); 
+    data = fft_step_points(data, i % (N / POINTS), fft_delay_elements, inverse, LOGN); 
+
+    // step of the output of the FFT engine
+    int step = (int)i - (N / POINTS - 1);
+
+#if ONCHIP_BITREV
+    // Swap reorder buffers every N / POINTS steps
+    is_bitrevA = ((step & ((N / POINTS) - 1)) == 0) ? !is_bitrevA : is_bitrevA;
+
+    float2xp data_rev = bitreverse_points(data,
+      is_bitrevA ? bitrev[0] : bitrev[1],
+      is_bitrevA ? bitrev[1] : bitrev[0],
+      step);
+    if (natural)
+      data = data_rev;
+#endif
 
     /* Store data back to memory. FFT engine outputs are delayed by 
-     * N / 8 - 1 steps, hence gate writes accordingly
+     * N / POINTS - 1 steps and the reorder by N / POINTS more, hence gate
+     * writes accordingly
      */
 
-    if (i >= N / 8 - 1) {
-      int base = 8 * (i - (N / 8 - 1));
- 
-      // These consecutive accesses will be coalesced by the compiler
-      dest[base] = data.i0;
-      dest[base + 1] = data.i1;
-      dest[base + 2] = data.i2;
-      dest[base + 3] = data.i3;
-      dest[base + 4] = data.i4;
-      dest[base + 5] = data.i5;
-      dest[base + 6] = data.i6;
-      dest[base + 7] = data.i7;
+    if (step >= REORDER_DELAY) {
+      uint where = POINTS * (step - REORDER_DELAY);
+      uint start = line_start(where >> LOGN, inner, inner_dist, outer_dist);
+      uint pos = where & (N - 1);
+
+      // These consecutive accesses will be coalesced by the compiler for a stride of 1 in the order stored
+      #pragma unroll
+      for (uint k = 0; k < POINTS; k++) {
+#if ONCHIP_BITREV
+        uint p = pos + k;
+#else
+        uint p = natural ? bit_reversed(pos + k, LOGN) : pos + k;
+#endif
+        dest[start + p * stride] = fft_store(data.i[k], start + p * stride);
+      }
     }
   }
 }
@@ -2,6 +2,7 @@
 
 #include "fft_config.h"
 #include "../common/fft_8.cl" 
+#include "../common/fft_callbacks.cl"
 #include "../matrixTranspose/diagonal_bitrev.cl"
 
 #pragma OPENCL EXTENSION cl_intel_channels : enable
@@ -24,14 +25,14 @@ kernel void fetchBitrev(global volatile float2 * restrict src, int how_many) {
 
     float2x8 data;
     if (step < (how_many * DEPTH)) {
-      data.i0 = src[where + 0];
-      data.i1 = src[where + 1];
-      data.i2 = src[where + 2];
-      data.i3 = src[where + 3];
-      data.i4 = src[where + 4];
-      data.i5 = src[where + 5];
-      data.i6 = src[where + 6];
-      data.i7 = src[where + 7];
+      data.i0 = fft_load(src[where + 0], where + 0);
+      data.i1 = fft_load(src[where + 1], where + 1);
+      data.i2 = fft_load(src[where + 2], where + 2);
+      data.i3 = fft_load(src[where + 3], where + 3);
+      data.i4 = fft_load(src[where + 4], where + 4);
+      data.i5 = fft_load(src[where + 5], where + 5);
+      data.i6 = fft_load(src[where + 6], where + 6);
+      data.i7 = fft_load(src[where + 7], where + 7);
     } else {
       data.i0 = data.i1 = data.i2 = data.i3 = 
                 data.i4 = data.i5 = data.i6 = data.i7 = 0;
@@ -187,7 +188,7 @@ kernel void fft2db(int inverse, int how_many) {
   float2 fft_delay_elements[N + POINTS * (LOGN - 2)];
 
   #pragma loop_coalesce
-  for(unsigned j = 0; j < 1; j++){
+  for(unsigned j = 0; j < how_many; j++){
     for (unsigned i = 0; i < N * (N / POINTS) + N / POINTS - 1; i++) {
       float2x8 data;
 
@@ -274,14 +275,14 @@ kernel void transposeStore(global volatile float2 * restrict dest, int how_many)
     if (step >= (DEPTH)) {
       unsigned index = (step - DEPTH) * 8;
 
-      dest[index + 0] = data_out.i0;
-      dest[index + 1] = data_out.i1;
-      dest[index + 2] = data_out.i2;
-      dest[index + 3] = data_out.i3;
-      dest[index + 4] = data_out.i4;
-      dest[index + 5] = data_out.i5;
-      dest[index + 6] = data_out.i6;
-      dest[index + 7] = data_out.i7;
+      dest[index + 0] = fft_store(data_out.i0, index + 0);
+      dest[index + 1] = fft_store(data_out.i1, index + 1);
+      dest[index + 2] = fft_store(data_out.i2, index + 2);
+      dest[index + 3] = fft_store(data_out.i3, index + 3);
+      dest[index + 4] = fft_store(data_out.i4, index + 4);
+      dest[index + 5] = fft_store(data_out.i5, index + 5);
+      dest[index + 6] = fft_store(data_out.i6, index + 6);
+      dest[index + 7] = fft_store(data_out.i7, index + 7);
     }
   }
 }
\ No newline at end of file
@@ -1,25 +1,189 @@
 // Author: Arjun Ramaswami
 
+/**
+ * 3D FFT using the DDR of the FPGA for the 3D Transpose. The bitstream with
+ * replicated pipelines, fft3d_ddr_multi.cl, includes this file once for each
+ * pipeline with PIPE set to its index, which suffixes the names of the
+ * kernels and channels of the pipeline. Defining FFT3D_AUTORUN, as
+ * fft3d_ddr_autorun.cl does, makes the stages between the fetch and the
+ * transpose3D_wr, transpose3D_rd and store kernels autorun kernels, so that
+ * the host launches only these four kernels for each transform. Defining
+ * FFT3D_HYBRID, as fft3d_ddr_hybrid.cl does, replaces the write and read of
+ * the 3D Transpose by a single kernel keeping part of the transform in BRAM.
+ * Defining FFT3D_STRIPED, as fft3d_ddr_striped.cl does, stripes the buffer of
+ * the 3D Transpose across the DDR banks, one buffer argument per bank.
+ */
+
+#ifndef FFT3D_DDR_COMMON
+#define FFT3D_DDR_COMMON
+
 #include "fft_config.h"
 #include "../common/fft_8.cl" 
+#include "../common/fft_callbacks.cl"
 #include "../matrixTranspose/diagonal_bitrev.cl"
+#include "../matrixTranspose/transpose3d_layout.cl"
 
 #pragma OPENCL EXTENSION cl_intel_channels : enable
 
-channel float2 chaninfft3da[POINTS]; 
-channel float2 chaninfft3db[POINTS];
-channel float2 chaninfft3dc[POINTS];
+#define PIPE_CAT2(name, index) name##index
+#define PIPE_CAT(name, index) PIPE_CAT2(name, index)
+#ifdef PIPE
+#define PIPE_NAME(name) PIPE_CAT(name, PIPE)
+#else
+#define PIPE_NAME(name) name
+#endif
+
+// Order of the points in global memory, see the unordered mode of the transforms
+#define ORDER_NATURAL 0     // natural order input and output
+#define ORDER_BITREV_OUT 1  // forward transform writing the frequencies bit-reversed along each dimension
+#define ORDER_BITREV_IN 2   // backward transform reading the frequencies bit-reversed along each dimension
+
+// Control word preceding each transform through the autorun stages
+#define CTRL_WORD(inverse, order) (((order) << 1) | ((inverse) & 1))
+#define CTRL_INVERSE(ctrl) ((ctrl) & 1)
+#define CTRL_ORDER(ctrl) ((ctrl) >> 1)
+
+// Rows along y of the xz-slabs kept in BRAM by the hybrid 3D Transpose, as
+// many as fit into 2^LOG_TRANSPOSE3D_BRAM points, the whole transform if it
+// fits
+#ifdef FFT3D_HYBRID
+#if (LOG_TRANSPOSE3D_BRAM - LOGN - LOGN) >= LOGN
+#define TRANSPOSE3D_BRAM_ROWS N
+#elif (LOG_TRANSPOSE3D_BRAM - LOGN - LOGN) >= 0
+#define TRANSPOSE3D_BRAM_ROWS (1 << (LOG_TRANSPOSE3D_BRAM - LOGN - LOGN))
+#else
+#error "LOG_TRANSPOSE3D_BRAM too small for a row of the xz-slabs of the hybrid 3D Transpose"
+#endif
+#endif
+
+// Planes along z per block of the tiled layout of the 3D Transpose, see
+// transpose3d_layout.cl. The hybrid 3D Transpose uses the layout [z][y][x].
+#if defined(FFT3D_HYBRID) || !defined(LOG_TRANSPOSE3D_TILE)
+#define TRANSPOSE3D_LOG_TILE 0
+#else
+#define TRANSPOSE3D_LOG_TILE LOG_TRANSPOSE3D_TILE
+#endif
+#define TRANSPOSE3D_TILE (1 << TRANSPOSE3D_LOG_TILE)
+
+#define DDR_GLOBAL __global __attribute__((buffer_location(DDR_BUFFER_LOCATION))) float2 * restrict
+
+// Buffer of the 3D Transpose, striped across the four DDR banks of the board
+// by blocks of the layout, see transpose3d_layout.cl
+#ifdef FFT3D_STRIPED
+#ifdef FFT3D_HYBRID
+#error "The hybrid 3D Transpose is not striped"
+#endif
+#define TRANSPOSE3D_LOG_BANKS 2
+#define TRANSPOSE3D_LOG_STRIPE (LOGN + LOGN + TRANSPOSE3D_LOG_TILE)
+#if (LOGN - TRANSPOSE3D_LOG_TILE) < TRANSPOSE3D_LOG_BANKS
+#error "Fewer blocks of the 3D Transpose layout than DDR banks to stripe them across"
+#endif
+#define TRANSPOSE3D_PARAMS(buf) DDR_GLOBAL buf##0, DDR_GLOBAL buf##1, DDR_GLOBAL buf##2, DDR_GLOBAL buf##3
+#define TRANSPOSE3D_ARGS(buf) buf##0, buf##1, buf##2, buf##3
+#else
+#define TRANSPOSE3D_PARAMS(buf) DDR_GLOBAL buf
+#define TRANSPOSE3D_ARGS(buf) buf
+#endif
+
+// Write of the 8 points of the 3D Transpose from 'index' of one buffer
+void transpose3D_store_buf(DDR_GLOBAL dest, unsigned index, float2x8 data) {
+  dest[index + 0] = data.i0;
+  dest[index + 1] = data.i1;
+  dest[index + 2] = data.i2;
+  dest[index + 3] = data.i3;
+  dest[index + 4] = data.i4;
+  dest[index + 5] = data.i5;
+  dest[index + 6] = data.i6;
+  dest[index + 7] = data.i7;
+}
+
+// Read of the 8 points of the 3D Transpose from 'index' of one buffer
+float2x8 transpose3D_load_buf(DDR_GLOBAL src, unsigned index) {
+  float2x8 data;
+  data.i0 = src[index + 0];
+  data.i1 = src[index + 1];
+  data.i2 = src[index + 2];
+  data.i3 = src[index + 3];
+  data.i4 = src[index + 4];
+  data.i5 = src[index + 5];
+  data.i6 = src[index + 6];
+  data.i7 = src[index + 7];
+  return data;
+}
 
-channel float2 chaninTranspose[POINTS];
-channel float2 chaninTranspose3D[POINTS];
-channel float2 chaninStore[POINTS];
+// Write of the 8 points from 'index' of the 3D Transpose, to the bank of
+// their block if striped. Each bank has its own store units.
+void transpose3D_store(TRANSPOSE3D_PARAMS(dest), unsigned index, float2x8 data) {
+#ifdef FFT3D_STRIPED
+  unsigned bank = transpose3d_bank(index, TRANSPOSE3D_LOG_STRIPE, TRANSPOSE3D_LOG_BANKS);
+  unsigned offset = transpose3d_offset(index, TRANSPOSE3D_LOG_STRIPE, TRANSPOSE3D_LOG_BANKS);
+  if (bank == 0)
+    transpose3D_store_buf(dest0, offset, data);
+  else if (bank == 1)
+    transpose3D_store_buf(dest1, offset, data);
+  else if (bank == 2)
+    transpose3D_store_buf(dest2, offset, data);
+  else
+    transpose3D_store_buf(dest3, offset, data);
+#else
+  transpose3D_store_buf(dest, index, data);
+#endif
+}
+
+// Read of the 8 points from 'index' of the 3D Transpose, from the bank of
+// their block if striped
+float2x8 transpose3D_load(TRANSPOSE3D_PARAMS(src), unsigned index) {
+#ifdef FFT3D_STRIPED
+  unsigned bank = transpose3d_bank(index, TRANSPOSE3D_LOG_STRIPE, TRANSPOSE3D_LOG_BANKS);
+  unsigned offset = transpose3d_offset(index, TRANSPOSE3D_LOG_STRIPE, TRANSPOSE3D_LOG_BANKS);
+  if (bank == 0)
+    return transpose3D_load_buf(src0, offset);
+  else if (bank == 1)
+    return transpose3D_load_buf(src1, offset);
+  else if (bank == 2)
+    return transpose3D_load_buf(src2, offset);
+  else
+    return transpose3D_load_buf(src3, offset);
+#else
+  return transpose3D_load_buf(src, index);
+#endif
+}
 
-#define WR_GLOBALMEM 0
-#define RD_GLOBALMEM 1
-#define BATCH 2
+#endif // FFT3D_DDR_COMMON
+
+channel float2 PIPE_NAME(chaninfft3da)[POINTS]; 
+channel float2 PIPE_NAME(chaninfft3db)[POINTS];
+channel float2 PIPE_NAME(chaninfft3dc)[POINTS];
+
+channel float2 PIPE_NAME(chaninTranspose)[POINTS];
+channel float2 PIPE_NAME(chaninTranspose3D)[POINTS];
+channel float2 PIPE_NAME(chaninStore)[POINTS];
+
+#ifdef FFT3D_AUTORUN
+// Direction and order of the transforms forwarded along the autorun stages
+channel int PIPE_NAME(chanctrlfft3da) __attribute__((depth(4)));
+channel int PIPE_NAME(chanctrlTranspose) __attribute__((depth(4)));
+channel int PIPE_NAME(chanctrlfft3db) __attribute__((depth(4)));
+channel int PIPE_NAME(chanctrlfft3dc) __attribute__((depth(4)));
+#endif
+
+// Kernel that fetches data from global memory. Only the non-zero sub-box of
+// the input of size box_* starting at origin_*, wrapping around periodically,
+// is read from src, where it is packed in the layout [z][y][x]. The other
+// points are zero. box_x and origin_x are multiples of POINTS. With autorun
+// stages, the fetch kernel also takes the direction of the transform and
+// passes it on to them.
+kernel void PIPE_NAME(fetch)(__global __attribute__((buffer_location(SVM_HOST_BUFFER_LOCATION))) volatile float2 * restrict src, const int order,
+  const unsigned box_x, const unsigned box_y, const unsigned box_z,
+  const unsigned origin_x, const unsigned origin_y, const unsigned origin_z
+#ifdef FFT3D_AUTORUN
+  , const int inverse
+#endif
+  ) {
+#ifdef FFT3D_AUTORUN
+  write_channel_intel(PIPE_NAME(chanctrlfft3da), CTRL_WORD(inverse, order));
+#endif
 
-// Kernel that fetches data from global memory 
-kernel void fetch(__global __attribute__((buffer_location(SVM_HOST_BUFFER_LOCATION))) volatile float2 * restrict src) {
   unsigned delay = (1 << (LOGN - LOGPOINTS)); // N / 8
   bool is_bitrevA = false;
 
@@ -30,16 +194,38 @@ kernel void fetch(__global __attribute__((buffer_location(SVM_HOST_BUFFER_LOCATI
 
     unsigned where = (step & ((N * DEPTH) - 1)) * 8; 
 
+    // position in the sub-box
+    unsigned x = ((where & (N - 1)) - origin_x) & (N - 1);
+    unsigned y = (((where >> LOGN) & (N - 1)) - origin_y) & (N - 1);
+    unsigned z = ((where >> (LOGN + LOGN)) - origin_z) & (N - 1);
+    bool in_box = (x < box_x) && (y < box_y) && (z < box_z);
+    unsigned from = (z * box_y + y) * box_x + x;
+
     float2x8 data;
     if (step < (N * DEPTH)) {
-      data.i0 = src[where + 0];
-      data.i1 = src[where + 1];
-      data.i2 = src[where + 2];
-      data.i3 = src[where + 3];
-      data.i4 = src[where + 4];
-      data.i5 = src[where + 5];
-      data.i6 = src[where + 6];
-      data.i7 = src[where + 7];
+      // points outside of the sub-box are not read from global memory
+      float2x8 pts;
+      pts.i0 = pts.i1 = pts.i2 = pts.i3 = 
+               pts.i4 = pts.i5 = pts.i6 = pts.i7 = 0;
+      if (in_box) {
+        pts.i0 = src[from + 0];
+        pts.i1 = src[from + 1];
+        pts.i2 = src[from + 2];
+        pts.i3 = src[from + 3];
+        pts.i4 = src[from + 4];
+        pts.i5 = src[from + 5];
+        pts.i6 = src[from + 6];
+        pts.i7 = src[from + 7];
+      }
+
+      data.i0 = fft_load(pts.i0, where + 0);
+      data.i1 = fft_load(pts.i1, where + 1);
+      data.i2 = fft_load(pts.i2, where + 2);
+      data.i3 = fft_load(pts.i3, where + 3);
+      data.i4 = fft_load(pts.i4, where + 4);
+      data.i5 = fft_load(pts.i5, where + 5);
+      data.i6 = fft_load(pts.i6, where + 6);
+      data.i7 = fft_load(pts.i7, where + 7);
     } else {
       data.i0 = data.i1 = data.i2 = data.i3 = 
                 data.i4 = data.i5 = data.i6 = data.i7 = 0;
@@ -48,25 +234,26 @@ kernel void fetch(__global __attribute__((buffer_location(SVM_HOST_BUFFER_LOCATI
     is_bitrevA = ( (step & ((N / 8) - 1)) == 0) ? !is_bitrevA: is_bitrevA;
 
     unsigned row = step & (DEPTH - 1);
-    data = bitreverse_fetch(data,
+    data = bitreverse_fetch_order(data,
       is_bitrevA ? buf[0] : buf[1], 
       is_bitrevA ? buf[1] : buf[0], 
-      row);
+      row, order == ORDER_BITREV_IN);
 
     if (step >= delay) {
-      write_channel_intel(chaninfft3da[0], data.i0);
-      write_channel_intel(chaninfft3da[1], data.i1);
-      write_channel_intel(chaninfft3da[2], data.i2);
-      write_channel_intel(chaninfft3da[3], data.i3);
-      write_channel_intel(chaninfft3da[4], data.i4);
-      write_channel_intel(chaninfft3da[5], data.i5);
-      write_channel_intel(chaninfft3da[6], data.i6);
-      write_channel_intel(chaninfft3da[7], data.i7);
+      write_channel_intel(PIPE_NAME(chaninfft3da)[0], data.i0);
+      write_channel_intel(PIPE_NAME(chaninfft3da)[1], data.i1);
+      write_channel_intel(PIPE_NAME(chaninfft3da)[2], data.i2);
+      write_channel_intel(PIPE_NAME(chaninfft3da)[3], data.i3);
+      write_channel_intel(PIPE_NAME(chaninfft3da)[4], data.i4);
+      write_channel_intel(PIPE_NAME(chaninfft3da)[5], data.i5);
+      write_channel_intel(PIPE_NAME(chaninfft3da)[6], data.i6);
+      write_channel_intel(PIPE_NAME(chaninfft3da)[7], data.i7);
     }
   }
 }
 
-kernel void fft3da(int inverse) {
+// Stage of the fft3da kernel, computing one transform
+void PIPE_NAME(fft3da_stage)(int inverse) {
 
   /* The FFT engine requires a sliding window for data reordering; data stored
    * in this array is carried across loop iterations and shifted by 1 element
@@ -82,14 +269,14 @@ kernel void fft3da(int inverse) {
       float2x8 data;
 
       if (i < N * (N / POINTS)) {
-        data.i0 = read_channel_intel(chaninfft3da[0]);
-        data.i1 = read_channel_intel(chaninfft3da[1]);
-        data.i2 = read_channel_intel(chaninfft3da[2]);
-        data.i3 = read_channel_intel(chaninfft3da[3]);
-        data.i4 = read_channel_intel(chaninfft3da[4]);
-        data.i5 = read_channel_intel(chaninfft3da[5]);
-        data.i6 = read_channel_intel(chaninfft3da[6]);
-        data.i7 = read_channel_intel(chaninfft3da[7]);
+        data.i0 = read_channel_intel(PIPE_NAME(chaninfft3da)[0]);
+        data.i1 = read_channel_intel(PIPE_NAME(chaninfft3da)[1]);
+        data.i2 = read_channel_intel(PIPE_NAME(chaninfft3da)[2]);
+        data.i3 = read_channel_intel(PIPE_NAME(chaninfft3da)[3]);
+        data.i4 = read_channel_intel(PIPE_NAME(chaninfft3da)[4]);
+        data.i5 = read_channel_intel(PIPE_NAME(chaninfft3da)[5]);
+        data.i6 = read_channel_intel(PIPE_NAME(chaninfft3da)[6]);
+        data.i7 = read_channel_intel(PIPE_NAME(chaninfft3da)[7]);
       } 
       else {
         data.i0 = data.i1 = data.i2 = data.i3 = 
@@ -100,20 +287,21 @@ kernel void fft3da(int inverse) {
 
       // Write result to channels
       if (i >= N / POINTS - 1) {
-        write_channel_intel(chaninTranspose[0], data.i0);
-        write_channel_intel(chaninTranspose[1], data.i1);
-        write_channel_intel(chaninTranspose[2], data.i2);
-        write_channel_intel(chaninTranspose[3], data.i3);
-        write_channel_intel(chaninTranspose[4], data.i4);
-        write_channel_intel(chaninTranspose[5], data.i5);
-        write_channel_intel(chaninTranspose[6], data.i6);
-        write_channel_intel(chaninTranspose[7], data.i7);
+        write_channel_intel(PIPE_NAME(chaninTranspose)[0], data.i0);
+        write_channel_intel(PIPE_NAME(chaninTranspose)[1], data.i1);
+        write_channel_intel(PIPE_NAME(chaninTranspose)[2], data.i2);
+        write_channel_intel(PIPE_NAME(chaninTranspose)[3], data.i3);
+        write_channel_intel(PIPE_NAME(chaninTranspose)[4], data.i4);
+        write_channel_intel(PIPE_NAME(chaninTranspose)[5], data.i5);
+        write_channel_intel(PIPE_NAME(chaninTranspose)[6], data.i6);
+        write_channel_intel(PIPE_NAME(chaninTranspose)[7], data.i7);
       }
     }
   }
 }
 
-kernel void transpose() {
+// Stage of the transpose kernel, computing one transform
+void PIPE_NAME(transpose_stage)(const int order) {
   const int DELAY = (1 << (LOGN - LOGPOINTS)); // N / 8
   bool is_bufA = false, is_bitrevA = false;
 
@@ -130,14 +318,14 @@ kernel void transpose() {
 
     float2x8 data, data_out;
     if (step < ((N * DEPTH) - initial_delay)) {
-      data.i0 = read_channel_intel(chaninTranspose[0]);
-      data.i1 = read_channel_intel(chaninTranspose[1]);
-      data.i2 = read_channel_intel(chaninTranspose[2]);
-      data.i3 = read_channel_intel(chaninTranspose[3]);
-      data.i4 = read_channel_intel(chaninTranspose[4]);
-      data.i5 = read_channel_intel(chaninTranspose[5]);
-      data.i6 = read_channel_intel(chaninTranspose[6]);
-      data.i7 = read_channel_intel(chaninTranspose[7]);
+      data.i0 = read_channel_intel(PIPE_NAME(chaninTranspose)[0]);
+      data.i1 = read_channel_intel(PIPE_NAME(chaninTranspose)[1]);
+      data.i2 = read_channel_intel(PIPE_NAME(chaninTranspose)[2]);
+      data.i3 = read_channel_intel(PIPE_NAME(chaninTranspose)[3]);
+      data.i4 = read_channel_intel(PIPE_NAME(chaninTranspose)[4]);
+      data.i5 = read_channel_intel(PIPE_NAME(chaninTranspose)[5]);
+      data.i6 = read_channel_intel(PIPE_NAME(chaninTranspose)[6]);
+      data.i7 = read_channel_intel(PIPE_NAME(chaninTranspose)[7]);
     } else {
       data.i0 = data.i1 = data.i2 = data.i3 = 
                 data.i4 = data.i5 = data.i6 = data.i7 = 0;
@@ -151,10 +339,10 @@ kernel void transpose() {
     is_bitrevA = ( (step & ((N / 8) - 1)) == 0) ? !is_bitrevA: is_bitrevA;
 
     unsigned row = step & (DEPTH - 1);
-    data = bitreverse_in(data,
+    data = bitreverse_in_order(data,
       is_bitrevA ? bitrev_in[0] : bitrev_in[1], 
       is_bitrevA ? bitrev_in[1] : bitrev_in[0], 
-      row);
+      row, order != ORDER_BITREV_OUT);
 
     writeBuf(data,
       is_bufA ? buf[0] : buf[1],
@@ -165,26 +353,27 @@ kernel void transpose() {
       step);
 
     unsigned start_row = (step + DELAY) & (DEPTH -1);
-    data_out = bitreverse_out(
+    data_out = bitreverse_out_order(
       is_bitrevA ? bitrev_out[0] : bitrev_out[1],
       is_bitrevA ? bitrev_out[1] : bitrev_out[0],
-      data_out, start_row);
+      data_out, start_row, order == ORDER_BITREV_IN);
 
 
     if (step >= (DEPTH)) {
-      write_channel_intel(chaninfft3db[0], data_out.i0);
-      write_channel_intel(chaninfft3db[1], data_out.i1);
-      write_channel_intel(chaninfft3db[2], data_out.i2);
-      write_channel_intel(chaninfft3db[3], data_out.i3);
-      write_channel_intel(chaninfft3db[4], data_out.i4);
-      write_channel_intel(chaninfft3db[5], data_out.i5);
-      write_channel_intel(chaninfft3db[6], data_out.i6);
-      write_channel_intel(chaninfft3db[7], data_out.i7);
+      write_channel_intel(PIPE_NAME(chaninfft3db)[0], data_out.i0);
+      write_channel_intel(PIPE_NAME(chaninfft3db)[1], data_out.i1);
+      write_channel_intel(PIPE_NAME(chaninfft3db)[2], data_out.i2);
+      write_channel_intel(PIPE_NAME(chaninfft3db)[3], data_out.i3);
+      write_channel_intel(PIPE_NAME(chaninfft3db)[4], data_out.i4);
+      write_channel_intel(PIPE_NAME(chaninfft3db)[5], data_out.i5);
+      write_channel_intel(PIPE_NAME(chaninfft3db)[6], data_out.i6);
+      write_channel_intel(PIPE_NAME(chaninfft3db)[7], data_out.i7);
     }
   }
 }
 
-kernel void fft3db(int inverse) {
+// Stage of the fft3db kernel, computing one transform
+void PIPE_NAME(fft3db_stage)(int inverse) {
 
   /* The FFT engine requires a sliding window for data reordering; data stored
    * in this array is carried across loop iterations and shifted by 1 element
@@ -200,14 +389,14 @@ kernel void fft3db(int inverse) {
       float2x8 data;
 
       if (i < N * (N / POINTS)) {
-        data.i0 = read_channel_intel(chaninfft3db[0]);
-        data.i1 = read_channel_intel(chaninfft3db[1]);
-        data.i2 = read_channel_intel(chaninfft3db[2]);
-        data.i3 = read_channel_intel(chaninfft3db[3]);
-        data.i4 = read_channel_intel(chaninfft3db[4]);
-        data.i5 = read_channel_intel(chaninfft3db[5]);
-        data.i6 = read_channel_intel(chaninfft3db[6]);
-        data.i7 = read_channel_intel(chaninfft3db[7]);
+        data.i0 = read_channel_intel(PIPE_NAME(chaninfft3db)[0]);
+        data.i1 = read_channel_intel(PIPE_NAME(chaninfft3db)[1]);
+        data.i2 = read_channel_intel(PIPE_NAME(chaninfft3db)[2]);
+        data.i3 = read_channel_intel(PIPE_NAME(chaninfft3db)[3]);
+        data.i4 = read_channel_intel(PIPE_NAME(chaninfft3db)[4]);
+        data.i5 = read_channel_intel(PIPE_NAME(chaninfft3db)[5]);
+        data.i6 = read_channel_intel(PIPE_NAME(chaninfft3db)[6]);
+        data.i7 = read_channel_intel(PIPE_NAME(chaninfft3db)[7]);
       } else {
         data.i0 = data.i1 = data.i2 = data.i3 = 
                   data.i4 = data.i5 = data.i6 = data.i7 = 0;
@@ -216,158 +405,278 @@ kernel void fft3db(int inverse) {
       data = fft_step(data, i % (N / POINTS), fft_delay_elements, inverse, LOGN);
 
       if (i >= N / POINTS - 1) {
-        write_channel_intel(chaninTranspose3D[0], data.i0);
-        write_channel_intel(chaninTranspose3D[1], data.i1);
-        write_channel_intel(chaninTranspose3D[2], data.i2);
-        write_channel_intel(chaninTranspose3D[3], data.i3);
-        write_channel_intel(chaninTranspose3D[4], data.i4);
-        write_channel_intel(chaninTranspose3D[5], data.i5);
-        write_channel_intel(chaninTranspose3D[6], data.i6);
-        write_channel_intel(chaninTranspose3D[7], data.i7);
+        write_channel_intel(PIPE_NAME(chaninTranspose3D)[0], data.i0);
+        write_channel_intel(PIPE_NAME(chaninTranspose3D)[1], data.i1);
+        write_channel_intel(PIPE_NAME(chaninTranspose3D)[2], data.i2);
+        write_channel_intel(PIPE_NAME(chaninTranspose3D)[3], data.i3);
+        write_channel_intel(PIPE_NAME(chaninTranspose3D)[4], data.i4);
+        write_channel_intel(PIPE_NAME(chaninTranspose3D)[5], data.i5);
+        write_channel_intel(PIPE_NAME(chaninTranspose3D)[6], data.i6);
+        write_channel_intel(PIPE_NAME(chaninTranspose3D)[7], data.i7);
       }
     }
   }
 }
 
-kernel void transpose3D(
-  __global __attribute__((buffer_location(DDR_BUFFER_LOCATION))) float2 * restrict src, 
-  __global __attribute__((buffer_location(DDR_BUFFER_LOCATION))) float2 * restrict dest, 
-  const int mode) {
+// Stage of the write of the 3D Transpose to the DDR. With the hybrid
+// transpose, the rows along y below TRANSPOSE3D_BRAM_ROWS are kept in
+// bram_rows, in the order [y][z][x] in which they are read, instead.
+void PIPE_NAME(transpose3D_wr_stage)(
+  TRANSPOSE3D_PARAMS(dest), 
+  const int order
+#ifdef FFT3D_HYBRID
+  , float2 bram_rows[][POINTS]
+#endif
+  ) {
 
   const int initial_delay = (1 << (LOGN - LOGPOINTS)); // N / 8 for the bitrev buffers
   bool is_bufA = false, is_bitrevA = false;
-  bool is_bufB = false, is_bitrevB = false;
 
   float2 buf_wr[2][DEPTH][POINTS];
-  float2 buf_rd[2][DEPTH][POINTS];
 
   //float2 __attribute__((memory, numbanks(8))) bitrev_in[2][N];
   float2 bitrev_in[2][N];
-  float2 __attribute__((memory, numbanks(8))) bitrev_out[2][N];
+
+#if TRANSPOSE3D_LOG_TILE > 0
+  // blocks of planes reordered to the tiled layout before their write
+  float2 buf_tile[2][TRANSPOSE3D_TILE * DEPTH][POINTS];
+  bool is_tileA = false;
+  const int tile_delay = TRANSPOSE3D_TILE * DEPTH;
+#else
+  const int tile_delay = 0;
+#endif
 
   // additional iterations to fill the buffers
-  for(int step = -initial_delay; step < ((N * DEPTH) + DEPTH); step++){
+  for(int step = -initial_delay; step < ((N * DEPTH) + DEPTH + tile_delay); step++){
 
     float2x8 data, data_out;
-    float2x8 data_wr, data_wr_out;
-    if(mode == WR_GLOBALMEM || mode == BATCH){
-      if (step < ((N * DEPTH) - initial_delay)) {
-        data.i0 = read_channel_intel(chaninTranspose3D[0]);
-        data.i1 = read_channel_intel(chaninTranspose3D[1]);
-        data.i2 = read_channel_intel(chaninTranspose3D[2]);
-        data.i3 = read_channel_intel(chaninTranspose3D[3]);
-        data.i4 = read_channel_intel(chaninTranspose3D[4]);
-        data.i5 = read_channel_intel(chaninTranspose3D[5]);
-        data.i6 = read_channel_intel(chaninTranspose3D[6]);
-        data.i7 = read_channel_intel(chaninTranspose3D[7]);
-      } else {
-        data.i0 = data.i1 = data.i2 = data.i3 = 
-                  data.i4 = data.i5 = data.i6 = data.i7 = 0;
-      }
+    if (step < ((N * DEPTH) - initial_delay)) {
+      data.i0 = read_channel_intel(PIPE_NAME(chaninTranspose3D)[0]);
+      data.i1 = read_channel_intel(PIPE_NAME(chaninTranspose3D)[1]);
+      data.i2 = read_channel_intel(PIPE_NAME(chaninTranspose3D)[2]);
+      data.i3 = read_channel_intel(PIPE_NAME(chaninTranspose3D)[3]);
+      data.i4 = read_channel_intel(PIPE_NAME(chaninTranspose3D)[4]);
+      data.i5 = read_channel_intel(PIPE_NAME(chaninTranspose3D)[5]);
+      data.i6 = read_channel_intel(PIPE_NAME(chaninTranspose3D)[6]);
+      data.i7 = read_channel_intel(PIPE_NAME(chaninTranspose3D)[7]);
+    } else {
+      data.i0 = data.i1 = data.i2 = data.i3 = 
+                data.i4 = data.i5 = data.i6 = data.i7 = 0;
+    }
 
-      // Swap buffers every N*N/8 iterations 
-      // starting from the additional delay of N/8 iterations
-      is_bufA = (( step & (DEPTH - 1)) == 0) ? !is_bufA: is_bufA;
-
-      // Swap bitrev buffers every N/8 iterations
-      is_bitrevA = ( (step & ((N / 8) - 1)) == 0) ? !is_bitrevA: is_bitrevA;
-
-      unsigned row = step & (DEPTH - 1);
-      data = bitreverse_in(data,
-        is_bitrevA ? bitrev_in[0] : bitrev_in[1], 
-        is_bitrevA ? bitrev_in[1] : bitrev_in[0], 
-        row);
-
-      writeBuf(data,
-        is_bufA ? buf_wr[0] : buf_wr[1],
-        step, 0);
-
-      data_out = readBuf_store(
-        is_bufA ? buf_wr[1] : buf_wr[0], 
-        step);
-
-      if (step >= (DEPTH)) {
-        unsigned index = (step - DEPTH) * 8;
-
-        dest[index + 0] = data_out.i0;
-        dest[index + 1] = data_out.i1;
-        dest[index + 2] = data_out.i2;
-        dest[index + 3] = data_out.i3;
-        dest[index + 4] = data_out.i4;
-        dest[index + 5] = data_out.i5;
-        dest[index + 6] = data_out.i6;
-        dest[index + 7] = data_out.i7;
-      }
-    } // condition for writing to global memory
-    if(mode == RD_GLOBALMEM || mode == BATCH){
+    // Swap buffers every N*N/8 iterations 
+    // starting from the additional delay of N/8 iterations
+    is_bufA = (( step & (DEPTH - 1)) == 0) ? !is_bufA: is_bufA;
 
-      unsigned step_rd = step + initial_delay;
-      // increment z by 1 every N/8 steps until (N*N/ 8)
-      unsigned start_index = step_rd + initial_delay;
-      unsigned zdim = (step_rd >> (LOGN - LOGPOINTS)) & (N - 1); 
+    // Swap bitrev buffers every N/8 iterations
+    is_bitrevA = ( (step & ((N / 8) - 1)) == 0) ? !is_bitrevA: is_bitrevA;
 
-      // increment y by 1 every N*N/8 points until N
-      unsigned ydim = (step_rd >> (LOGN + LOGN - LOGPOINTS)) & (N - 1);
+    unsigned row = step & (DEPTH - 1);
+    data = bitreverse_in_order(data,
+      is_bitrevA ? bitrev_in[0] : bitrev_in[1], 
+      is_bitrevA ? bitrev_in[1] : bitrev_in[0], 
+      row, order != ORDER_BITREV_OUT);
+
+    writeBuf(data,
+      is_bufA ? buf_wr[0] : buf_wr[1],
+      step, 0);
 
-      // increment by 8 until N / 8
-      unsigned xdim = (step_rd * 8) & (N - 1);
+    data_out = readBuf_store(
+      is_bufA ? buf_wr[1] : buf_wr[0], 
+      step);
 
-      // increment by 1 every N*N*N / 8 steps
-      unsigned batch_index = (step_rd >> (LOGN + LOGN + LOGN - LOGPOINTS));
-
-      unsigned index_wr = (batch_index * N * N * N) + (zdim * N * N) + (ydim * N) + xdim; 
-
-      //float2x8 data, data_out;
-      if (step < ((N * DEPTH)  - initial_delay)) {
-        data_wr.i0 = src[index_wr + 0];
-        data_wr.i1 = src[index_wr + 1];
-        data_wr.i2 = src[index_wr + 2];
-        data_wr.i3 = src[index_wr + 3];
-        data_wr.i4 = src[index_wr + 4];
-        data_wr.i5 = src[index_wr + 5];
-        data_wr.i6 = src[index_wr + 6];
-        data_wr.i7 = src[index_wr + 7];
-      } else {
-        data_wr.i0 = data_wr.i1 = data_wr.i2 = data_wr.i3 = 
-                  data_wr.i4 = data_wr.i5 = data_wr.i6 = data_wr.i7 = 0;
+    if (step >= (DEPTH)) {
+      unsigned index = (step - DEPTH) * 8;
+
+#ifdef FFT3D_HYBRID
+      unsigned ydim = (index >> LOGN) & (N - 1);
+      if (ydim < TRANSPOSE3D_BRAM_ROWS) {
+        unsigned zdim = index >> (LOGN + LOGN);
+        unsigned row = (((ydim * N) + zdim) * N + (index & (N - 1))) >> LOGPOINTS;
+
+        bram_rows[row][0] = data_out.i0;
+        bram_rows[row][1] = data_out.i1;
+        bram_rows[row][2] = data_out.i2;
+        bram_rows[row][3] = data_out.i3;
+        bram_rows[row][4] = data_out.i4;
+        bram_rows[row][5] = data_out.i5;
+        bram_rows[row][6] = data_out.i6;
+        bram_rows[row][7] = data_out.i7;
       }
-    
-      is_bufB = (( step_rd & (DEPTH - 1)) == 0) ? !is_bufB: is_bufB;
-
-      // Swap bitrev buffers every N/8 iterations
-      is_bitrevB = ( (step_rd & ((N / 8) - 1)) == 0) ? !is_bitrevB: is_bitrevB;
-
-      writeBuf(data_wr,
-        is_bufB ? buf_rd[0] : buf_rd[1],
-        step_rd, 0);
-
-      data_wr_out = readBuf_fetch(
-        is_bufB ? buf_rd[1] : buf_rd[0], 
-        step_rd, 0);
-
-      unsigned start_row = step_rd & (DEPTH -1);
-      data_wr_out = bitreverse_out(
-        is_bitrevB ? bitrev_out[0] : bitrev_out[1],
-        is_bitrevB ? bitrev_out[1] : bitrev_out[0],
-        data_wr_out, start_row);
-
-      if (step_rd >= (DEPTH + initial_delay)) {
-
-        write_channel_intel(chaninfft3dc[0], data_wr_out.i0);
-        write_channel_intel(chaninfft3dc[1], data_wr_out.i1);
-        write_channel_intel(chaninfft3dc[2], data_wr_out.i2);
-        write_channel_intel(chaninfft3dc[3], data_wr_out.i3);
-        write_channel_intel(chaninfft3dc[4], data_wr_out.i4);
-        write_channel_intel(chaninfft3dc[5], data_wr_out.i5);
-        write_channel_intel(chaninfft3dc[6], data_wr_out.i6);
-        write_channel_intel(chaninfft3dc[7], data_wr_out.i7);
+      else
+#endif
+      {
+#if TRANSPOSE3D_LOG_TILE > 0
+        // the planes of a block are written to the tile in the order [y][z][x]
+        // and read out in sequence
+        unsigned tile_step = step - DEPTH;
+        is_tileA = ((tile_step & (TRANSPOSE3D_TILE * DEPTH - 1)) == 0) ? !is_tileA : is_tileA;
+
+        unsigned zlo = (index >> (LOGN + LOGN)) & (TRANSPOSE3D_TILE - 1);
+        unsigned ydim = (index >> LOGN) & (N - 1);
+        unsigned row = ((((ydim << TRANSPOSE3D_LOG_TILE) + zlo) << LOGN) + (index & (N - 1))) >> LOGPOINTS;
+
+        float2 (*tile_wr)[POINTS] = is_tileA ? buf_tile[0] : buf_tile[1];
+        tile_wr[row][0] = data_out.i0;
+        tile_wr[row][1] = data_out.i1;
+        tile_wr[row][2] = data_out.i2;
+        tile_wr[row][3] = data_out.i3;
+        tile_wr[row][4] = data_out.i4;
+        tile_wr[row][5] = data_out.i5;
+        tile_wr[row][6] = data_out.i6;
+        tile_wr[row][7] = data_out.i7;
+
+        float2 (*tile_rd)[POINTS] = is_tileA ? buf_tile[1] : buf_tile[0];
+        unsigned row_rd = tile_step & (TRANSPOSE3D_TILE * DEPTH - 1);
+        data_out.i0 = tile_rd[row_rd][0];
+        data_out.i1 = tile_rd[row_rd][1];
+        data_out.i2 = tile_rd[row_rd][2];
+        data_out.i3 = tile_rd[row_rd][3];
+        data_out.i4 = tile_rd[row_rd][4];
+        data_out.i5 = tile_rd[row_rd][5];
+        data_out.i6 = tile_rd[row_rd][6];
+        data_out.i7 = tile_rd[row_rd][7];
+
+        if (tile_step >= tile_delay) {
+          index = (tile_step - tile_delay) * 8;
+#else
+        {
+#endif
+          transpose3D_store(TRANSPOSE3D_ARGS(dest), index, data_out);
+        }
       }
+    }
+  }
+}
+
+// Stage of the read of the 3D Transpose from the DDR, once its write has
+// completed, or from bram_rows for the rows kept by the hybrid transpose
+void PIPE_NAME(transpose3D_rd_stage)(
+  TRANSPOSE3D_PARAMS(src), 
+  const int order
+#ifdef FFT3D_HYBRID
+  , float2 bram_rows[][POINTS]
+#endif
+  ) {
+
+  const int initial_delay = (1 << (LOGN - LOGPOINTS)); // N / 8 for the bitrev buffers
+  bool is_bufB = false, is_bitrevB = false;
 
-    } // condition for reading from global memory
+  float2 buf_rd[2][DEPTH][POINTS];
+  float2 __attribute__((memory, numbanks(8))) bitrev_out[2][N];
+
+  // additional iterations to fill the buffers
+  for(int step = -initial_delay; step < ((N * DEPTH) + DEPTH); step++){
+
+    float2x8 data_wr, data_wr_out;
+
+    unsigned step_rd = step + initial_delay;
+    // increment z by 1 every N/8 steps until (N*N/ 8)
+    unsigned zdim = (step_rd >> (LOGN - LOGPOINTS)) & (N - 1); 
+
+    // increment y by 1 every N*N/8 points until N
+    unsigned ydim = (step_rd >> (LOGN + LOGN - LOGPOINTS)) & (N - 1);
+
+    // increment by 8 until N / 8
+    unsigned xdim = (step_rd * 8) & (N - 1);
+
+    // increment by 1 every N*N*N / 8 steps
+    unsigned batch_index = (step_rd >> (LOGN + LOGN + LOGN - LOGPOINTS));
+
+    unsigned index_wr = (batch_index * N * N * N) + transpose3d_index(zdim, ydim, xdim, LOGN, TRANSPOSE3D_LOG_TILE); 
+
+#ifdef FFT3D_HYBRID
+    if ((step < ((N * DEPTH)  - initial_delay)) && (ydim < TRANSPOSE3D_BRAM_ROWS)) {
+      unsigned row = (((ydim * N) + zdim) * N + xdim) >> LOGPOINTS;
+
+      data_wr.i0 = bram_rows[row][0];
+      data_wr.i1 = bram_rows[row][1];
+      data_wr.i2 = bram_rows[row][2];
+      data_wr.i3 = bram_rows[row][3];
+      data_wr.i4 = bram_rows[row][4];
+      data_wr.i5 = bram_rows[row][5];
+      data_wr.i6 = bram_rows[row][6];
+      data_wr.i7 = bram_rows[row][7];
+    } else
+#endif
+    if (step < ((N * DEPTH)  - initial_delay)) {
+      data_wr = transpose3D_load(TRANSPOSE3D_ARGS(src), index_wr);
+    } else {
+      data_wr.i0 = data_wr.i1 = data_wr.i2 = data_wr.i3 = 
+                data_wr.i4 = data_wr.i5 = data_wr.i6 = data_wr.i7 = 0;
+    }
+  
+    is_bufB = (( step_rd & (DEPTH - 1)) == 0) ? !is_bufB: is_bufB;
+
+    // Swap bitrev buffers every N/8 iterations
+    is_bitrevB = ( (step_rd & ((N / 8) - 1)) == 0) ? !is_bitrevB: is_bitrevB;
+
+    writeBuf(data_wr,
+      is_bufB ? buf_rd[0] : buf_rd[1],
+      step_rd, 0);
+
+    data_wr_out = readBuf_fetch(
+      is_bufB ? buf_rd[1] : buf_rd[0], 
+      step_rd, 0);
+
+    unsigned start_row = step_rd & (DEPTH -1);
+    data_wr_out = bitreverse_out_order(
+      is_bitrevB ? bitrev_out[0] : bitrev_out[1],
+      is_bitrevB ? bitrev_out[1] : bitrev_out[0],
+      data_wr_out, start_row, order == ORDER_BITREV_IN);
+
+    if (step_rd >= (DEPTH + initial_delay)) {
+
+      write_channel_intel(PIPE_NAME(chaninfft3dc)[0], data_wr_out.i0);
+      write_channel_intel(PIPE_NAME(chaninfft3dc)[1], data_wr_out.i1);
+      write_channel_intel(PIPE_NAME(chaninfft3dc)[2], data_wr_out.i2);
+      write_channel_intel(PIPE_NAME(chaninfft3dc)[3], data_wr_out.i3);
+      write_channel_intel(PIPE_NAME(chaninfft3dc)[4], data_wr_out.i4);
+      write_channel_intel(PIPE_NAME(chaninfft3dc)[5], data_wr_out.i5);
+      write_channel_intel(PIPE_NAME(chaninfft3dc)[6], data_wr_out.i6);
+      write_channel_intel(PIPE_NAME(chaninfft3dc)[7], data_wr_out.i7);
+    }
   }
 }
 
-kernel void fft3dc(int inverse) {
+#ifdef FFT3D_HYBRID
+
+// Hybrid 3D Transpose, writing and reading the transform in a single launch.
+// The rows of every xz-slab below TRANSPOSE3D_BRAM_ROWS stay in BRAM, only the
+// others make the round trip through the DDR.
+kernel void PIPE_NAME(transpose3D_hybrid)(
+  DDR_GLOBAL buf, 
+  const int order) {
+
+  float2 __attribute__((memory, numbanks(8))) bram_rows[TRANSPOSE3D_BRAM_ROWS * DEPTH][POINTS];
+
+  PIPE_NAME(transpose3D_wr_stage)(buf, order, bram_rows);
+  PIPE_NAME(transpose3D_rd_stage)(buf, order, bram_rows);
+}
+
+#else
+
+// Write of the 3D Transpose to the DDR. The write and the read are separate
+// kernels, so that with two transpose buffers the write of a transform
+// overlaps the read of the previous one. Striped, the kernels take a buffer
+// per bank before the order.
+kernel void PIPE_NAME(transpose3D_wr)(
+  TRANSPOSE3D_PARAMS(dest), 
+  const int order) {
+  PIPE_NAME(transpose3D_wr_stage)(TRANSPOSE3D_ARGS(dest), order);
+}
+
+// Read of the 3D Transpose from the DDR, once its write has completed
+kernel void PIPE_NAME(transpose3D_rd)(
+  TRANSPOSE3D_PARAMS(src), 
+  const int order) {
+  PIPE_NAME(transpose3D_rd_stage)(TRANSPOSE3D_ARGS(src), order);
+}
+
+#endif
+
+// Stage of the fft3dc kernel, computing one transform
+void PIPE_NAME(fft3dc_stage)(int inverse) {
 
   /* The FFT engine requires a sliding window for data reordering; data stored
    * in this array is carried across loop iterations and shifted by 1 element
@@ -384,14 +693,14 @@ kernel void fft3dc(int inverse) {
       float2x8 data;
 
       if (i < N * (N / POINTS)) {
-        data.i0 = read_channel_intel(chaninfft3dc[0]);
-        data.i1 = read_channel_intel(chaninfft3dc[1]);
-        data.i2 = read_channel_intel(chaninfft3dc[2]);
-        data.i3 = read_channel_intel(chaninfft3dc[3]);
-        data.i4 = read_channel_intel(chaninfft3dc[4]);
-        data.i5 = read_channel_intel(chaninfft3dc[5]);
-        data.i6 = read_channel_intel(chaninfft3dc[6]);
-        data.i7 = read_channel_intel(chaninfft3dc[7]);
+        data.i0 = read_channel_intel(PIPE_NAME(chaninfft3dc)[0]);
+        data.i1 = read_channel_intel(PIPE_NAME(chaninfft3dc)[1]);
+        data.i2 = read_channel_intel(PIPE_NAME(chaninfft3dc)[2]);
+        data.i3 = read_channel_intel(PIPE_NAME(chaninfft3dc)[3]);
+        data.i4 = read_channel_intel(PIPE_NAME(chaninfft3dc)[4]);
+        data.i5 = read_channel_intel(PIPE_NAME(chaninfft3dc)[5]);
+        data.i6 = read_channel_intel(PIPE_NAME(chaninfft3dc)[6]);
+        data.i7 = read_channel_intel(PIPE_NAME(chaninfft3dc)[7]);
       } else {
         data.i0 = data.i1 = data.i2 = data.i3 = 
                   data.i4 = data.i5 = data.i6 = data.i7 = 0;
@@ -402,20 +711,88 @@ kernel void fft3dc(int inverse) {
 
       // Write result to channels
       if (i >= N / POINTS - 1) {
-        write_channel_intel(chaninStore[0], data.i0);
-        write_channel_intel(chaninStore[1], data.i1);
-        write_channel_intel(chaninStore[2], data.i2);
-        write_channel_intel(chaninStore[3], data.i3);
-        write_channel_intel(chaninStore[4], data.i4);
-        write_channel_intel(chaninStore[5], data.i5);
-        write_channel_intel(chaninStore[6], data.i6);
-        write_channel_intel(chaninStore[7], data.i7);
+        write_channel_intel(PIPE_NAME(chaninStore)[0], data.i0);
+        write_channel_intel(PIPE_NAME(chaninStore)[1], data.i1);
+        write_channel_intel(PIPE_NAME(chaninStore)[2], data.i2);
+        write_channel_intel(PIPE_NAME(chaninStore)[3], data.i3);
+        write_channel_intel(PIPE_NAME(chaninStore)[4], data.i4);
+        write_channel_intel(PIPE_NAME(chaninStore)[5], data.i5);
+        write_channel_intel(PIPE_NAME(chaninStore)[6], data.i6);
+        write_channel_intel(PIPE_NAME(chaninStore)[7], data.i7);
       }
     }
   }
 }
 
-kernel void store(__global __attribute__((buffer_location(SVM_HOST_BUFFER_LOCATION))) volatile float2 * restrict dest) {
+// Kernel that stores the output to global memory, scattered along z to the
+// layout [z][y][x] or, if transposed, in the order produced in [y][z][x]
+#ifdef FFT3D_AUTORUN
+
+/* The stages between fetch and transpose3D_wr and between transpose3D_rd and
+ * store run continuously without host launches. Each transform is preceded
+ * by a control word from the fetch kernel, forwarded from stage to stage.
+ */
+
+__attribute__((max_global_work_dim(0)))
+__attribute__((autorun))
+kernel void PIPE_NAME(fft3da)() {
+  while (1) {
+    int ctrl = read_channel_intel(PIPE_NAME(chanctrlfft3da));
+    write_channel_intel(PIPE_NAME(chanctrlTranspose), ctrl);
+    PIPE_NAME(fft3da_stage)(CTRL_INVERSE(ctrl));
+  }
+}
+
+__attribute__((max_global_work_dim(0)))
+__attribute__((autorun))
+kernel void PIPE_NAME(transpose)() {
+  while (1) {
+    int ctrl = read_channel_intel(PIPE_NAME(chanctrlTranspose));
+    write_channel_intel(PIPE_NAME(chanctrlfft3db), ctrl);
+    PIPE_NAME(transpose_stage)(CTRL_ORDER(ctrl));
+  }
+}
+
+__attribute__((max_global_work_dim(0)))
+__attribute__((autorun))
+kernel void PIPE_NAME(fft3db)() {
+  while (1) {
+    int ctrl = read_channel_intel(PIPE_NAME(chanctrlfft3db));
+    write_channel_intel(PIPE_NAME(chanctrlfft3dc), ctrl);
+    PIPE_NAME(fft3db_stage)(CTRL_INVERSE(ctrl));
+  }
+}
+
+__attribute__((max_global_work_dim(0)))
+__attribute__((autorun))
+kernel void PIPE_NAME(fft3dc)() {
+  while (1) {
+    int ctrl = read_channel_intel(PIPE_NAME(chanctrlfft3dc));
+    PIPE_NAME(fft3dc_stage)(CTRL_INVERSE(ctrl));
+  }
+}
+
+#else
+
+kernel void PIPE_NAME(fft3da)(int inverse) {
+  PIPE_NAME(fft3da_stage)(inverse);
+}
+
+kernel void PIPE_NAME(transpose)(const int order) {
+  PIPE_NAME(transpose_stage)(order);
+}
+
+kernel void PIPE_NAME(fft3db)(int inverse) {
+  PIPE_NAME(fft3db_stage)(inverse);
+}
+
+kernel void PIPE_NAME(fft3dc)(int inverse) {
+  PIPE_NAME(fft3dc_stage)(inverse);
+}
+
+#endif
+
+kernel void PIPE_NAME(store)(__global __attribute__((buffer_location(SVM_HOST_BUFFER_LOCATION))) volatile float2 * restrict dest, const int order, const int transposed) {
 
   const int DELAY = (1 << (LOGN - LOGPOINTS)); // N / 8
   bool is_bufA = false, is_bitrevA = false;
@@ -430,14 +807,14 @@ kernel void store(__global __attribute__((buffer_location(SVM_HOST_BUFFER_LOCATI
 
     float2x8 data, data_out;
     if (step < ((N * DEPTH) - initial_delay)) {
-      data.i0 = read_channel_intel(chaninStore[0]);
-      data.i1 = read_channel_intel(chaninStore[1]);
-      data.i2 = read_channel_intel(chaninStore[2]);
-      data.i3 = read_channel_intel(chaninStore[3]);
-      data.i4 = read_channel_intel(chaninStore[4]);
-      data.i5 = read_channel_intel(chaninStore[5]);
-      data.i6 = read_channel_intel(chaninStore[6]);
-      data.i7 = read_channel_intel(chaninStore[7]);
+      data.i0 = read_channel_intel(PIPE_NAME(chaninStore)[0]);
+      data.i1 = read_channel_intel(PIPE_NAME(chaninStore)[1]);
+      data.i2 = read_channel_intel(PIPE_NAME(chaninStore)[2]);
+      data.i3 = read_channel_intel(PIPE_NAME(chaninStore)[3]);
+      data.i4 = read_channel_intel(PIPE_NAME(chaninStore)[4]);
+      data.i5 = read_channel_intel(PIPE_NAME(chaninStore)[5]);
+      data.i6 = read_channel_intel(PIPE_NAME(chaninStore)[6]);
+      data.i7 = read_channel_intel(PIPE_NAME(chaninStore)[7]);
     } else {
       data.i0 = data.i1 = data.i2 = data.i3 = 
                 data.i4 = data.i5 = data.i6 = data.i7 = 0;
@@ -450,10 +827,10 @@ kernel void store(__global __attribute__((buffer_location(SVM_HOST_BUFFER_LOCATI
     is_bitrevA = ( (step & ((N / 8) - 1)) == 0) ? !is_bitrevA: is_bitrevA;
 
     unsigned row = step & (DEPTH - 1);
-    data = bitreverse_in(data,
+    data = bitreverse_in_order(data,
       is_bitrevA ? bitrev_in[0] : bitrev_in[1], 
       is_bitrevA ? bitrev_in[1] : bitrev_in[0], 
-      row);
+      row, order != ORDER_BITREV_OUT);
 
     writeBuf(data,
       is_bufA ? buf[0] : buf[1],
@@ -484,14 +861,18 @@ kernel void store(__global __attribute__((buffer_location(SVM_HOST_BUFFER_LOCATI
 
       unsigned index = (batch_index * N * N * N) + (zdim * N * N) + (ydim * N) + xdim; 
 
-      dest[index + 0] = data_out.i0;
-      dest[index + 1] = data_out.i1;
-      dest[index + 2] = data_out.i2;
-      dest[index + 3] = data_out.i3;
-      dest[index + 4] = data_out.i4;
-      dest[index + 5] = data_out.i5;
-      dest[index + 6] = data_out.i6;
-      dest[index + 7] = data_out.i7;
+      // skip the scatter along z, the first two dimensions are swapped
+      if(transposed)
+        index = start_index * 8;
+
+      dest[index + 0] = fft_store(data_out.i0, index + 0);
+      dest[index + 1] = fft_store(data_out.i1, index + 1);
+      dest[index + 2] = fft_store(data_out.i2, index + 2);
+      dest[index + 3] = fft_store(data_out.i3, index + 3);
+      dest[index + 4] = fft_store(data_out.i4, index + 4);
+      dest[index + 5] = fft_store(data_out.i5, index + 5);
+      dest[index + 6] = fft_store(data_out.i6, index + 6);
+      dest[index + 7] = fft_store(data_out.i7, index + 7);
     }
   }
 }
@@ -0,0 +1,11 @@
+// Author: Arjun Ramaswami
+
+/**
+ * 3D FFT using the DDR of the FPGA for the 3D Transpose, with the fft3da,
+ * transpose, fft3db and fft3dc stages as autorun kernels. The host launches
+ * only the fetch, transpose3D_wr, transpose3D_rd and store kernels of each
+ * transform.
+ */
+
+#define FFT3D_AUTORUN
+#include "fft3d_ddr.cl"
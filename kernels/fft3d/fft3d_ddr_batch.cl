@@ -1,5 +1,15 @@
 // Author: Arjun Ramaswami
 
+/**
+ * Batched 3D FFT using the DDR of the FPGA for the 3D Transpose. Every kernel
+ * takes the number of transforms of the batch and loops over them, so that
+ * the pipeline is not drained between transforms. The host launches the
+ * kernels once per piece of the batch, the whole batch if it fits into the
+ * device buffers. The 3D Transpose alternates
+ * between two buffers, writing a transform to one while reading the
+ * previous one from the other.
+ */
+
 #include "fft_config.h"
 #include "../common/fft_8.cl" 
 #include "../matrixTranspose/diagonal_bitrev.cl"
@@ -14,24 +24,21 @@ channel float2 chaninTranspose[POINTS];
 channel float2 chaninTranspose3D[POINTS];
 channel float2 chaninStore[POINTS];
 
-#define WR_GLOBALMEM 0
-#define RD_GLOBALMEM 1
-#define BATCH 2
-
-// Kernel that fetches data from global memory 
-kernel void fetch(__global __attribute__((buffer_location(SVM_HOST_BUFFER_LOCATION))) volatile float2 * restrict src) {
+// Kernel that fetches data from global memory, the transforms of the batch
+// being contiguous
+kernel void fetch(__global __attribute__((buffer_location(SVM_HOST_BUFFER_LOCATION))) volatile float2 * restrict src, const unsigned how_many) {
   unsigned delay = (1 << (LOGN - LOGPOINTS)); // N / 8
   bool is_bitrevA = false;
 
   float2 __attribute__((memory, numbanks(8))) buf[2][N];
   
   // additional iterations to fill the buffers
-  for(unsigned step = 0; step < (N * DEPTH) + delay; step++){
+  for(unsigned step = 0; step < (how_many * N * DEPTH) + delay; step++){
 
-    unsigned where = (step & ((N * DEPTH) - 1)) * 8; 
+    unsigned where = step * 8; 
 
     float2x8 data;
-    if (step < (N * DEPTH)) {
+    if (step < (how_many * N * DEPTH)) {
       data.i0 = src[where + 0];
       data.i1 = src[where + 1];
       data.i2 = src[where + 2];
@@ -66,7 +73,7 @@ kernel void fetch(__global __attribute__((buffer_location(SVM_HOST_BUFFER_LOCATI
   }
 }
 
-kernel void fft3da(int inverse) {
+kernel void fft3da(int inverse, const unsigned how_many) {
 
   /* The FFT engine requires a sliding window for data reordering; data stored
    * in this array is carried across loop iterations and shifted by 1 element
@@ -77,7 +84,7 @@ kernel void fft3da(int inverse) {
   float2 fft_delay_elements[N + POINTS * (LOGN - 2)];
 
   #pragma loop_coalesce
-  for(unsigned j = 0; j < N; j++){
+  for(unsigned j = 0; j < how_many * N; j++){
     for (unsigned i = 0; i < N * (N / POINTS) + N / POINTS - 1; i++) {
       float2x8 data;
 
@@ -113,7 +120,7 @@ kernel void fft3da(int inverse) {
   }
 }
 
-kernel void transpose() {
+kernel void transpose(const unsigned how_many) {
   const int DELAY = (1 << (LOGN - LOGPOINTS)); // N / 8
   bool is_bufA = false, is_bitrevA = false;
 
@@ -126,10 +133,10 @@ kernel void transpose() {
   int initial_delay = DELAY + DELAY; // for each of the bitrev buffer
 
   // additional iterations to fill the buffers
-  for(int step = -initial_delay; step < ((N * DEPTH) + DEPTH); step++){
+  for(int step = -initial_delay; step < ((how_many * N * DEPTH) + DEPTH); step++){
 
     float2x8 data, data_out;
-    if (step < ((N * DEPTH) - initial_delay)) {
+    if (step < ((how_many * N * DEPTH) - initial_delay)) {
       data.i0 = read_channel_intel(chaninTranspose[0]);
       data.i1 = read_channel_intel(chaninTranspose[1]);
       data.i2 = read_channel_intel(chaninTranspose[2]);
@@ -184,7 +191,7 @@ kernel void transpose() {
   }
 }
 
-kernel void fft3db(int inverse) {
+kernel void fft3db(int inverse, const unsigned how_many) {
 
   /* The FFT engine requires a sliding window for data reordering; data stored
    * in this array is carried across loop iterations and shifted by 1 element
@@ -195,7 +202,7 @@ kernel void fft3db(int inverse) {
   float2 fft_delay_elements[N + POINTS * (LOGN - 2)];
 
   #pragma loop_coalesce
-  for(unsigned j = 0; j < N; j++){
+  for(unsigned j = 0; j < how_many * N; j++){
     for (unsigned i = 0; i < N * (N / POINTS) + N / POINTS - 1; i++) {
       float2x8 data;
 
@@ -229,14 +236,16 @@ kernel void fft3db(int inverse) {
   }
 }
 
+// 3D Transpose through the DDR, alternating between the buffers bufA and
+// bufB: in phase k of the batch, the transform k coming from fft3db is
+// written to one buffer while the transform k - 1 is read from the other one
+// and sent to fft3dc.
 kernel void transpose3D(
-  __global __attribute__((buffer_location(DDR_BUFFER_LOCATION))) float2 * restrict src, 
-  __global __attribute__((buffer_location(DDR_BUFFER_LOCATION))) float2 * restrict dest, 
-  const int mode) {
+  __global __attribute__((buffer_location(DDR_BUFFER_LOCATION))) float2 * restrict bufA, 
+  __global __attribute__((buffer_location(DDR_BUFFER_LOCATION))) float2 * restrict bufB, 
+  const unsigned how_many) {
 
   const int initial_delay = (1 << (LOGN - LOGPOINTS)); // N / 8 for the bitrev buffers
-  bool is_bufA = false, is_bitrevA = false;
-  bool is_bufB = false, is_bitrevB = false;
 
   float2 buf_wr[2][DEPTH][POINTS];
   float2 buf_rd[2][DEPTH][POINTS];
@@ -245,129 +254,136 @@ kernel void transpose3D(
   float2 bitrev_in[2][N];
   float2 __attribute__((memory, numbanks(8))) bitrev_out[2][N];
 
-  // additional iterations to fill the buffers
-  for(int step = -initial_delay; step < ((N * DEPTH) + DEPTH); step++){
-
-    float2x8 data, data_out;
-    float2x8 data_wr, data_wr_out;
-    if(mode == WR_GLOBALMEM || mode == BATCH){
-      if (step < ((N * DEPTH) - initial_delay)) {
-        data.i0 = read_channel_intel(chaninTranspose3D[0]);
-        data.i1 = read_channel_intel(chaninTranspose3D[1]);
-        data.i2 = read_channel_intel(chaninTranspose3D[2]);
-        data.i3 = read_channel_intel(chaninTranspose3D[3]);
-        data.i4 = read_channel_intel(chaninTranspose3D[4]);
-        data.i5 = read_channel_intel(chaninTranspose3D[5]);
-        data.i6 = read_channel_intel(chaninTranspose3D[6]);
-        data.i7 = read_channel_intel(chaninTranspose3D[7]);
-      } else {
-        data.i0 = data.i1 = data.i2 = data.i3 = 
-                  data.i4 = data.i5 = data.i6 = data.i7 = 0;
-      }
-
-      // Swap buffers every N*N/8 iterations 
-      // starting from the additional delay of N/8 iterations
-      is_bufA = (( step & (DEPTH - 1)) == 0) ? !is_bufA: is_bufA;
-
-      // Swap bitrev buffers every N/8 iterations
-      is_bitrevA = ( (step & ((N / 8) - 1)) == 0) ? !is_bitrevA: is_bitrevA;
-
-      unsigned row = step & (DEPTH - 1);
-      data = bitreverse_in(data,
-        is_bitrevA ? bitrev_in[0] : bitrev_in[1], 
-        is_bitrevA ? bitrev_in[1] : bitrev_in[0], 
-        row);
-
-      writeBuf(data,
-        is_bufA ? buf_wr[0] : buf_wr[1],
-        step, 0);
-
-      data_out = readBuf_store(
-        is_bufA ? buf_wr[1] : buf_wr[0], 
-        step);
-
-      if (step >= (DEPTH)) {
-        unsigned index = (step - DEPTH) * 8;
-
-        dest[index + 0] = data_out.i0;
-        dest[index + 1] = data_out.i1;
-        dest[index + 2] = data_out.i2;
-        dest[index + 3] = data_out.i3;
-        dest[index + 4] = data_out.i4;
-        dest[index + 5] = data_out.i5;
-        dest[index + 6] = data_out.i6;
-        dest[index + 7] = data_out.i7;
-      }
-    } // condition for writing to global memory
-    if(mode == RD_GLOBALMEM || mode == BATCH){
-
-      unsigned step_rd = step + initial_delay;
-      // increment z by 1 every N/8 steps until (N*N/ 8)
-      unsigned start_index = step_rd + initial_delay;
-      unsigned zdim = (step_rd >> (LOGN - LOGPOINTS)) & (N - 1); 
-
-      // increment y by 1 every N*N/8 points until N
-      unsigned ydim = (step_rd >> (LOGN + LOGN - LOGPOINTS)) & (N - 1);
-
-      // increment by 8 until N / 8
-      unsigned xdim = (step_rd * 8) & (N - 1);
-
-      // increment by 1 every N*N*N / 8 steps
-      unsigned batch_index = (step_rd >> (LOGN + LOGN + LOGN - LOGPOINTS));
-
-      unsigned index_wr = (batch_index * N * N * N) + (zdim * N * N) + (ydim * N) + xdim; 
-
-      //float2x8 data, data_out;
-      if (step < (N * DEPTH)) {
-        data_wr.i0 = src[index_wr + 0];
-        data_wr.i1 = src[index_wr + 1];
-        data_wr.i2 = src[index_wr + 2];
-        data_wr.i3 = src[index_wr + 3];
-        data_wr.i4 = src[index_wr + 4];
-        data_wr.i5 = src[index_wr + 5];
-        data_wr.i6 = src[index_wr + 6];
-        data_wr.i7 = src[index_wr + 7];
-      } else {
-        data_wr.i0 = data_wr.i1 = data_wr.i2 = data_wr.i3 = 
-                  data_wr.i4 = data_wr.i5 = data_wr.i6 = data_wr.i7 = 0;
-      }
-    
-      is_bufB = (( step_rd & (DEPTH - 1)) == 0) ? !is_bufB: is_bufB;
-
-      // Swap bitrev buffers every N/8 iterations
-      is_bitrevB = ( (step_rd & ((N / 8) - 1)) == 0) ? !is_bitrevB: is_bitrevB;
-
-      writeBuf(data_wr,
-        is_bufB ? buf_rd[0] : buf_rd[1],
-        step_rd, 0);
-
-      data_wr_out = readBuf_fetch(
-        is_bufB ? buf_rd[1] : buf_rd[0], 
-        step_rd, 0);
-
-      unsigned start_row = step_rd & (DEPTH -1);
-      data_wr_out = bitreverse_out(
-        is_bitrevB ? bitrev_out[0] : bitrev_out[1],
-        is_bitrevB ? bitrev_out[1] : bitrev_out[0],
-        data_wr_out, start_row);
-
-      if (step_rd >= (DEPTH + initial_delay)) {
-
-        write_channel_intel(chaninfft3dc[0], data_wr_out.i0);
-        write_channel_intel(chaninfft3dc[1], data_wr_out.i1);
-        write_channel_intel(chaninfft3dc[2], data_wr_out.i2);
-        write_channel_intel(chaninfft3dc[3], data_wr_out.i3);
-        write_channel_intel(chaninfft3dc[4], data_wr_out.i4);
-        write_channel_intel(chaninfft3dc[5], data_wr_out.i5);
-        write_channel_intel(chaninfft3dc[6], data_wr_out.i6);
-        write_channel_intel(chaninfft3dc[7], data_wr_out.i7);
-      }
-
-    } // condition for reading from global memory
+  for(unsigned k = 0; k <= how_many; k++){
+    bool is_bufA = false, is_bitrevA = false;
+    bool is_bufB = false, is_bitrevB = false;
+
+    const bool write_phase = (k < how_many);
+    const bool read_phase = (k > 0);
+    __global float2 * restrict dest = (k & 1) ? bufB : bufA;
+    __global float2 * restrict src = (k & 1) ? bufA : bufB;
+
+    // additional iterations to fill the buffers. In a phase, a buffer is
+    // either written or read, hence no dependencies between iterations
+    #pragma ivdep
+    for(int step = -initial_delay; step < ((N * DEPTH) + DEPTH); step++){
+
+      float2x8 data, data_out;
+      float2x8 data_wr, data_wr_out;
+      if(write_phase){
+        if (step < ((N * DEPTH) - initial_delay)) {
+          data.i0 = read_channel_intel(chaninTranspose3D[0]);
+          data.i1 = read_channel_intel(chaninTranspose3D[1]);
+          data.i2 = read_channel_intel(chaninTranspose3D[2]);
+          data.i3 = read_channel_intel(chaninTranspose3D[3]);
+          data.i4 = read_channel_intel(chaninTranspose3D[4]);
+          data.i5 = read_channel_intel(chaninTranspose3D[5]);
+          data.i6 = read_channel_intel(chaninTranspose3D[6]);
+          data.i7 = read_channel_intel(chaninTranspose3D[7]);
+        } else {
+          data.i0 = data.i1 = data.i2 = data.i3 = 
+                    data.i4 = data.i5 = data.i6 = data.i7 = 0;
+        }
+
+        // Swap buffers every N*N/8 iterations 
+        // starting from the additional delay of N/8 iterations
+        is_bufA = (( step & (DEPTH - 1)) == 0) ? !is_bufA: is_bufA;
+
+        // Swap bitrev buffers every N/8 iterations
+        is_bitrevA = ( (step & ((N / 8) - 1)) == 0) ? !is_bitrevA: is_bitrevA;
+
+        unsigned row = step & (DEPTH - 1);
+        data = bitreverse_in(data,
+          is_bitrevA ? bitrev_in[0] : bitrev_in[1], 
+          is_bitrevA ? bitrev_in[1] : bitrev_in[0], 
+          row);
+
+        writeBuf(data,
+          is_bufA ? buf_wr[0] : buf_wr[1],
+          step, 0);
+
+        data_out = readBuf_store(
+          is_bufA ? buf_wr[1] : buf_wr[0], 
+          step);
+
+        if (step >= (DEPTH)) {
+          unsigned index = (step - DEPTH) * 8;
+
+          dest[index + 0] = data_out.i0;
+          dest[index + 1] = data_out.i1;
+          dest[index + 2] = data_out.i2;
+          dest[index + 3] = data_out.i3;
+          dest[index + 4] = data_out.i4;
+          dest[index + 5] = data_out.i5;
+          dest[index + 6] = data_out.i6;
+          dest[index + 7] = data_out.i7;
+        }
+      } // condition for writing to global memory
+      if(read_phase){
+
+        unsigned step_rd = step + initial_delay;
+        // increment z by 1 every N/8 steps until (N*N/ 8)
+        unsigned zdim = (step_rd >> (LOGN - LOGPOINTS)) & (N - 1); 
+
+        // increment y by 1 every N*N/8 points until N
+        unsigned ydim = (step_rd >> (LOGN + LOGN - LOGPOINTS)) & (N - 1);
+
+        // increment by 8 until N / 8
+        unsigned xdim = (step_rd * 8) & (N - 1);
+
+        unsigned index_wr = (zdim * N * N) + (ydim * N) + xdim; 
+
+        if (step < (N * DEPTH)) {
+          data_wr.i0 = src[index_wr + 0];
+          data_wr.i1 = src[index_wr + 1];
+          data_wr.i2 = src[index_wr + 2];
+          data_wr.i3 = src[index_wr + 3];
+          data_wr.i4 = src[index_wr + 4];
+          data_wr.i5 = src[index_wr + 5];
+          data_wr.i6 = src[index_wr + 6];
+          data_wr.i7 = src[index_wr + 7];
+        } else {
+          data_wr.i0 = data_wr.i1 = data_wr.i2 = data_wr.i3 = 
+                    data_wr.i4 = data_wr.i5 = data_wr.i6 = data_wr.i7 = 0;
+        }
+      
+        is_bufB = (( step_rd & (DEPTH - 1)) == 0) ? !is_bufB: is_bufB;
+
+        // Swap bitrev buffers every N/8 iterations
+        is_bitrevB = ( (step_rd & ((N / 8) - 1)) == 0) ? !is_bitrevB: is_bitrevB;
+
+        writeBuf(data_wr,
+          is_bufB ? buf_rd[0] : buf_rd[1],
+          step_rd, 0);
+
+        data_wr_out = readBuf_fetch(
+          is_bufB ? buf_rd[1] : buf_rd[0], 
+          step_rd, 0);
+
+        unsigned start_row = step_rd & (DEPTH -1);
+        data_wr_out = bitreverse_out(
+          is_bitrevB ? bitrev_out[0] : bitrev_out[1],
+          is_bitrevB ? bitrev_out[1] : bitrev_out[0],
+          data_wr_out, start_row);
+
+        if (step_rd >= (DEPTH + initial_delay)) {
+
+          write_channel_intel(chaninfft3dc[0], data_wr_out.i0);
+          write_channel_intel(chaninfft3dc[1], data_wr_out.i1);
+          write_channel_intel(chaninfft3dc[2], data_wr_out.i2);
+          write_channel_intel(chaninfft3dc[3], data_wr_out.i3);
+          write_channel_intel(chaninfft3dc[4], data_wr_out.i4);
+          write_channel_intel(chaninfft3dc[5], data_wr_out.i5);
+          write_channel_intel(chaninfft3dc[6], data_wr_out.i6);
+          write_channel_intel(chaninfft3dc[7], data_wr_out.i7);
+        }
+
+      } // condition for reading from global memory
+    }
   }
 }
 
-kernel void fft3dc(int inverse) {
+kernel void fft3dc(int inverse, const unsigned how_many) {
 
   /* The FFT engine requires a sliding window for data reordering; data stored
    * in this array is carried across loop iterations and shifted by 1 element
@@ -378,7 +394,7 @@ kernel void fft3dc(int inverse) {
   float2 fft_delay_elements[N + POINTS * (LOGN - 2)];
 
   #pragma loop_coalesce
-  for(unsigned j = 0; j < N; j++){
+  for(unsigned j = 0; j < how_many * N; j++){
 
     for (unsigned i = 0; i < N * (N / POINTS) + N / POINTS - 1; i++) {
       float2x8 data;
@@ -415,7 +431,7 @@ kernel void fft3dc(int inverse) {
   }
 }
 
-kernel void store(__global __attribute__((buffer_location(SVM_HOST_BUFFER_LOCATION))) volatile float2 * restrict dest) {
+kernel void store(__global __attribute__((buffer_location(SVM_HOST_BUFFER_LOCATION))) volatile float2 * restrict dest, const unsigned how_many) {
 
   const int DELAY = (1 << (LOGN - LOGPOINTS)); // N / 8
   bool is_bufA = false, is_bitrevA = false;
@@ -426,10 +442,10 @@ kernel void store(__global __attribute__((buffer_location(SVM_HOST_BUFFER_LOCATI
   
   int initial_delay = DELAY; // for each of the bitrev buffer
   // additional iterations to fill the buffers
-  for(int step = -initial_delay; step < ((N * DEPTH) + DEPTH); step++){
+  for(int step = -initial_delay; step < ((how_many * N * DEPTH) + DEPTH); step++){
 
     float2x8 data, data_out;
-    if (step < ((N * DEPTH) - initial_delay)) {
+    if (step < ((how_many * N * DEPTH) - initial_delay)) {
       data.i0 = read_channel_intel(chaninStore[0]);
       data.i1 = read_channel_intel(chaninStore[1]);
       data.i2 = read_channel_intel(chaninStore[2]);
@@ -0,0 +1,67 @@
+// Author: Arjun Ramaswami
+
+/**
+ * 3D FFT using the DDR of the FPGA for the 3D Transpose, extended with
+ * operations on the spectrum so that convolutions and derivatives are
+ * computed entirely on the device: forward 3D FFT, multiplication of the
+ * spectrum by a kernel array or by i*k along an axis, and backward 3D FFT.
+ * The spectrum remains in DDR between the stages.
+ */
+
+#include "fft3d_ddr.cl"
+
+// Multiply the spectrum in place with the coefficients of the kernel array
+kernel void pointwise(
+  __global __attribute__((buffer_location(SVM_HOST_BUFFER_LOCATION))) float2 * restrict data,
+  __global __attribute__((buffer_location(DDR_BUFFER_LOCATION))) const float2 * restrict coeff,
+  const unsigned num_pts) {
+
+  for(unsigned i = 0; i < num_pts; i += POINTS){
+    #pragma unroll
+    for(unsigned k = 0; k < POINTS; k++){
+      float2 a = data[i + k];
+      float2 b = coeff[i + k];
+
+      float2 res;
+      res.x = (a.x * b.x) - (a.y * b.y);
+      res.y = (a.x * b.y) + (a.y * b.x);
+      data[i + k] = res;
+    }
+  }
+}
+
+// Multiply the spectrum by i * k along an axis, with the k-vectors generated from the index.
+// The spectrum is in the unordered mode, its frequencies bit-reversed along each dimension.
+// The axis is given by its position in the layout, 0 being the contiguous dimension
+kernel void derivative(
+  __global __attribute__((buffer_location(SVM_HOST_BUFFER_LOCATION))) const float2 * restrict src,
+  __global __attribute__((buffer_location(SVM_HOST_BUFFER_LOCATION))) float2 * restrict dest,
+  const int axis, const float scale) {
+
+  for(unsigned i = 0; i < N * N * N; i += POINTS){
+    #pragma unroll
+    for(unsigned k = 0; k < POINTS; k++){
+      unsigned where = i + k;
+
+      // position along the axis
+      unsigned pos;
+      if(axis == 0)
+        pos = where & (N - 1);
+      else if(axis == 1)
+        pos = (where >> LOGN) & (N - 1);
+      else
+        pos = where >> (LOGN + LOGN);
+      unsigned m = bit_reversed(pos, LOGN);
+
+      // frequencies above N/2 are negative, the Nyquist frequency has no derivative
+      int freq = (m < (N / 2)) ? (int)m : ((m == (N / 2)) ? 0 : (int)m - N);
+      float kval = scale * (float)freq;
+
+      float2 a = src[where];
+      float2 res;
+      res.x = -kval * a.y;
+      res.y = kval * a.x;
+      dest[where] = res;
+    }
+  }
+}
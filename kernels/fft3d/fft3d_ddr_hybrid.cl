@@ -0,0 +1,11 @@
+// Author: Arjun Ramaswami
+
+/**
+ * 3D FFT using the BRAM and the DDR of the FPGA for the 3D Transpose. The
+ * rows of the xz-slabs that fit into 2^LOG_TRANSPOSE3D_BRAM points stay on
+ * chip, the others go through the DDR, which reduces the DDR traffic of the
+ * 3D Transpose of sizes such as 128^3 and 256^3 that do not fit into BRAM.
+ */
+
+#define FFT3D_HYBRID
+#include "fft3d_ddr.cl"
@@ -0,0 +1,37 @@
+// Author: Arjun Ramaswami
+
+/**
+ * PIPELINES replicated pipelines of the 3D FFT using the DDR of the FPGA for
+ * the 3D Transpose, to compute several transforms of a batch concurrently.
+ * The kernels and channels of pipeline p are suffixed by p, e.g. fetch0 and
+ * store0 for the first one. The host binds the buffers of each pipeline to
+ * different DDR banks.
+ */
+
+#include "fft_config.h"
+
+#if PIPELINES < 1 || PIPELINES > 4
+#error "fft3d_ddr_multi supports 1 to 4 pipelines"
+#endif
+
+#define PIPE 0
+#include "fft3d_ddr.cl"
+#undef PIPE
+
+#if PIPELINES > 1
+#define PIPE 1
+#include "fft3d_ddr.cl"
+#undef PIPE
+#endif
+
+#if PIPELINES > 2
+#define PIPE 2
+#include "fft3d_ddr.cl"
+#undef PIPE
+#endif
+
+#if PIPELINES > 3
+#define PIPE 3
+#include "fft3d_ddr.cl"
+#undef PIPE
+#endif
@@ -0,0 +1,11 @@
+// Author: Arjun Ramaswami
+
+/**
+ * 3D FFT using the DDR of the FPGA for the 3D Transpose, striped across the
+ * four DDR banks. The blocks of the layout of the 3D Transpose are written to
+ * and read from the banks in turn, so that each bank serves a quarter of the
+ * accesses of the most memory-bound stage of the transform.
+ */
+
+#define FFT3D_STRIPED
+#include "fft3d_ddr.cl"
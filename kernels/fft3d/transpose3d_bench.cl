@@ -0,0 +1,59 @@
+// Author: Arjun Ramaswami
+
+/**
+ * Microbenchmark of the DDR accesses of the 3D Transpose. The kernels
+ * reproduce the accesses of transpose3D_wr and transpose3D_rd of
+ * fft3d_ddr.cl, POINTS points per cycle, without computations, for a size
+ * and a layout given at runtime, so that a single bitstream measures the
+ * DDR bandwidth of the layouts of transpose3d_layout.cl against N.
+ */
+
+#include "fft_config.h"
+#include "../matrixTranspose/transpose3d_layout.cl"
+
+// Sequential write of the 3D Transpose, the tiled layout being reordered on chip
+kernel void bench_write(
+  __global __attribute__((buffer_location(DDR_BUFFER_LOCATION))) float2 * restrict dest,
+  const int logN) {
+
+  const unsigned steps = 1 << (logN + logN + logN - LOGPOINTS);
+
+  for(unsigned step = 0; step < steps; step++){
+    unsigned index = step * POINTS;
+
+    #pragma unroll
+    for(unsigned k = 0; k < POINTS; k++){
+      float2 data;
+      data.x = (float)(index + k);
+      data.y = 0.0f;
+      dest[index + k] = data;
+    }
+  }
+}
+
+// Read of the 3D Transpose along z for every y in the layout given. The bits
+// of the points read are folded into 'check' so that the reads are kept
+kernel void bench_read(
+  __global __attribute__((buffer_location(DDR_BUFFER_LOCATION))) const float2 * restrict src,
+  __global uint2 * restrict check,
+  const int logN, const int log_tile) {
+
+  const unsigned size = 1 << logN;
+  const unsigned steps = 1 << (logN + logN + logN - LOGPOINTS);
+  uint2 fold = 0;
+
+  for(unsigned step = 0; step < steps; step++){
+    unsigned xdim = (step * POINTS) & (size - 1);
+    unsigned zdim = (step >> (logN - LOGPOINTS)) & (size - 1);
+    unsigned ydim = step >> (logN + logN - LOGPOINTS);
+
+    unsigned index = transpose3d_index(zdim, ydim, xdim, logN, log_tile);
+
+    #pragma unroll
+    for(unsigned k = 0; k < POINTS; k++){
+      fold ^= as_uint2(src[index + k]);
+    }
+  }
+
+  check[0] = fold;
+}
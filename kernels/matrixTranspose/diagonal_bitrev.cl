@@ -221,3 +221,111 @@ float2x8 readBuf_fetch(float2 buf[DEPTH][POINTS], unsigned step, unsigned delay)
 
   return data;
 }
+
+/*
+ * Variants of the bit reversal stages for transforms in the unordered mode.
+ * Without reorder, bitreverse_in_order passes the points through in the order
+ * they arrive, keeping the delay of bitreverse_in. With bitrev_input, the
+ * fetch and out stages read a sequence stored in bit-reversed order in the
+ * order required by the FFT engine, lane k of step c reading the point
+ * bitrev(c) * 8 + k, which maps each lane to a bank of its own.
+ */
+
+float2x8 bitreverse_fetch_order(float2x8 data, float2 bitrev_outA[N], float2 bitrev_outB[N], unsigned row, bool bitrev_input){
+
+  const unsigned STEPS = (1 << (LOGN - LOGPOINTS));
+  unsigned index = (row & (STEPS - 1)) * 8;
+
+  bitrev_outA[index + 0] = data.i0;
+  bitrev_outA[index + 1] = data.i1;
+  bitrev_outA[index + 2] = data.i2;
+  bitrev_outA[index + 3] = data.i3;
+  bitrev_outA[index + 4] = data.i4;
+  bitrev_outA[index + 5] = data.i5;
+  bitrev_outA[index + 6] = data.i6;
+  bitrev_outA[index + 7] = data.i7;
+
+  unsigned index_out = (row & (STEPS - 1));
+  unsigned index_rev = bit_reversed(index_out, LOGN - LOGPOINTS) * 8;
+  float2x8 rotate_out;
+  rotate_out.i0 = bitrev_outB[bitrev_input ? index_rev + 0 : index_out]; 
+  rotate_out.i1 = bitrev_outB[bitrev_input ? index_rev + 1 : (4 * N / 8) + index_out];
+  rotate_out.i2 = bitrev_outB[bitrev_input ? index_rev + 2 : (2 * N / 8) + index_out];
+  rotate_out.i3 = bitrev_outB[bitrev_input ? index_rev + 3 : (6 * N / 8) + index_out];
+  rotate_out.i4 = bitrev_outB[bitrev_input ? index_rev + 4 : (N / 8) + index_out];
+  rotate_out.i5 = bitrev_outB[bitrev_input ? index_rev + 5 : (5 * N / 8) + index_out];
+  rotate_out.i6 = bitrev_outB[bitrev_input ? index_rev + 6 : (3 * N / 8) + index_out];
+  rotate_out.i7 = bitrev_outB[bitrev_input ? index_rev + 7 : (7 * N / 8) + index_out];
+
+  return rotate_out;
+}
+
+float2x8 bitreverse_out_order(float2 bitrev_outA[N], float2 bitrev_outB[N], float2x8 data, unsigned row, bool bitrev_input){
+  float2 rotate_in[POINTS];
+
+  rotate_in[0] = data.i0;
+  rotate_in[1] = data.i1;
+  rotate_in[2] = data.i2;
+  rotate_in[3] = data.i3;
+  rotate_in[4] = data.i4;
+  rotate_in[5] = data.i5;
+  rotate_in[6] = data.i6;
+  rotate_in[7] = data.i7;
+
+  const unsigned STEPS = (1 << (LOGN - LOGPOINTS));
+
+  unsigned index = (row & (STEPS - 1)) * 8;
+  unsigned rot = (row >> (LOGN - LOGPOINTS)) & (POINTS - 1);
+
+  bitrev_outA[index] = rotate_in[(0 + rot) & (POINTS - 1)];
+  bitrev_outA[index + 1] = rotate_in[(1 + rot) & (POINTS - 1)];
+  bitrev_outA[index + 2] = rotate_in[(2 + rot) & (POINTS - 1)];
+  bitrev_outA[index + 3] = rotate_in[(3 + rot) & (POINTS - 1)];
+  bitrev_outA[index + 4] = rotate_in[(4 + rot) & (POINTS - 1)];
+  bitrev_outA[index + 5] = rotate_in[(5 + rot) & (POINTS - 1)];
+  bitrev_outA[index + 6] = rotate_in[(6 + rot) & (POINTS - 1)];
+  bitrev_outA[index + 7] = rotate_in[(7 + rot) & (POINTS - 1)];
+
+  unsigned index_out = (row & (STEPS - 1));
+  unsigned index_rev = bit_reversed(index_out, LOGN - LOGPOINTS) * 8;
+  float2x8 rotate_out;
+  rotate_out.i0 = bitrev_outB[bitrev_input ? index_rev + 0 : index_out]; 
+  rotate_out.i1 = bitrev_outB[bitrev_input ? index_rev + 1 : (4 * N / 8) + index_out];
+  rotate_out.i2 = bitrev_outB[bitrev_input ? index_rev + 2 : (2 * N / 8) + index_out];
+  rotate_out.i3 = bitrev_outB[bitrev_input ? index_rev + 3 : (6 * N / 8) + index_out];
+  rotate_out.i4 = bitrev_outB[bitrev_input ? index_rev + 4 : (N / 8) + index_out];
+  rotate_out.i5 = bitrev_outB[bitrev_input ? index_rev + 5 : (5 * N / 8) + index_out];
+  rotate_out.i6 = bitrev_outB[bitrev_input ? index_rev + 6 : (3 * N / 8) + index_out];
+  rotate_out.i7 = bitrev_outB[bitrev_input ? index_rev + 7 : (7 * N / 8) + index_out];
+
+  return rotate_out;
+}
+
+float2x8 bitreverse_in_order(float2x8 rotate_in, float2 bitrev_inA[N], float2 bitrev_inB[N], unsigned row, bool reorder){
+
+  const unsigned STEPS = (N / 8);
+  unsigned index = row & (STEPS - 1); // [0, N/8 - 1]
+  unsigned index_in = index * 8;
+
+  bitrev_inA[index_in + 0] = rotate_in.i0;
+  bitrev_inA[index_in + 1] = rotate_in.i1;
+  bitrev_inA[index_in + 2] = rotate_in.i2;
+  bitrev_inA[index_in + 3] = rotate_in.i3;
+  bitrev_inA[index_in + 4] = rotate_in.i4;
+  bitrev_inA[index_in + 5] = rotate_in.i5;
+  bitrev_inA[index_in + 6] = rotate_in.i6;
+  bitrev_inA[index_in + 7] = rotate_in.i7;
+
+  float2x8 rotate_out;
+  unsigned index_out = index * 8;
+  rotate_out.i0 = bitrev_inB[reorder ? bit_reversed(index_out + 0, LOGN) : index_out + 0];
+  rotate_out.i1 = bitrev_inB[reorder ? bit_reversed(index_out + 1, LOGN) : index_out + 1];
+  rotate_out.i2 = bitrev_inB[reorder ? bit_reversed(index_out + 2, LOGN) : index_out + 2];
+  rotate_out.i3 = bitrev_inB[reorder ? bit_reversed(index_out + 3, LOGN) : index_out + 3];
+  rotate_out.i4 = bitrev_inB[reorder ? bit_reversed(index_out + 4, LOGN) : index_out + 4];
+  rotate_out.i5 = bitrev_inB[reorder ? bit_reversed(index_out + 5, LOGN) : index_out + 5];
+  rotate_out.i6 = bitrev_inB[reorder ? bit_reversed(index_out + 6, LOGN) : index_out + 6];
+  rotate_out.i7 = bitrev_inB[reorder ? bit_reversed(index_out + 7, LOGN) : index_out + 7];
+
+  return rotate_out;
+}
@@ -0,0 +1,33 @@
+// Author: Arjun Ramaswami
+
+/*
+ * Layout of the buffer of the 3D Transpose in the DDR. The planes along z are
+ * grouped into blocks of 2^log_tile planes, stored in the order
+ * [z / tile][y][z % tile][x]. The 3D Transpose writes a block at a time after
+ * reordering it on chip, which keeps the write sequential, and reads along z
+ * for each y, which then reads 2^log_tile rows along x in sequence. A
+ * log_tile of 0 is the layout [z][y][x].
+ */
+
+// Index of the point (z, y, x) in the buffer of the 3D Transpose
+unsigned transpose3d_index(unsigned zdim, unsigned ydim, unsigned xdim, const int logN, const int log_tile){
+  unsigned block = zdim >> log_tile;
+  unsigned zlo = zdim & ((1 << log_tile) - 1);
+  return (((((block << logN) + ydim) << log_tile) + zlo) << logN) + xdim;
+}
+
+/*
+ * Striped across 2^log_banks buffers, one per DDR bank, the blocks of
+ * 2^log_block points of the layout above are distributed over the buffers
+ * in turn. Reading along z then moves to the next bank after every block.
+ */
+
+// Buffer holding the point at 'index' of the 3D Transpose
+unsigned transpose3d_bank(unsigned index, const int log_block, const int log_banks){
+  return (index >> log_block) & ((1 << log_banks) - 1);
+}
+
+// Index of the point at 'index' of the 3D Transpose in its buffer
+unsigned transpose3d_offset(unsigned index, const int log_block, const int log_banks){
+  return ((index >> (log_block + log_banks)) << log_block) + (index & ((1 << log_block) - 1));
+}
@@ -0,0 +1,161 @@
+//  Author: Arjun Ramaswami
+
+#include "gtest/gtest.h"  // finds this because gtest is linked
+#include <vector>
+
+/**
+ * Host checks of the index math of the bit reversal stages of
+ * kernels/matrixTranspose/diagonal_bitrev.cl. The stages are compiled as C++
+ * with the OpenCL types they use emulated below, once for each size, and are
+ * fed points tagged with their index instead of data.
+ */
+struct float2 {
+  float x, y;
+};
+
+typedef struct {
+  float2 i0, i1, i2, i3, i4, i5, i6, i7;
+} float2x8;
+
+namespace logn6 {
+#define LOGN 6
+#define N (1 << LOGN)
+#define LOGPOINTS 3
+#define POINTS 8
+#define DEPTH (1 << (LOGN + LOGN - LOGPOINTS))
+#include "diagonal_bitrev.cl"
+#undef DEPTH
+#undef POINTS
+#undef LOGPOINTS
+#undef N
+#undef LOGN
+}
+
+namespace logn8 {
+#define LOGN 8
+#define N (1 << LOGN)
+#define LOGPOINTS 3
+#define POINTS 8
+#define DEPTH (1 << (LOGN + LOGN - LOGPOINTS))
+#include "diagonal_bitrev.cl"
+#undef DEPTH
+#undef POINTS
+#undef LOGPOINTS
+#undef N
+#undef LOGN
+}
+
+typedef float2x8 (*fetch_fn)(float2x8, float2 *, float2 *, unsigned);
+typedef float2x8 (*fetch_order_fn)(float2x8, float2 *, float2 *, unsigned, bool);
+
+static unsigned reversed_bits(unsigned x, unsigned bits) {
+  unsigned y = 0;
+  for (unsigned i = 0; i < bits; i++) {
+    y = (y << 1) | (x & 1);
+    x >>= 1;
+  }
+  return y;
+}
+
+/**
+ * \brief  index tagged in lane k of the points of a step
+ */
+static unsigned lane(const float2x8 &data, unsigned k) {
+  const float2 lanes[8] = {data.i0, data.i1, data.i2, data.i3, data.i4, data.i5, data.i6, data.i7};
+  return (unsigned)lanes[k].x;
+}
+
+/**
+ * \brief  Checks that a sequence stored in bit-reversed order and fetched
+ *         with bitrev_input reaches the FFT engine in the order of the same
+ *         sequence stored in natural order and fetched by bitreverse_fetch
+ */
+static void check_unordered_fetch(fetch_fn fetch, fetch_order_fn fetch_order, unsigned logN) {
+  const unsigned N = 1 << logN, STEPS = N / 8;
+  std::vector<float2> natural(N), reversed(N), scratch(N);
+  for (unsigned m = 0; m < N; m++) {
+    natural[m] = float2{(float)m, 0.0f};
+    reversed[m] = float2{(float)reversed_bits(m, logN), 0.0f};
+  }
+
+  const float2x8 zero = {};
+  for (unsigned c = 0; c < STEPS; c++) {
+    float2x8 ref = fetch(zero, scratch.data(), natural.data(), c);
+    float2x8 same = fetch_order(zero, scratch.data(), natural.data(), c, false);
+    float2x8 res = fetch_order(zero, scratch.data(), reversed.data(), c, true);
+    for (unsigned k = 0; k < 8; k++) {
+      EXPECT_EQ(lane(same, k), lane(ref, k)) << "logN " << logN << " step " << c << " lane " << k;
+      EXPECT_EQ(lane(res, k), lane(ref, k)) << "logN " << logN << " step " << c << " lane " << k;
+    }
+  }
+}
+
+/**
+ * \brief bitreverse_fetch_order() of the unordered mode
+ */
+TEST(diagonalBitrevTest, UnorderedFetch){
+  check_unordered_fetch(logn6::bitreverse_fetch, logn6::bitreverse_fetch_order, 6);
+  check_unordered_fetch(logn8::bitreverse_fetch, logn8::bitreverse_fetch_order, 8);
+}
+
+/**
+ * \brief  Checks that bitreverse_in_order without reorder passes the points
+ *         through in the order they arrive
+ */
+static void check_in_passthrough(fetch_order_fn in_order, unsigned logN) {
+  const unsigned N = 1 << logN, STEPS = N / 8;
+  std::vector<float2> prev(N), scratch(N);
+  for (unsigned m = 0; m < N; m++)
+    prev[m] = float2{(float)m, 0.0f};
+
+  const float2x8 zero = {};
+  for (unsigned c = 0; c < STEPS; c++) {
+    float2x8 res = in_order(zero, scratch.data(), prev.data(), c, false);
+    for (unsigned k = 0; k < 8; k++)
+      EXPECT_EQ(lane(res, k), c * 8 + k) << "logN " << logN << " step " << c << " lane " << k;
+  }
+}
+
+/**
+ * \brief bitreverse_in_order() of the unordered mode
+ */
+TEST(diagonalBitrevTest, UnorderedPassthrough){
+  check_in_passthrough(logn6::bitreverse_in_order, 6);
+  check_in_passthrough(logn8::bitreverse_in_order, 8);
+}
+
+typedef float2x8 (*in_fn)(float2x8, float2 *, float2 *, unsigned);
+
+/**
+ * \brief  Streams how_many transforms in the bit-reversed output order of the
+ *         FFT engine through bitreverse_in, swapping its buffers every
+ *         transform, and checks that they come out in natural order delayed
+ *         by N / 8 steps
+ */
+static void check_natural_order(in_fn bitreverse_in, unsigned logN) {
+  const unsigned N = 1 << logN, STEPS = N / 8;
+  const unsigned how_many = 3;
+  std::vector<float2> bufs[2] = {std::vector<float2>(N), std::vector<float2>(N)};
+
+  for (unsigned row = 0; row < (how_many + 1) * STEPS; row++) {
+    const unsigned t = row / STEPS, c = row % STEPS;
+    float2 in[8];
+    for (unsigned k = 0; k < 8; k++)
+      in[k] = float2{(float)(t * N + reversed_bits(c * 8 + k, logN)), 0.0f};
+    const float2x8 data = {in[0], in[1], in[2], in[3], in[4], in[5], in[6], in[7]};
+
+    float2x8 res = bitreverse_in(data, bufs[t & 1].data(), bufs[(t + 1) & 1].data(), row);
+    if (t == 0)
+      continue;
+    for (unsigned k = 0; k < 8; k++)
+      EXPECT_EQ(lane(res, k), (t - 1) * N + c * 8 + k) << "logN " << logN << " step " << row << " lane " << k;
+  }
+}
+
+/**
+ * \brief bitreverse_in() reordering the output of the FFT engine to natural order
+ */
+TEST(diagonalBitrevTest, NaturalOrder){
+  check_natural_order(logn6::bitreverse_in, 6);
+  check_natural_order(logn8::bitreverse_in, 8);
+}
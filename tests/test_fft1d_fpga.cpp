@@ -67,4 +67,92 @@ TEST(fft1dFPGATest, InputValiditySVM){
   free(test);
 
   fpga_final();
-}
\ No newline at end of file
+}
+
+/**
+ * \brief fftfpgaf_c2c_1d_axis()
+ */
+TEST(fft1dFPGATest, InputValidityAxis){
+  const unsigned dims[3] = {(1 << 6), 8, 16};
+  const size_t sz = sizeof(float2) * dims[0] * dims[1] * dims[2];
+
+  float2 *test = (float2*)malloc(sz);
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0};
+
+  // null inp ptr input
+  fft_time = fftfpgaf_c2c_1d_axis(dims, 0, NULL, test, false);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // null out ptr input
+  fft_time = fftfpgaf_c2c_1d_axis(dims, 0, test, NULL, false);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // axis out of range
+  fft_time = fftfpgaf_c2c_1d_axis(dims, 3, test, test, false);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // size along the axis not a power of 2
+  const unsigned odd[3] = {(1 << 6), 12, 16};
+  fft_time = fftfpgaf_c2c_1d_axis(odd, 1, test, test, false);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // size along the axis smaller than 8 points
+  const unsigned small[3] = {(1 << 6), 8, 4};
+  fft_time = fftfpgaf_c2c_1d_axis(small, 2, test, test, false);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // null buffer handles
+  fft_time = fftfpgaf_c2c_1d_axis_dev(dims, 1, NULL, NULL, false, false);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  free(test);
+}
+
+/**
+ * \brief fftfpgaf_bit_reverse()
+ */
+TEST(fft1dFPGATest, BitReverse){
+  const unsigned how_many = 3;
+
+  float2 *test = (float2*)malloc(sizeof(float2) * 8);
+
+  // null ptr inputs
+  EXPECT_EQ(fftfpgaf_bit_reverse(8, 1, NULL, test), -1);
+  EXPECT_EQ(fftfpgaf_bit_reverse(8, 1, test, NULL), -1);
+
+  // in place
+  EXPECT_EQ(fftfpgaf_bit_reverse(8, 1, test, test), -1);
+
+  // if N not a power of 2
+  EXPECT_EQ(fftfpgaf_bit_reverse(6, 1, test, test + 1), -1);
+  free(test);
+
+  // lines below and above the size of the tiles
+  for(unsigned logN = 3; logN <= 14; logN += 11){
+    const unsigned N = (1 << logN);
+    const size_t num_pts = (size_t)N * how_many;
+    float2 *inp = (float2*)malloc(sizeof(float2) * num_pts);
+    float2 *out = (float2*)malloc(sizeof(float2) * num_pts);
+
+    for(size_t i = 0; i < num_pts; i++){
+      inp[i].x = (float)i;
+      inp[i].y = -(float)i;
+    }
+
+    EXPECT_EQ(fftfpgaf_bit_reverse(N, how_many, inp, out), 0);
+
+    for(size_t j = 0; j < how_many; j++){
+      for(unsigned i = 0; i < N; i++){
+        unsigned rev = 0;
+        for(unsigned b = 0; b < logN; b++){
+          rev |= ((i >> b) & 1) << (logN - 1 - b);
+        }
+        EXPECT_EQ(out[(j * N) + i].x, inp[(j * N) + rev].x);
+        EXPECT_EQ(out[(j * N) + i].y, inp[(j * N) + rev].y);
+      }
+    }
+
+    free(inp);
+    free(out);
+  }
+}
@@ -36,6 +36,39 @@ TEST(fft2dFPGATest, InputValidityBRAM){
   free(test);
 }
 
+/**
+ * \brief fftfpgaf_c2c_2d_bram_many()
+ */
+TEST(fft2dFPGATest, InputValidityBRAMMany){
+  const unsigned N = 64, how_many = 2;
+
+  size_t sz = sizeof(float2) * how_many * N * N;
+  float2 *test = (float2*)malloc(sz);
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0};
+
+  // null inp ptr input
+  fft_time = fftfpgaf_c2c_2d_bram_many(N, NULL, 1, N * N, test, 1, N * N, 0, 0, how_many);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // null out ptr input
+  fft_time = fftfpgaf_c2c_2d_bram_many(N, test, 1, N * N, NULL, 1, N * N, 0, 0, how_many);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // zero stride
+  fft_time = fftfpgaf_c2c_2d_bram_many(N, test, 0, N * N, test, 1, N * N, 0, 0, how_many);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // overlapping transforms
+  fft_time = fftfpgaf_c2c_2d_bram_many(N, test, 1, N * N, test, 1, N, 0, 0, how_many);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // interleaved transforms, points not contiguous
+  fft_time = fftfpgaf_c2c_2d_bram_many(N, test, how_many, 1, test, 1, N * N, 0, 0, how_many);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  free(test);
+}
+
 /**
  * \brief fftfpgaf_c2c_2d_ddr()
  */
@@ -60,6 +60,44 @@ TEST(fft3dFPGATest, InputValidityDDR){
   free(test);
 }
 
+/**
+ * \brief fftfpgaf_c2c_3d_ddr_pruned()
+ */
+TEST(fft3dFPGATest, InputValidityPruned){
+  const unsigned N = 64;
+  const size_t sz = sizeof(float2) * N * N * N;
+
+  float2 *test = (float2*)malloc(sz);
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0};
+  const unsigned box[3] = {32, 32, 32}, origin[3] = {0, 0, 0};
+
+  // null inp ptr input
+  fft_time = fftfpgaf_c2c_3d_ddr_pruned(N, box, origin, NULL, test, 0);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // null out ptr input
+  fft_time = fftfpgaf_c2c_3d_ddr_pruned(N, box, origin, test, NULL, 0);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // if N not a power of 2
+  fft_time = fftfpgaf_c2c_3d_ddr_pruned(63, box, origin, test, test, 0);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // sub-box larger than the cube
+  const unsigned large[3] = {32, 128, 32};
+  fft_time = fftfpgaf_c2c_3d_ddr_pruned(N, large, origin, test, test, 0);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // size and origin along x not multiples of 8
+  const unsigned odd[3] = {30, 32, 32}, shifted[3] = {4, 0, 0};
+  fft_time = fftfpgaf_c2c_3d_ddr_pruned(N, odd, origin, test, test, 0);
+  EXPECT_EQ(fft_time.valid, 0);
+  fft_time = fftfpgaf_c2c_3d_ddr_pruned(N, box, shifted, test, test, 0);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  free(test);
+}
+
 /**
  * \brief fftfpgaf_c2c_3d_ddr_svm_batch()
  */
@@ -92,3 +130,207 @@ TEST(fft3dFPGATest, InputValidityDDRSVMBatch){
 
   free(test);
 }
+
+/**
+ * \brief fftfpgaf_c2c_3d_ddr_batch_many()
+ */
+TEST(fft3dFPGATest, InputValidityDDRBatchMany){
+  const unsigned N = 64, how_many = 2;
+  const size_t num_pts = N * N * N;
+
+  float2 *test = (float2*)malloc(sizeof(float2) * num_pts * how_many);
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0};
+
+  // null inp ptr input
+  fft_time = fftfpgaf_c2c_3d_ddr_batch_many(N, NULL, 1, num_pts, test, 1, num_pts, 0, 0, how_many);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // null out ptr input
+  fft_time = fftfpgaf_c2c_3d_ddr_batch_many(N, test, 1, num_pts, NULL, 1, num_pts, 0, 0, how_many);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // overlapping interleaved transforms
+  fft_time = fftfpgaf_c2c_3d_ddr_batch_many(N, test, 1, 1, test, 1, num_pts, 0, 0, how_many);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // interleaved transforms, points not contiguous
+  fft_time = fftfpgaf_c2c_3d_ddr_batch_many(N, test, how_many, 1, test, 1, num_pts, 0, 0, how_many);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  free(test);
+}
+
+/**
+ * \brief fftfpgaf_c2c_3d_hybrid()
+ */
+TEST(fft3dFPGATest, InputValidityHybrid){
+  const unsigned N = 64;
+  const size_t sz = sizeof(float2) * N * N * N;
+
+  float2 *test = (float2*)malloc(sz);
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0};
+
+  // null inp ptr input
+  fft_time = fftfpgaf_c2c_3d_hybrid(64, NULL, test, 0, 0);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // null out ptr input
+  fft_time = fftfpgaf_c2c_3d_hybrid(64, test, NULL, 0, 0);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // if N not a power of 2
+  fft_time = fftfpgaf_c2c_3d_hybrid(63, test, test, 0, 0);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // N too small to be split into bands of planes
+  fft_time = fftfpgaf_c2c_3d_hybrid(4, test, test, 0, 0);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  free(test);
+}
+
+/**
+ * \brief fftfpgaf_conv3d_set_kernel() and fftfpgaf_c2c_3d_conv()
+ */
+TEST(fft3dFPGATest, InputValidityConv){
+  const unsigned N = 64;
+  const size_t sz = sizeof(float2) * N * N * N;
+
+  float2 *test = (float2*)malloc(sz);
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0};
+
+  // null kernel array
+  EXPECT_EQ(fftfpgaf_conv3d_set_kernel(N, NULL), -1);
+
+  // if N not a power of 2
+  EXPECT_EQ(fftfpgaf_conv3d_set_kernel(63, test), -1);
+
+  // null inp ptr input
+  fft_time = fftfpgaf_c2c_3d_conv(N, NULL, test);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // null out ptr input
+  fft_time = fftfpgaf_c2c_3d_conv(N, test, NULL);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // no kernel array set
+  fft_time = fftfpgaf_c2c_3d_conv(N, test, test);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  free(test);
+}
+
+/**
+ * \brief fftfpgaf_c2c_3d_ddr_region()
+ */
+TEST(fft3dFPGATest, InputValidityRegion){
+  const unsigned N = 64;
+  const size_t sz = sizeof(float2) * N * N * N;
+
+  float2 *test = (float2*)malloc(sz);
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0};
+  const unsigned box[3] = {16, 16, 16}, origin[3] = {56, 56, 56}, ld[2] = {N, N};
+
+  // null inp ptr input
+  fft_time = fftfpgaf_c2c_3d_ddr_region(N, NULL, 0, box, origin, test, ld);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // null out ptr input
+  fft_time = fftfpgaf_c2c_3d_ddr_region(N, test, 0, box, origin, NULL, ld);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // if N not a power of 2
+  fft_time = fftfpgaf_c2c_3d_ddr_region(63, test, 0, box, origin, test, ld);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // origin outside of the cube
+  const unsigned outside[3] = {0, 64, 0};
+  fft_time = fftfpgaf_c2c_3d_ddr_region(N, test, 0, box, outside, test, ld);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // rows of the host array shorter than the sub-box
+  const unsigned narrow[2] = {8, N};
+  fft_time = fftfpgaf_c2c_3d_ddr_region(N, test, 0, box, origin, test, narrow);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  free(test);
+}
+
+/**
+ * \brief fftfpgaf_buffer_alloc() and fftfpgaf_c2c_3d_ddr_dev()
+ */
+TEST(fft3dFPGATest, InputValidityDevice){
+  const unsigned N = 64;
+  const size_t sz = sizeof(float2) * N * N * N;
+
+  float2 *test = (float2*)malloc(sz);
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0};
+
+  // no bitstream loaded
+  EXPECT_TRUE(fftfpgaf_buffer_alloc(N * N * N, 0) == NULL);
+
+  // null buffer handles
+  fft_time = fftfpgaf_buffer_upload(NULL, test, N * N * N);
+  EXPECT_EQ(fft_time.valid, 0);
+  fft_time = fftfpgaf_buffer_download(NULL, test, N * N * N);
+  EXPECT_EQ(fft_time.valid, 0);
+  const unsigned box[3] = {N, N, N}, origin[3] = {0, 0, 0}, ld[2] = {N, N};
+  fft_time = fftfpgaf_buffer_download_region(NULL, N, box, origin, test, ld);
+  EXPECT_EQ(fft_time.valid, 0);
+  fft_time = fftfpgaf_c2c_3d_ddr_dev(N, NULL, NULL, 0, 0, 0);
+  EXPECT_EQ(fft_time.valid, 0);
+  fft_time = fftfpgaf_c2c_3d_conv_dev(N, NULL, NULL);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // freeing a null handle is a no-op
+  fftfpgaf_buffer_free(NULL);
+
+  free(test);
+}
+
+/**
+ * \brief fftfpgaf_gradient_3d()
+ */
+TEST(fft3dFPGATest, InputValidityGradient){
+  const unsigned N = 64;
+  const size_t sz = sizeof(float2) * N * N * N;
+
+  float2 *test = (float2*)malloc(sz);
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0};
+
+  // null inp ptr input
+  fft_time = fftfpgaf_gradient_3d(N, NULL, test, test, test, 1.0);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // null out ptr input
+  fft_time = fftfpgaf_gradient_3d(N, test, test, NULL, test, 1.0);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // if N not a power of 2
+  fft_time = fftfpgaf_gradient_3d(63, test, test, test, test, 1.0);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // box length not positive
+  fft_time = fftfpgaf_gradient_3d(N, test, test, test, test, 0.0);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  free(test);
+}
+
+/**
+ * \brief fftfpgaf_transpose3d_bench()
+ */
+TEST(fft3dFPGATest, InputValidityTransposeBench){
+  const unsigned N = 64;
+  double write_t = 0.0, read_t = 0.0;
+
+  // null time ptrs
+  EXPECT_EQ(fftfpgaf_transpose3d_bench(N, 0, NULL, &read_t), -1);
+  EXPECT_EQ(fftfpgaf_transpose3d_bench(N, 0, &write_t, NULL), -1);
+
+  // if N not a power of 2
+  EXPECT_EQ(fftfpgaf_transpose3d_bench(63, 0, &write_t, &read_t), -1);
+
+  // blocks larger than the transform
+  EXPECT_EQ(fftfpgaf_transpose3d_bench(N, 7, &write_t, &read_t), -1);
+}
@@ -0,0 +1,131 @@
+//  Author: Arjun Ramaswami
+
+#include <iostream>
+#include <stdlib.h>
+#include <math.h>
+#include <fftw3.h>
+
+#include "gtest/gtest.h" 
+extern "C" {
+  #include "CL/opencl.h"
+  #include "fftfpga/fftfpga.h"
+}
+
+/**
+ * \brief fftfpgaf_c2c()
+ */
+TEST(fftDispatchTest, InputValidity){
+  const unsigned N = 64;
+
+  size_t sz = sizeof(float2) * N * N;
+  float2 *test = (float2*)malloc(sz);
+  fpga_t fft_time = {0.0, 0.0, 0.0, 0};
+
+  // null inp ptr input
+  fft_time = fftfpgaf_c2c(2, N, NULL, test, 0, 1);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // null out ptr input
+  fft_time = fftfpgaf_c2c(2, N, test, NULL, 0, 1);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // if N not a power of 2
+  fft_time = fftfpgaf_c2c(2, 63, test, test, 0, 1);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // unsupported dimensions
+  fft_time = fftfpgaf_c2c(0, N, test, test, 0, 1);
+  EXPECT_EQ(fft_time.valid, 0);
+  fft_time = fftfpgaf_c2c(4, N, test, test, 0, 1);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  // how_many is 0
+  fft_time = fftfpgaf_c2c(2, N, test, test, 0, 0);
+  EXPECT_EQ(fft_time.valid, 0);
+
+  free(test);
+}
+
+/**
+ * \brief fftfpgaf_c2c() computes on the CPU when no bitstream is loaded
+ */
+TEST(fftDispatchTest, CPUFallback){
+  const unsigned N = 16, how_many = 2;
+  const unsigned num_pts = how_many * N * N;
+
+  float2 *inp = (float2*)fftfpgaf_complex_malloc(sizeof(float2) * num_pts);
+  float2 *out = (float2*)fftfpgaf_complex_malloc(sizeof(float2) * num_pts);
+  fftwf_complex *ref = fftwf_alloc_complex(num_pts);
+
+  for(unsigned i = 0; i < num_pts; i++){
+    inp[i].x = ref[i][0] = (float)rand() / (float)RAND_MAX;
+    inp[i].y = ref[i][1] = (float)rand() / (float)RAND_MAX;
+  }
+
+  fpga_t fft_time = fftfpgaf_c2c(2, N, inp, out, 0, how_many);
+  EXPECT_EQ(fft_time.valid, 1);
+  EXPECT_EQ(fft_time.exec_t, 0.0);
+
+  int n[2] = {(int)N, (int)N};
+  fftwf_plan plan = fftwf_plan_many_dft(2, n, how_many, ref, NULL, 1, N * N, ref, NULL, 1, N * N, FFTW_FORWARD, FFTW_ESTIMATE);
+  fftwf_execute(plan);
+
+  for(unsigned i = 0; i < num_pts; i++){
+    EXPECT_NEAR(out[i].x, ref[i][0], 1e-3);
+    EXPECT_NEAR(out[i].y, ref[i][1], 1e-3);
+  }
+
+  fftwf_destroy_plan(plan);
+  fftwf_free(ref);
+  free(inp);
+  free(out);
+}
+
+/**
+ * \brief fftfpgaf_c2c() transforms in place once on the first call of a configuration
+ */
+TEST(fftDispatchTest, InPlaceFirstCall){
+  const unsigned N = 32;
+  const unsigned num_pts = N * N;
+
+  float2 *data = (float2*)fftfpgaf_complex_malloc(sizeof(float2) * num_pts);
+  fftwf_complex *ref = fftwf_alloc_complex(num_pts);
+
+  for(unsigned i = 0; i < num_pts; i++){
+    data[i].x = ref[i][0] = (float)rand() / (float)RAND_MAX;
+    data[i].y = ref[i][1] = (float)rand() / (float)RAND_MAX;
+  }
+
+  fpga_t fft_time = fftfpgaf_c2c(2, N, data, data, 0, 1);
+  EXPECT_EQ(fft_time.valid, 1);
+
+  fftwf_plan plan = fftwf_plan_dft_2d(N, N, ref, ref, FFTW_FORWARD, FFTW_ESTIMATE);
+  fftwf_execute(plan);
+
+  for(unsigned i = 0; i < num_pts; i++){
+    EXPECT_NEAR(data[i].x, ref[i][0], 1e-3);
+    EXPECT_NEAR(data[i].y, ref[i][1], 1e-3);
+  }
+
+  fftwf_destroy_plan(plan);
+  fftwf_free(ref);
+  free(data);
+}
+
+/**
+ * \brief fftfpgaf_predict()
+ */
+TEST(fftDispatchTest, PredictValidity){
+  // unsupported dimensions
+  EXPECT_LT(fftfpgaf_predict(0, 64, 1), 0.0);
+  EXPECT_LT(fftfpgaf_predict(4, 64, 1), 0.0);
+
+  // if N not a power of 2
+  EXPECT_LT(fftfpgaf_predict(3, 63, 1), 0.0);
+
+  // how_many is 0
+  EXPECT_LT(fftfpgaf_predict(3, 64, 0), 0.0);
+
+  // no bitstream loaded
+  EXPECT_LT(fftfpgaf_predict(3, 64, 1), 0.0);
+}
@@ -0,0 +1,162 @@
+//  Author: Arjun Ramaswami
+
+#include "gtest/gtest.h"  // finds this because gtest is linked
+#include <cmath>
+#include <complex>
+#include <cstdlib>
+#include <vector>
+
+/**
+ * Host simulation of the FFT engines of kernels/common/fft_points.cl. The
+ * engine is compiled as C++ with the OpenCL types it uses emulated below,
+ * once for each number of points per cycle, and stepped as the fft1d kernel
+ * does against a reference DFT.
+ */
+struct float2 {
+  float x, y;
+};
+
+inline float2 operator+(float2 a, float2 b) { return {a.x + b.x, a.y + b.y}; }
+inline float2 operator-(float2 a, float2 b) { return {a.x - b.x, a.y - b.y}; }
+
+#define constant const
+#define M_PI_F ((float)M_PI)
+
+namespace points8 {
+#define LOGPOINTS 3
+#define POINTS 8
+#include "fft_points.cl"
+#undef POINTS
+#undef LOGPOINTS
+}
+
+namespace points16 {
+#define LOGPOINTS 4
+#define POINTS 16
+#include "fft_points.cl"
+#undef POINTS
+#undef LOGPOINTS
+}
+
+namespace points32 {
+#define LOGPOINTS 5
+#define POINTS 32
+#include "fft_points.cl"
+#undef POINTS
+#undef LOGPOINTS
+}
+
+#undef constant
+
+typedef std::complex<double> cplx;
+
+static unsigned bit_reversed(unsigned x, unsigned bits) {
+  unsigned y = 0;
+  for (unsigned i = 0; i < bits; i++) {
+    y = (y << 1) | (x & 1);
+    x >>= 1;
+  }
+  return y;
+}
+
+/**
+ * \brief  DFT of each of the how_many transforms of N points in inp
+ * \param  sign: -1 for the forward transform, 1 for the inverse
+ */
+static std::vector<cplx> reference_dft(const std::vector<cplx> &inp, unsigned logN, unsigned how_many, int sign) {
+  const unsigned N = 1 << logN;
+  std::vector<cplx> roots(N), out(inp.size());
+  for (unsigned k = 0; k < N; k++)
+    roots[k] = std::polar(1.0, sign * 2.0 * M_PI * k / N);
+
+  for (unsigned t = 0; t < how_many; t++) {
+    for (unsigned f = 0; f < N; f++) {
+      cplx acc = 0;
+      for (unsigned n = 0; n < N; n++)
+        acc += inp[t * N + n] * roots[((size_t)f * n) & (N - 1)];
+      out[t * N + f] = acc;
+    }
+  }
+  return out;
+}
+
+/**
+ * \brief  Streams how_many transforms through the engine as the fft1d kernel
+ *         does and returns the relative error of the outputs against the DFT
+ * \tparam Vec : float2xp of the engine
+ * \param  step_fn : fft_step_points of the engine
+ */
+template <typename Vec, unsigned LOGP>
+static double engine_error(Vec (*step_fn)(Vec, int, float2 *, bool, const int), unsigned logN, bool inverse) {
+  const unsigned P = 1 << LOGP, N = 1 << logN, STEPS = N / P;
+  const unsigned how_many = 2;
+
+  std::vector<cplx> inp(how_many * N), out(how_many * N);
+  for (cplx &v : inp)
+    v = cplx((double)rand() / RAND_MAX - 0.5, (double)rand() / RAND_MAX - 0.5);
+
+  // sliding window of the engine, zero as the registers of the kernel
+  std::vector<float2> delay_elements(N + P * (logN - 2), float2{0.0f, 0.0f});
+
+  // the outputs of a step are delayed by N / POINTS - 1 steps
+  for (unsigned i = 0; i < how_many * STEPS + STEPS - 1; i++) {
+    Vec data;
+    unsigned t = i / STEPS, s = i % STEPS;
+    for (unsigned k = 0; k < P; k++) {
+      if (i < how_many * STEPS) {
+        cplx v = inp[t * N + bit_reversed(k, LOGP) * STEPS + s];
+        data.i[k] = float2{(float)v.real(), (float)v.imag()};
+      } else {
+        data.i[k] = float2{0.0f, 0.0f};
+      }
+    }
+
+    data = step_fn(data, i % STEPS, delay_elements.data(), inverse, logN);
+
+    if (i >= STEPS - 1) {
+      unsigned o = i - (STEPS - 1);
+      for (unsigned k = 0; k < P; k++) {
+        unsigned pos = o * P + k;
+        out[(pos / N) * N + bit_reversed(pos % N, logN)] = cplx(data.i[k].x, data.i[k].y);
+      }
+    }
+  }
+
+  std::vector<cplx> ref = reference_dft(inp, logN, how_many, inverse ? 1 : -1);
+  double err = 0.0, mag = 0.0;
+  for (size_t i = 0; i < ref.size(); i++) {
+    err += std::norm(ref[i] - out[i]);
+    mag += std::norm(ref[i]);
+  }
+  return std::sqrt(err / mag);
+}
+
+/**
+ * \brief fft_step_points() for 8 points per cycle, wrapping fft_8.cl
+ */
+TEST(fftPointsTest, Engine8Points){
+  for (unsigned logN = 6; logN <= 12; logN++) {
+    EXPECT_LT((engine_error<points8::float2xp, 3>(points8::fft_step_points, logN, false)), 1e-5) << "logN " << logN;
+    EXPECT_LT((engine_error<points8::float2xp, 3>(points8::fft_step_points, logN, true)), 1e-5) << "logN " << logN;
+  }
+}
+
+/**
+ * \brief fft_step_points() for 16 points per cycle
+ */
+TEST(fftPointsTest, Engine16Points){
+  for (unsigned logN = 8; logN <= 12; logN++) {
+    EXPECT_LT((engine_error<points16::float2xp, 4>(points16::fft_step_points, logN, false)), 1e-5) << "logN " << logN;
+    EXPECT_LT((engine_error<points16::float2xp, 4>(points16::fft_step_points, logN, true)), 1e-5) << "logN " << logN;
+  }
+}
+
+/**
+ * \brief fft_step_points() for 32 points per cycle
+ */
+TEST(fftPointsTest, Engine32Points){
+  for (unsigned logN = 10; logN <= 12; logN++) {
+    EXPECT_LT((engine_error<points32::float2xp, 5>(points32::fft_step_points, logN, false)), 1e-5) << "logN " << logN;
+    EXPECT_LT((engine_error<points32::float2xp, 5>(points32::fft_step_points, logN, true)), 1e-5) << "logN " << logN;
+  }
+}
@@ -44,4 +44,17 @@ TEST(fftFPGASetupTest, ValidDpMalloc){
 TEST(fftFPGASetupTest, ValidSpMalloc){
   // request zero size
   EXPECT_EQ(fftfpgaf_complex_malloc(0), nullptr);
-}
\ No newline at end of file
+}
+
+/**
+ * \brief fftfpga_export_wisdom() and fftfpga_import_wisdom()
+ */
+TEST(fftFPGASetupTest, ValidWisdom){
+  // no filename
+  EXPECT_EQ(fftfpga_export_wisdom(NULL), -1);
+  EXPECT_EQ(fftfpga_import_wisdom(NULL), -1);
+
+  // no bitstream loaded
+  EXPECT_EQ(fftfpga_export_wisdom("fftfpga.wisdom"), -1);
+  EXPECT_EQ(fftfpga_import_wisdom("fftfpga.wisdom"), -1);
+}
@@ -0,0 +1,161 @@
+//  Author: Arjun Ramaswami
+
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fftw3.h>
+
+#include "gtest/gtest.h"
+
+/**
+ * The fftw3f_fpga shim precedes libfftw3f in the lookup order of this test,
+ * so that the single precision calls below are routed through it exactly as
+ * in an application. The double precision functions of FFTW are not
+ * intercepted and compute the reference.
+ */
+
+/**
+ * \brief  point the shim at the emulated bitstream, read on its first plan
+ */
+static void use_emulated_fpga(){
+  setenv("FFTFPGA_PLATFORM", "Intel(R) FPGA Emulation Platform for OpenCL(TM)", 0);
+  setenv("FFTFPGA_BITSTREAM", "p520_hpc_sg280l/emulation/fft3d_bram_64_nointer/fft3d_bram.aocx", 0);
+  setenv("FFTFPGA_BACKEND", "fpga", 0);
+}
+
+/**
+ * \brief  fill the len points of an array with random values
+ */
+static void fill_random(fftwf_complex *data, const size_t len){
+  for(size_t i = 0; i < len; i++){
+    data[i][0] = (float)rand() / RAND_MAX - 0.5f;
+    data[i][1] = (float)rand() / RAND_MAX - 0.5f;
+  }
+}
+
+/**
+ * \brief  relative error of out against the transform of inp computed by FFTW in double precision
+ * \param  len : number of points spanned by the arrays, points outside the transforms are expected to be zero in out
+ */
+static double error_vs_fftw(const int rank, const int *n, const int howmany, const fftwf_complex *inp, const int stride, const int dist, const fftwf_complex *out, const size_t len, const int sign){
+  fftw_complex *ref_in = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * len);
+  fftw_complex *ref_out = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * len);
+  memset(ref_out, 0, sizeof(fftw_complex) * len);
+
+  fftw_plan plan = fftw_plan_many_dft(rank, n, howmany, ref_in, NULL, stride, dist, ref_out, NULL, stride, dist, sign, FFTW_ESTIMATE);
+  for(size_t i = 0; i < len; i++){
+    ref_in[i][0] = inp[i][0];
+    ref_in[i][1] = inp[i][1];
+  }
+  fftw_execute(plan);
+  fftw_destroy_plan(plan);
+
+  double mag_sum = 0.0, noise_sum = 0.0;
+  for(size_t i = 0; i < len; i++){
+    const double dx = ref_out[i][0] - out[i][0];
+    const double dy = ref_out[i][1] - out[i][1];
+    mag_sum += ref_out[i][0] * ref_out[i][0] + ref_out[i][1] * ref_out[i][1];
+    noise_sum += dx * dx + dy * dy;
+  }
+
+  fftw_free(ref_in);
+  fftw_free(ref_out);
+  return sqrt(noise_sum / mag_sum);
+}
+
+/**
+ * \brief fftwf_plan_dft_3d() and fftwf_plan_many_dft() of cubic power of 2 transforms, offloaded to the FPGA
+ */
+TEST(fftw3fFPGATest, Offloaded){
+  use_emulated_fpga();
+  const int N = 64, howmany = 2;
+  const int n[3] = {N, N, N};
+  const size_t sz = (size_t)N * N * N;
+
+  fftwf_complex *inp = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * sz * howmany);
+  fftwf_complex *out = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * sz * howmany);
+  fftwf_complex *inp2 = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * sz);
+  fftwf_complex *out2 = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * sz);
+
+  fftwf_plan plan = fftwf_plan_dft_3d(N, N, N, inp, out, FFTW_FORWARD, FFTW_ESTIMATE);
+  ASSERT_NE(plan, nullptr);
+
+  fill_random(inp, sz);
+  fftwf_execute(plan);
+  EXPECT_LT(error_vs_fftw(3, n, 1, inp, 1, 0, out, sz, FFTW_FORWARD), 1e-5);
+
+  // new arrays of the same layout
+  fill_random(inp2, sz);
+  fftwf_execute_dft(plan, inp2, out2);
+  EXPECT_LT(error_vs_fftw(3, n, 1, inp2, 1, 0, out2, sz, FFTW_FORWARD), 1e-5);
+  fftwf_destroy_plan(plan);
+
+  // contiguous batch of backward transforms
+  plan = fftwf_plan_many_dft(3, n, howmany, inp, NULL, 1, sz, out, NULL, 1, sz, FFTW_BACKWARD, FFTW_ESTIMATE);
+  ASSERT_NE(plan, nullptr);
+
+  fill_random(inp, sz * howmany);
+  fftwf_execute(plan);
+  EXPECT_LT(error_vs_fftw(3, n, howmany, inp, 1, sz, out, sz * howmany, FFTW_BACKWARD), 1e-5);
+  fftwf_destroy_plan(plan);
+
+  fftwf_free(inp);
+  fftwf_free(out);
+  fftwf_free(inp2);
+  fftwf_free(out2);
+}
+
+/**
+ * \brief fftwf_plan_dft_3d() and fftwf_plan_many_dft() of shapes the FPGA does not compute, forwarded to FFTW
+ */
+TEST(fftw3fFPGATest, Forwarded){
+  use_emulated_fpga();
+
+  // size not a power of 2
+  const int M = 12;
+  const int m[3] = {M, M, M};
+  const size_t msz = (size_t)M * M * M;
+
+  fftwf_complex *inp = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * msz);
+  fftwf_complex *out = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * msz);
+
+  fftwf_plan plan = fftwf_plan_dft_3d(M, M, M, inp, out, FFTW_FORWARD, FFTW_ESTIMATE);
+  ASSERT_NE(plan, nullptr);
+
+  fill_random(inp, msz);
+  fftwf_execute(plan);
+  EXPECT_LT(error_vs_fftw(3, m, 1, inp, 1, 0, out, msz, FFTW_FORWARD), 1e-5);
+  fftwf_destroy_plan(plan);
+
+  fftwf_free(inp);
+  fftwf_free(out);
+
+  // interleaved batch of 1D transforms
+  const int N = 64, howmany = 4;
+  const int n[1] = {N};
+  const size_t len = (size_t)N * howmany;
+
+  inp = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * len);
+  out = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * len);
+  fftwf_complex *inp2 = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * len);
+  fftwf_complex *out2 = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * len);
+
+  plan = fftwf_plan_many_dft(1, n, howmany, inp, NULL, howmany, 1, out, NULL, howmany, 1, FFTW_BACKWARD, FFTW_ESTIMATE);
+  ASSERT_NE(plan, nullptr);
+
+  fill_random(inp, len);
+  fftwf_execute(plan);
+  EXPECT_LT(error_vs_fftw(1, n, howmany, inp, howmany, 1, out, len, FFTW_BACKWARD), 1e-5);
+
+  // new arrays of the same layout
+  fill_random(inp2, len);
+  fftwf_execute_dft(plan, inp2, out2);
+  EXPECT_LT(error_vs_fftw(1, n, howmany, inp2, howmany, 1, out2, len, FFTW_BACKWARD), 1e-5);
+  fftwf_destroy_plan(plan);
+
+  fftwf_free(inp);
+  fftwf_free(out);
+  fftwf_free(inp2);
+  fftwf_free(out2);
+}
@@ -0,0 +1,83 @@
+//  Author: Arjun Ramaswami
+
+#include "gtest/gtest.h"  // finds this because gtest is linked
+#include <vector>
+
+/**
+ * Host checks of the layouts of the buffer of the 3D Transpose in
+ * kernels/matrixTranspose/transpose3d_layout.cl, which is plain index math
+ * and compiles as C++ unchanged.
+ */
+#include "transpose3d_layout.cl"
+
+/**
+ * \brief transpose3d_index() of the tiled layout
+ */
+TEST(transpose3dLayoutTest, TiledIndex){
+  for (int logN = 3; logN <= 6; logN++) {
+    const unsigned N = 1 << logN;
+    for (int log_tile = 0; log_tile <= logN; log_tile++) {
+      const unsigned tile = 1 << log_tile;
+      std::vector<bool> seen(N * N * N, false);
+
+      for (unsigned z = 0; z < N; z++) {
+        for (unsigned y = 0; y < N; y++) {
+          for (unsigned x = 0; x < N; x++) {
+            const unsigned index = transpose3d_index(z, y, x, logN, log_tile);
+
+            // every point has its own index in the buffer
+            ASSERT_LT(index, N * N * N);
+            EXPECT_FALSE(seen[index]) << "logN " << logN << " log_tile " << log_tile;
+            seen[index] = true;
+
+            // [z / tile][y][z % tile][x]
+            EXPECT_EQ(index, (((z / tile) * N + y) * tile + z % tile) * N + x);
+          }
+        }
+      }
+
+      // a log_tile of 0 is the layout [z][y][x]
+      if (log_tile == 0)
+        EXPECT_EQ(transpose3d_index(N - 1, 1, 2, logN, 0), ((N - 1) * N + 1) * N + 2);
+
+      // the rows along x of the planes of a block are adjacent for each y
+      for (unsigned z = 0; z + 1 < N; z++) {
+        if ((z + 1) % tile != 0)
+          EXPECT_EQ(transpose3d_index(z + 1, 1, 0, logN, log_tile), transpose3d_index(z, 1, 0, logN, log_tile) + N);
+      }
+    }
+  }
+}
+
+/**
+ * \brief transpose3d_bank() and transpose3d_offset() of the striped layout
+ */
+TEST(transpose3dLayoutTest, StripedBanks){
+  const int log_banks = 2;
+  const unsigned banks = 1 << log_banks;
+
+  for (int logN = 3; logN <= 6; logN++) {
+    const unsigned N = 1 << logN;
+    // blocks of the tiled layout, as striped by the fft3d_ddr_striped kernels
+    for (int log_tile = 0; logN - log_tile >= log_banks; log_tile++) {
+      const int log_block = logN + logN + log_tile;
+      const unsigned block = 1 << log_block;
+      std::vector<bool> seen(N * N * N, false);
+
+      for (unsigned index = 0; index < N * N * N; index++) {
+        const unsigned bank = transpose3d_bank(index, log_block, log_banks);
+        const unsigned offset = transpose3d_offset(index, log_block, log_banks);
+
+        // every point has its own place in the buffers of equal size
+        ASSERT_LT(bank, banks);
+        ASSERT_LT(offset, N * N * N / banks);
+        EXPECT_FALSE(seen[bank * (N * N * N / banks) + offset]) << "logN " << logN << " log_tile " << log_tile;
+        seen[bank * (N * N * N / banks) + offset] = true;
+
+        // consecutive blocks go to the banks in turn, contiguous in each
+        EXPECT_EQ(bank, (index / block) % banks);
+        EXPECT_EQ(offset, (index / (block * banks)) * block + index % block);
+      }
+    }
+  }
+}